@@ -6,13 +6,7 @@
 #include "vreg_assignment.h"
 
 namespace mocker {
-namespace {
-
-const std::vector<std::shared_ptr<nasm::Register>> CalleeSave = {
-    nasm::rbp(), nasm::rbx(), nasm::r12(),
-    nasm::r13(), nasm::r14(), nasm::r15()};
 
-// replace "#" with "__"
 std::string renameIdentifier(const std::string &ident) {
   std::string res;
   for (auto ch : ident) {
@@ -25,6 +19,12 @@ std::string renameIdentifier(const std::string &ident) {
   return res;
 }
 
+namespace {
+
+const std::vector<std::shared_ptr<nasm::Register>> CalleeSave = {
+    nasm::rbp(), nasm::rbx(), nasm::r12(),
+    nasm::r13(), nasm::r14(), nasm::r15()};
+
 std::shared_ptr<nasm::LabelAddr>
 makeLabelAddr(const std::shared_ptr<ir::Reg> &reg) {
   return std::make_shared<nasm::LabelAddr>("L" + reg->getIdentifier());
@@ -95,31 +95,31 @@ private:
 namespace {
 
 void genStore(nasm::Section &text, FuncSelectionContext &ctx,
-              const std::shared_ptr<ir::Store> &p) {
+              const ir::Store *p) {
   auto val = ctx.getIrAddr(p->getVal());
   auto irAddr = ir::dyc<ir::Reg>(p->getAddr());
   assert(irAddr);
   if (auto global = ir::dycGlobalReg(irAddr)) {
-    text.emplaceInst<nasm::Mov>(makeLabelAddr(global), val);
+    text.emplaceInst<nasm::Mov>(makeLabelAddr(global), val, p->getWidth());
     return;
   }
-  text.emplaceInst<nasm::Mov>(ctx.buildMemAddr(irAddr), val);
+  text.emplaceInst<nasm::Mov>(ctx.buildMemAddr(irAddr), val, p->getWidth());
 }
 
 void genLoad(nasm::Section &text, FuncSelectionContext &ctx,
-             const std::shared_ptr<ir::Load> &p) {
+             const ir::Load *p) {
   auto dest = ctx.getIrAddr(p->getDest());
   auto irAddr = ir::dyc<ir::Reg>(p->getAddr());
   assert(irAddr);
   if (auto global = ir::dycGlobalReg(p->getAddr())) {
-    text.emplaceInst<nasm::Mov>(dest, makeLabelAddr(global));
+    text.emplaceInst<nasm::Mov>(dest, makeLabelAddr(global), p->getWidth());
     return;
   }
-  text.emplaceInst<nasm::Mov>(dest, ctx.buildMemAddr(irAddr));
+  text.emplaceInst<nasm::Mov>(dest, ctx.buildMemAddr(irAddr), p->getWidth());
 }
 
 void genArithBinary(nasm::Section &text, FuncSelectionContext &ctx,
-                    const std::shared_ptr<ir::ArithBinaryInst> &inst) {
+                    const ir::ArithBinaryInst *inst) {
   if (inst->getOp() == ir::ArithBinaryInst::Mod ||
       inst->getOp() == ir::ArithBinaryInst::Div) {
     auto raxCopy = ctx.newVirtualReg(), rdxCopy = ctx.newVirtualReg();
@@ -188,8 +188,8 @@ void genArithBinary(nasm::Section &text, FuncSelectionContext &ctx,
 }
 
 bool genRelation(nasm::Section &text, FuncSelectionContext &ctx,
-                 const std::shared_ptr<ir::RelationInst> &p,
-                 const std::shared_ptr<ir::IRInst> &nextInst,
+                 const ir::RelationInst *p,
+                 const ir::IRInst *nextInst,
                  std::size_t nextBB) {
   bool skipNext = true;
   while (true) {
@@ -276,7 +276,7 @@ bool genRelation(nasm::Section &text, FuncSelectionContext &ctx,
 }
 
 void genBranch(nasm::Section &text, FuncSelectionContext &ctx,
-               const std::shared_ptr<ir::Branch> &inst, std::size_t nextBB) {
+               const ir::Branch *inst, std::size_t nextBB) {
   auto lhs = ctx.newVirtualReg();
   text.emplaceInst<nasm::Mov>(lhs, ctx.getIrAddr(inst->getCondition()));
   text.emplaceInst<nasm::Cmp>(lhs, std::make_shared<nasm::NumericConstant>(0));
@@ -302,7 +302,7 @@ void genBranch(nasm::Section &text, FuncSelectionContext &ctx,
 }
 
 void genCall(nasm::Section &text, FuncSelectionContext &ctx,
-             const std::shared_ptr<ir::Call> &p) {
+             const ir::Call *p) {
   static const std::vector<std::shared_ptr<nasm::Register>> ParamRegs = {
       nasm::rdi(), nasm::rsi(), nasm::rdx(),
       nasm::rcx(), nasm::r8(),  nasm::r9()};
@@ -330,9 +330,9 @@ void genCall(nasm::Section &text, FuncSelectionContext &ctx,
 }
 
 bool tryCombineMemInst(nasm::Section &text, FuncSelectionContext &ctx,
-                       const std::shared_ptr<ir::ArithBinaryInst> &shl,
-                       const std::shared_ptr<ir::ArithBinaryInst> &add,
-                       const std::shared_ptr<ir::IRInst> &memOp) {
+                       const ir::ArithBinaryInst *shl,
+                       const ir::ArithBinaryInst *add,
+                       const ir::IRInst *memOp) {
   if (shl->getOp() != ir::ArithBinaryInst::Shl)
     return false;
   auto lit = ir::dyc<ir::IntLiteral>(shl->getRhs());
@@ -366,9 +366,11 @@ bool tryCombineMemInst(nasm::Section &text, FuncSelectionContext &ctx,
   auto effectiveAddr = std::make_shared<nasm::MemoryAddr>(
       nasm::dyc<nasm::Register>(base), nasm::dyc<nasm::Register>(pos), 8, 0);
   if (load) {
-    text.emplaceInst<nasm::Mov>(ctx.getIrAddr(load->getDest()), effectiveAddr);
+    text.emplaceInst<nasm::Mov>(ctx.getIrAddr(load->getDest()), effectiveAddr,
+                                load->getWidth());
   } else {
-    text.emplaceInst<nasm::Mov>(effectiveAddr, ctx.getIrAddr(store->getVal()));
+    text.emplaceInst<nasm::Mov>(effectiveAddr, ctx.getIrAddr(store->getVal()),
+                                store->getWidth());
   }
 
   return true;
@@ -383,7 +385,7 @@ ir::InstListIter genInst(nasm::Section &text, FuncSelectionContext &ctx,
                          ir::BasicBlockList::const_iterator curBBIter,
                          ir::BasicBlockList::const_iterator bbIterEnd,
                          ir::InstListIter curInstIter) {
-  auto &inst = *curInstIter;
+  auto inst = *curInstIter;
   auto nextIter = curInstIter;
   ++nextIter;
   auto nextBBIter = curBBIter;
@@ -469,8 +471,8 @@ ir::InstListIter genInst(nasm::Section &text, FuncSelectionContext &ctx,
     return nextIter;
   }
   if (auto p = ir::dyc<ir::Malloc>(inst)) {
-    genCall(text, ctx,
-            std::make_shared<ir::Call>(p->getDest(), "__alloc", p->getSize()));
+    ir::Call call(p->getDest(), "__alloc", p->getSize());
+    genCall(text, ctx, &call);
     return nextIter;
   }
 
@@ -519,12 +521,12 @@ void genFunction(nasm::Section &text, FuncSelectionContext &ctx,
       nasm::rdi(), nasm::rsi(), nasm::rdx(),
       nasm::rcx(), nasm::r8(),  nasm::r9()};
   for (std::size_t i = 0; i < 6 && i < func.getArgs().size(); ++i) {
-    auto reg = std::make_shared<ir::Reg>(std::to_string(i));
+    auto reg = func.getRegTable().at(i);
     ctx.setIrRegAddr(reg, ctx.newVirtualReg(reg->getIdentifier()));
     text.emplaceInst<nasm::Mov>(ctx.getIrAddr(reg), ParamRegs[i]);
   }
   for (std::size_t i = 6; i < func.getArgs().size(); ++i) {
-    auto reg = std::make_shared<ir::Reg>(std::to_string(i));
+    auto reg = func.getRegTable().at(i);
     auto dest = ctx.newVirtualReg(reg->getIdentifier());
     ctx.setIrRegAddr(reg, dest);
     text.emplaceInst<nasm::Mov>(
@@ -533,7 +535,7 @@ void genFunction(nasm::Section &text, FuncSelectionContext &ctx,
 
   ir::RegSet globalVars;
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       if (ir::dyc<ir::Load>(inst))
         continue;
       if (auto p = ir::dyc<ir::Store>(inst)) {
@@ -1,12 +1,18 @@
 #ifndef MOCKER_INSTRUCTION_SELECTION_H
 #define MOCKER_INSTRUCTION_SELECTION_H
 
+#include <string>
+
 #include "ir/module.h"
 #include "nasm/module.h"
 
 namespace mocker {
 
 nasm::Module runInstructionSelection(const ir::Module &irModule);
-}
+
+// The label of a function in the assembly, where "#" is replaced with "__"
+std::string renameIdentifier(const std::string &ident);
+
+} // namespace mocker
 
 #endif // MOCKER_INSTRUCTION_SELECTION_H
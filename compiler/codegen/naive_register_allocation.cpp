@@ -93,8 +93,10 @@ void allocateMov(const std::shared_ptr<nasm::Mov> &p,
       loadVReg(nasm::r11(), reg1, offsets, text);
       reg1 = nasm::r11();
     }
-    text.emplaceInst<nasm::Mov>(nasm::r10(), std::make_shared<nasm::MemoryAddr>(
-                                                 reg1, memAddr->getNumber()));
+    text.emplaceInst<nasm::Mov>(
+        nasm::r10(),
+        std::make_shared<nasm::MemoryAddr>(reg1, memAddr->getNumber()),
+        p->getWidth());
   } else {
     assert(false);
   }
@@ -122,7 +124,7 @@ void allocateMov(const std::shared_ptr<nasm::Mov> &p,
     }
     text.emplaceInst<nasm::Mov>(
         std::make_shared<nasm::MemoryAddr>(nasm::r11(), memAddr->getNumber()),
-        nasm::r10());
+        nasm::r10(), p->getWidth());
     return;
   }
 
@@ -53,6 +53,7 @@ void InterferenceGraph::clearAndInit(const std::vector<Node> &nonPrecolored) {
   edges.clear();
   originalAdjList.clear();
   curDegree.clear();
+  spillCost.clear();
   simplifiable.clear();
   highDegree.clear();
   freeze.clear();
@@ -97,6 +98,7 @@ void InterferenceGraph::build(
     auto &bbIdent = kv.first;
     auto &bb = kv.second;
     auto live = liveOut.at(bbIdent);
+    auto weight = blockWeight ? blockWeight(bbIdent) : 0;
     auto rbeg = std::make_reverse_iterator(bb.getLines().second);
     auto rend = std::make_reverse_iterator(bb.getLines().first);
     for (auto riter = rbeg; riter != rend; ++riter) {
@@ -105,6 +107,10 @@ void InterferenceGraph::build(
         continue;
       auto defs = nasm::getDefinedRegs(inst);
       auto uses = nasm::getUsedRegs(inst);
+      if (blockWeight) {
+        for (auto &reg : nasm::getInvolvedRegs(inst))
+          spillCost[reg] += weight;
+      }
 
       if (auto mov = dycMov(inst)) {
         subSet(live, uses);
@@ -304,6 +310,8 @@ void InterferenceGraph::combine(const Node &v, const Node &u) {
     highDegree.erase(highDegree.find(v));
   coalesced.emplace(v);
   alias.at(v) = u;
+  if (blockWeight)
+    spillCost[u] += spillCost[v];
   // The associated moves are handle externally
 
   for (auto &t : getCurAdjList(v)) {
@@ -349,13 +357,27 @@ bool InterferenceGraph::spill() {
     return false;
 
   auto resIter = highDegree.begin();
-  std::size_t maxDeg = 0;
-  for (auto iter = highDegree.begin(), end = highDegree.end(); iter != end;
-       ++iter) {
-    auto n = *iter;
-    if (curDegree.at(n) > maxDeg) {
-      resIter = iter;
-      maxDeg = curDegree.at(n);
+  if (blockWeight) {
+    double maxRatio = -1;
+    for (auto iter = highDegree.begin(), end = highDegree.end(); iter != end;
+         ++iter) {
+      auto costIter = spillCost.find(*iter);
+      auto cost = costIter == spillCost.end() ? 0 : costIter->second;
+      auto ratio = (double)curDegree.at(*iter) / (double)(cost + 1);
+      if (ratio > maxRatio) {
+        resIter = iter;
+        maxRatio = ratio;
+      }
+    }
+  } else {
+    std::size_t maxDeg = 0;
+    for (auto iter = highDegree.begin(), end = highDegree.end(); iter != end;
+         ++iter) {
+      auto n = *iter;
+      if (curDegree.at(n) > maxDeg) {
+        resIter = iter;
+        maxDeg = curDegree.at(n);
+      }
     }
   }
 
@@ -473,11 +495,20 @@ void RegisterAllocator::allocate() {
     return moveInfo.isMoveRelated(n);
   };
   auto freezeMoves = [this](const Node &n) { return moveInfo.freezeMoves(n); };
+  // The blocks are labeled with ".L" followed by the labels in the IR, except
+  // for the entry, which is labeled with the identifier of the function.
+  auto blockWeight = [this](const std::string &label) -> std::uint64_t {
+    if (label.compare(0, 2, ".L") != 0)
+      return profile->calls;
+    return profile->getBlockCount(std::stoul(label.substr(2)));
+  };
 
   while (true) {
     auto nonPrecolored = getNonPrecoloredNodes(funcBeg, funcEnd);
     interG.clearAndInit(nonPrecolored);
     interG.bindFunctions(enableMoves, isMoveRelated, freezeMoves);
+    if (profile)
+      interG.bindBlockWeight(blockWeight);
     moveInfo.clearAndInit(nonPrecolored);
 
     interG.build(
@@ -693,7 +724,9 @@ void RegisterAllocator::rewriteProgram(const std::vector<Node> &toBeSpilled) {
 
 namespace mocker {
 
-nasm::Module allocateRegisters(const nasm::Module &module) {
+nasm::Module allocateRegisters(
+    const nasm::Module &module,
+    const std::unordered_map<std::string, const ir::FuncProfile *> &profiles) {
   auto res = module;
   auto &text = res.getSection(".text");
   std::vector<LineIter> funcBegs;
@@ -706,7 +739,11 @@ nasm::Module allocateRegisters(const nasm::Module &module) {
   funcBegs.emplace_back(text.getLines().end());
   for (auto iter = funcBegs.begin(), ed = std::prev(funcBegs.end()); iter != ed;
        ++iter) {
-    detail::RegisterAllocator(text, *iter, *(iter + 1)).allocate();
+    auto profile = profiles.find((*iter)->label);
+    detail::RegisterAllocator(text, *iter, *(iter + 1),
+                              profile == profiles.end() ? nullptr
+                                                        : profile->second)
+        .allocate();
   }
   return res;
 }
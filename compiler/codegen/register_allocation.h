@@ -33,6 +33,7 @@
 #include <stack>
 
 #include "helper.h"
+#include "ir/profile.h"
 #include "liveness.h"
 #include "nasm/helper.h"
 #include "nasm/module.h"
@@ -63,6 +64,13 @@ public:
     freezeMoves = std::move(freezeMoves_);
   }
 
+  // With the execution counts of the blocks, a node to be spilled is chosen
+  // by its degree over the cost of spilling it, that is, the number of its
+  // occurrences weighted by the counts. Otherwise, by its degree only.
+  void bindBlockWeight(std::function<std::uint64_t(const std::string &)> f) {
+    blockWeight = std::move(f);
+  }
+
   void build(LineIter funcBeg, LineIter funcEnd,
              const std::function<void(const MovInst &)> &pushWorklist,
              const std::function<void(const MovInst &)> &updateAssociatedMove);
@@ -124,6 +132,8 @@ private:
   // freezeMoves should return the Moves being frozen, namely, the current
   // associated moves
   std::function<std::vector<MovInst>(const Node &)> freezeMoves;
+  // by the labels of the blocks
+  std::function<std::uint64_t(const std::string &)> blockWeight;
 
   // Note that the interference graph will be modified during the process:
   // some nodes will be merged and some will be removed. Simplify simulating the
@@ -141,6 +151,7 @@ private:
   std::unordered_set<NodePair, NodePairHash, NodePairEqual> edges;
   RegMap<RegSet> originalAdjList;
   RegMap<std::size_t> curDegree;
+  RegMap<std::uint64_t> spillCost; // only if [blockWeight] is bound
 
   RegSet simplifiable; // low-degree non-move-related
   RegSet highDegree;   // high-degree
@@ -202,8 +213,11 @@ namespace detail {
 
 class RegisterAllocator {
 public:
-  RegisterAllocator(nasm::Section &section, LineIter funcBeg, LineIter funcEnd)
-      : section(section), funcBeg(funcBeg), funcEnd(funcEnd) {}
+  // [profile] may be nullptr.
+  RegisterAllocator(nasm::Section &section, LineIter funcBeg, LineIter funcEnd,
+                    const ir::FuncProfile *profile = nullptr)
+      : section(section), funcBeg(funcBeg), funcEnd(funcEnd),
+        profile(profile) {}
 
   void allocate();
 
@@ -218,6 +232,7 @@ private:
 private:
   nasm::Section &section;
   LineIter funcBeg, funcEnd;
+  const ir::FuncProfile *profile;
 
   InterferenceGraph interG;
   MoveInfo moveInfo;
@@ -230,7 +245,12 @@ private:
 
 namespace mocker {
 
-nasm::Module allocateRegisters(const nasm::Module &module);
+// [profiles] are the profiles of the functions by their labels in the
+// assembly, which guide the choice of the nodes to be spilled.
+nasm::Module allocateRegisters(
+    const nasm::Module &module,
+    const std::unordered_map<std::string, const ir::FuncProfile *> &profiles =
+        {});
 }
 
 #endif // MOCKER_REGISTER_ALLOCATION_H
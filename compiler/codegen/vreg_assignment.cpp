@@ -8,7 +8,7 @@ namespace mocker {
 
 void VRegAssignment::init(const ir::FunctionModule &func) {
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto dest = ir::getDest(inst);
       if (!dest)
         continue;
@@ -18,7 +18,7 @@ void VRegAssignment::init(const ir::FunctionModule &func) {
   }
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto phi = ir::dyc<ir::Phi>(inst);
       if (!phi)
         continue;
@@ -0,0 +1,222 @@
+#include "time_report.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <malloc.h>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Only counted while the tracking is enabled, so a block allocated before may
+// be subtracted without having been added.
+std::atomic<bool> trackingEnabled{false};
+std::atomic<std::ptrdiff_t> curBytes{0}, peakBytes{0};
+
+void raisePeak(std::ptrdiff_t bytes) {
+  auto peak = peakBytes.load(std::memory_order_relaxed);
+  while (peak < bytes && !peakBytes.compare_exchange_weak(peak, bytes))
+    ;
+}
+
+void *allocate(std::size_t size) noexcept {
+  auto res = std::malloc(size);
+  if (res && trackingEnabled.load(std::memory_order_relaxed))
+    raisePeak(curBytes += (std::ptrdiff_t)malloc_usable_size(res));
+  return res;
+}
+
+void deallocate(void *ptr) noexcept {
+  if (ptr && trackingEnabled.load(std::memory_order_relaxed))
+    curBytes -= (std::ptrdiff_t)malloc_usable_size(ptr);
+  std::free(ptr);
+}
+
+void *allocateOrThrow(std::size_t size) {
+  while (true) {
+    if (auto res = allocate(size))
+      return res;
+    auto handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return allocateOrThrow(size); }
+void *operator new[](std::size_t size) { return allocateOrThrow(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+
+namespace mocker {
+
+void enableAllocationTracking() {
+  trackingEnabled.store(true, std::memory_order_relaxed);
+}
+
+std::size_t allocatedBytes() {
+  return (std::size_t)std::max<std::ptrdiff_t>(curBytes.load(), 0);
+}
+
+TimeReport::Scope::Scope(TimeReport *report, std::string name, bool isPass)
+    : report(report), name(std::move(name)), isPass(isPass) {
+  if (!report)
+    return;
+  beginBytes = curBytes.load();
+  outerPeak = peakBytes.exchange(beginBytes);
+  begin = std::chrono::steady_clock::now();
+}
+
+TimeReport::Scope::~Scope() {
+  if (!report)
+    return;
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  auto innerPeak = peakBytes.load();
+  report->record(name, isPass, elapsed.count(),
+                 innerPeak > beginBytes ? (std::size_t)(innerPeak - beginBytes)
+                                        : 0);
+  raisePeak(outerPeak);
+}
+
+TimeReport::TimeReport() : begin(std::chrono::steady_clock::now()) {}
+
+void TimeReport::addFuncTime(const std::string &pass, const std::string &func,
+                             double seconds) {
+  std::lock_guard<std::mutex> lock(mutex);
+  passes[pass].funcs[func] += seconds;
+}
+
+void TimeReport::record(const std::string &name, bool isPass, double seconds,
+                        std::size_t peakBytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &entry = (isPass ? passes : phases)[name];
+  ++entry.runs;
+  entry.seconds += seconds;
+  entry.peakBytes = std::max(entry.peakBytes, peakBytes);
+}
+
+double TimeReport::getTotalSeconds() const {
+  std::chrono::duration<double> res = std::chrono::steady_clock::now() - begin;
+  return res.count();
+}
+
+namespace {
+
+template <class Entry>
+std::vector<std::pair<std::string, const Entry *>>
+sortBySeconds(const std::map<std::string, Entry> &entries) {
+  std::vector<std::pair<std::string, const Entry *>> res;
+  for (auto &kv : entries)
+    res.emplace_back(kv.first, &kv.second);
+  std::stable_sort(res.begin(), res.end(),
+                   [](const auto &lhs, const auto &rhs) {
+                     return lhs.second->seconds > rhs.second->seconds;
+                   });
+  return res;
+}
+
+} // namespace
+
+void TimeReport::printTable(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto total = getTotalSeconds();
+  out << "===== Time report (total " << std::fixed << std::setprecision(4)
+      << total << " s) =====\n";
+
+  auto printEntries = [&out, total](const std::map<std::string, Entry> &entries,
+                                    const char *title) {
+    out << "\n   time (s)       %    runs  peak (KB)  " << title << '\n';
+    for (auto &kv : sortBySeconds(entries)) {
+      auto &entry = *kv.second;
+      out << std::setw(11) << std::setprecision(4) << entry.seconds
+          << std::setw(8) << std::setprecision(1)
+          << (total > 0 ? entry.seconds / total * 100 : 0) << std::setw(8)
+          << entry.runs << std::setw(11) << entry.peakBytes / 1024 << "  "
+          << kv.first << '\n';
+    }
+  };
+  printEntries(phases, "phase");
+  printEntries(passes, "pass");
+
+  // The slowest (pass, function) pairs
+  constexpr std::size_t MaxFuncs = 20;
+  std::vector<std::tuple<double, std::string, std::string>> funcs;
+  for (auto &pass : passes) {
+    for (auto &func : pass.second.funcs)
+      funcs.emplace_back(func.second, pass.first, func.first);
+  }
+  std::stable_sort(funcs.begin(), funcs.end(),
+                   [](const auto &lhs, const auto &rhs) {
+                     return std::get<0>(lhs) > std::get<0>(rhs);
+                   });
+  out << "\n   time (s)  pass / function\n";
+  for (std::size_t i = 0; i < funcs.size() && i < MaxFuncs; ++i) {
+    out << std::setw(11) << std::setprecision(4) << std::get<0>(funcs[i])
+        << "  " << std::get<1>(funcs[i]) << " / " << std::get<2>(funcs[i])
+        << '\n';
+  }
+  out << std::defaultfloat << std::setprecision(6);
+  out.flush();
+}
+
+void TimeReport::printJson(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto printEntries = [&out](const std::map<std::string, Entry> &entries,
+                             bool withFuncs) {
+    out << '[';
+    std::size_t i = 0;
+    for (auto &kv : sortBySeconds(entries)) {
+      auto &entry = *kv.second;
+      out << (i++ == 0 ? "\n" : ",\n");
+      out << "    {\"name\": \"" << kv.first
+          << "\", \"seconds\": " << entry.seconds
+          << ", \"runs\": " << entry.runs
+          << ", \"peakBytes\": " << entry.peakBytes;
+      if (withFuncs) {
+        out << ", \"funcs\": {";
+        std::size_t j = 0;
+        for (auto &func : entry.funcs)
+          out << (j++ == 0 ? "" : ", ") << '"' << func.first
+              << "\": " << func.second;
+        out << '}';
+      }
+      out << '}';
+    }
+    out << (entries.empty() ? "]" : "\n  ]");
+  };
+
+  out << "{\n  \"total\": " << getTotalSeconds() << ",\n  \"phases\": ";
+  printEntries(phases, false);
+  out << ",\n  \"passes\": ";
+  printEntries(passes, true);
+  out << "\n}" << std::endl;
+}
+
+TimeReport *&timeReport() {
+  static TimeReport *res = nullptr;
+  return res;
+}
+
+} // namespace mocker
@@ -0,0 +1,78 @@
+#ifndef MOCKER_TIME_REPORT_H
+#define MOCKER_TIME_REPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace mocker {
+
+// Start counting the bytes allocated with operator new, which is otherwise a
+// plain malloc.
+void enableAllocationTracking();
+
+// The bytes allocated with operator new since the tracking was enabled and not
+// freed yet.
+std::size_t allocatedBytes();
+
+// Collects the wall time and the peak allocated bytes of the phases of the
+// compiler and of the optimization passes.
+class TimeReport {
+public:
+  // Measures the lifetime of the scope as a run of [name]. Nested scopes are
+  // also included in the enclosing ones. Does nothing if [report] is null.
+  class Scope {
+  public:
+    Scope(TimeReport *report, std::string name, bool isPass = false);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+  private:
+    TimeReport *report;
+    std::string name;
+    bool isPass;
+    std::chrono::steady_clock::time_point begin;
+    std::ptrdiff_t beginBytes = 0, outerPeak = 0;
+  };
+
+  TimeReport();
+
+  // Thread-safe, since the functions may be visited concurrently.
+  void addFuncTime(const std::string &pass, const std::string &func,
+                   double seconds);
+
+  // The phases and the passes sorted by time, then the slowest functions.
+  void printTable(std::ostream &out) const;
+
+  // {"total": ..., "phases": [{"name": ..., "seconds": ..., "runs": ...,
+  // "peakBytes": ...}], "passes": [... "funcs": {<name>: <seconds>}]}
+  void printJson(std::ostream &out) const;
+
+private:
+  struct Entry {
+    std::size_t runs = 0;
+    double seconds = 0;
+    std::size_t peakBytes = 0; // above the allocated bytes at the beginning
+    std::map<std::string, double> funcs;
+  };
+
+  void record(const std::string &name, bool isPass, double seconds,
+              std::size_t peakBytes);
+
+  double getTotalSeconds() const;
+
+  std::chrono::steady_clock::time_point begin;
+  mutable std::mutex mutex;
+  std::map<std::string, Entry> phases, passes;
+};
+
+// The report filled by the driver and runOptPasses, if any.
+TimeReport *&timeReport();
+
+} // namespace mocker
+
+#endif // MOCKER_TIME_REPORT_H
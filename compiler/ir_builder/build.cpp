@@ -24,46 +24,46 @@ ir::Module buildIR(const std::shared_ptr<ast::ASTRoot> &ast,
   { // #_array_#size
     ir::FunctionModule func("#_array_#size", {"ptr"});
     auto bb = func.pushBackBB();
-    auto ptr = std::make_shared<ir::Reg>("0");
+    auto ptr = func.makeReg("0");
     auto tmp = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::ArithBinaryInst>(
+    bb->appendInst(func.makeInst<ir::ArithBinaryInst>(
         tmp, ir::ArithBinaryInst::Sub, ptr,
         std::make_shared<ir::IntLiteral>(8)));
     auto funcRes = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::Load>(funcRes, tmp));
-    bb->appendInst(std::make_shared<ir::Ret>(funcRes));
-    res.overwriteFunc(func.getIdentifier(), func);
+    bb->appendInst(func.makeInst<ir::Load>(funcRes, tmp));
+    bb->appendInst(func.makeInst<ir::Ret>(funcRes));
+    res.overwriteFunc(func.getIdentifier(), std::move(func));
   }
   { // #string#length
     ir::FunctionModule func("#string#length", {"ptr"});
     auto bb = func.pushBackBB();
-    auto ptr = std::make_shared<ir::Reg>("0");
+    auto ptr = func.makeReg("0");
     auto tmp = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::ArithBinaryInst>(
+    bb->appendInst(func.makeInst<ir::ArithBinaryInst>(
         tmp, ir::ArithBinaryInst::Sub, ptr,
         std::make_shared<ir::IntLiteral>(8)));
     auto funcRes = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::Load>(funcRes, tmp));
-    bb->appendInst(std::make_shared<ir::Ret>(funcRes));
-    res.overwriteFunc(func.getIdentifier(), func);
+    bb->appendInst(func.makeInst<ir::Load>(funcRes, tmp));
+    bb->appendInst(func.makeInst<ir::Ret>(funcRes));
+    res.overwriteFunc(func.getIdentifier(), std::move(func));
   }
   /*
   { // #string#ord ( this pos )
     ir::FunctionModule func("#string#ord", {"ptr", "pos"});
     auto bb = func.pushBackBB();
-    auto ptr = std::make_shared<ir::Reg>("0");
-    auto pos = std::make_shared<ir::Reg>("1");
+    auto ptr = func.makeReg("0");
+    auto pos = func.makeReg("1");
     auto tmp = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::ArithBinaryInst>(
+    bb->appendInst(func.makeInst<ir::ArithBinaryInst>(
         tmp, ir::ArithBinaryInst::Add, ptr, pos));
     auto loadRes = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::Load>(loadRes, tmp));
+    bb->appendInst(func.makeInst<ir::Load>(loadRes, tmp));
     auto funcRes = func.makeTempLocalReg();
-    bb->appendInst(std::make_shared<ir::ArithBinaryInst>(
+    bb->appendInst(func.makeInst<ir::ArithBinaryInst>(
         funcRes, ir::ArithBinaryInst::BitAnd, loadRes,
         std::make_shared<ir::IntLiteral>(255)));
-    bb->appendInst(std::make_shared<ir::Ret>(funcRes));
-    res.overwriteFunc(func.getIdentifier(), func);
+    bb->appendInst(func.makeInst<ir::Ret>(funcRes));
+    res.overwriteFunc(func.getIdentifier(), std::move(func));
   }
   */
   return res;
@@ -34,7 +34,8 @@ void Builder::operator()(const ast::NullLitExpr &node) const {
 void Builder::operator()(const ast::IdentifierExpr &node) const {
   auto dest = ctx.makeTempLocalReg();
   ctx.setExprAddr(node.getID(), dest);
-  ctx.emplaceInst<Load>(dest, makeReg(node.identifier->val));
+  ctx.emplaceInst<Load>(dest, makeReg(node.identifier->val),
+                        getAccessWidth(node));
   ctx.markExprTrivial(node);
   ctx.checkLogicalExpr(node);
 }
@@ -106,7 +107,7 @@ void Builder::operator()(const ast::BinaryExpr &node) const {
     visit(*node.rhs);
     auto rhsVal = ctx.getExprAddr(node.rhs->getID());
     auto lhsAddr = getElementPtr(node.lhs);
-    ctx.emplaceInst<Store>(lhsAddr, rhsVal);
+    ctx.emplaceInst<Store>(lhsAddr, rhsVal, getAccessWidth(*node.lhs));
     return;
   }
   if (node.op == ast::BinaryExpr::Subscript ||
@@ -117,7 +118,7 @@ void Builder::operator()(const ast::BinaryExpr &node) const {
         const_cast<ast::BinaryExpr &>(node).shared_from_this()));
     ctx.getLogicalExprInfo().empty = bak;
     auto val = ctx.makeTempLocalReg("valOrInstPtr");
-    ctx.emplaceInst<Load>(val, addr);
+    ctx.emplaceInst<Load>(val, addr, getAccessWidth(node));
     ctx.setExprAddr(node.getID(), val);
     ctx.checkLogicalExpr(node);
     return;
@@ -242,7 +243,7 @@ void Builder::operator()(const ast::VarDeclStmt &node) const {
   auto &func = ctx.getCurFunc();
   auto name = node.identifier->val;
   auto valPtr = makeReg(name);
-  ctx.appendInstFront(func.getFirstBB(), std::make_shared<Alloca>(valPtr));
+  ctx.appendInstFront(func.getFirstBB(), ctx.makeInst<Alloca>(valPtr));
 
   if (node.initExpr && !isNullTy(ctx.getExprType(node.initExpr->getID()))) {
     visit(*node.initExpr);
@@ -317,11 +318,10 @@ void Builder::operator()(const ast::IfStmt &node) const {
 
   auto successorBB = func.insertBBAfter(node.else_ ? elseLastBB : thenLastBB);
   auto successorLabel = std::make_shared<Label>(successorBB->getLabelID());
-  auto jump = std::make_shared<Jump>(successorLabel);
   if (!thenLastBB->isCompleted())
-    ctx.appendInst(thenLastBB, jump);
+    ctx.appendInst(thenLastBB, ctx.makeInst<Jump>(successorLabel));
   if (node.else_ && !elseLastBB->isCompleted())
-    ctx.appendInst(elseLastBB, jump);
+    ctx.appendInst(elseLastBB, ctx.makeInst<Jump>(successorLabel));
 
   auto &info = ctx.getLogicalExprInfo();
   info.inCondition = true;
@@ -361,13 +361,13 @@ void Builder::operator()(const ast::FuncDecl &node) const {
 
   if (isMember) {
     auto reg = makeReg("this");
-    ctx.appendInstFront(func.getFirstBB(), std::make_shared<Alloca>(reg));
+    ctx.appendInstFront(func.getFirstBB(), ctx.makeInst<Alloca>(reg));
     ctx.emplaceInst<Store>(reg, makeReg("0"));
   }
   for (std::size_t i = 0; i < node.formalParameters.size(); ++i) {
     auto name = node.formalParameters[i]->identifier->val;
     auto reg = makeReg(name);
-    ctx.appendInstFront(func.getFirstBB(), std::make_shared<Alloca>(reg));
+    ctx.appendInstFront(func.getFirstBB(), ctx.makeInst<Alloca>(reg));
     ctx.emplaceInst<Store>(reg, makeReg(std::to_string(i + isMember)));
   }
 
@@ -414,15 +414,22 @@ namespace mocker {
 namespace ir {
 
 void Builder::addClassLayout(const ast::ClassDecl &node) const {
+  // A bool takes a single byte. The other fields and the size of the class are
+  // aligned to 8 bytes.
+  auto alignTo8 = [](std::size_t offset) { return (offset + 7) & ~7ul; };
   BuilderContext::ClassLayout classLayout;
   for (auto &mem : node.members) {
     if (auto decl = std::dynamic_pointer_cast<ast::VarDecl>(mem)) {
       std::string varName =
           splitMemberVarIdent(decl->decl->identifier->val).second;
+      auto isBool = isBoolTy(decl->decl->type);
+      if (!isBool)
+        classLayout.size = alignTo8(classLayout.size);
       classLayout.offset[varName] = classLayout.size;
-      classLayout.size += 8;
+      classLayout.size += isBool ? 1 : 8;
     }
   }
+  classLayout.size = alignTo8(classLayout.size);
   ctx.addClassLayout(node.identifier->val, std::move(classLayout));
 }
 
@@ -468,9 +475,13 @@ Builder::getElementPtr(const std::shared_ptr<ast::ASTNode> &exp) const {
     auto arrayInstPtr = ctx.getExprAddr(p->lhs->getID());
     auto contentPtr = arrayInstPtr;
     auto idx = ctx.getExprAddr(p->rhs->getID());
-    auto offset = ctx.makeTempLocalReg("offset");
-    ctx.emplaceInst<ArithBinaryInst>(offset, ArithBinaryInst::Mul, idx,
-                                     makeILit(8));
+    auto offset = idx;
+    if (!isBoolTy(ctx.getExprType(p->getID()))) { // bool arrays are packed
+      auto scaled = ctx.makeTempLocalReg("offset");
+      ctx.emplaceInst<ArithBinaryInst>(scaled, ArithBinaryInst::Mul, idx,
+                                       makeILit(8));
+      offset = scaled;
+    }
     auto addr = ctx.makeTempLocalReg("elementPtr");
     ctx.emplaceInst<ArithBinaryInst>(addr, ArithBinaryInst::Add, contentPtr,
                                      offset);
@@ -497,7 +508,7 @@ void Builder::translateEscapedLogicBinary(
   FunctionModule &func = ctx.getCurFunc();
 
   auto boolExpAddr = ctx.makeTempLocalReg("boolExpAddr");
-  ctx.appendInstFront(func.getFirstBB(), std::make_shared<Alloca>(boolExpAddr));
+  ctx.appendInstFront(func.getFirstBB(), ctx.makeInst<Alloca>(boolExpAddr));
 
   visit(*node.lhs);
   auto lhsVal = ctx.getExprAddr(node.lhs->getID());
@@ -517,11 +528,11 @@ void Builder::translateEscapedLogicBinary(
 
   if (!ctx.isTrivial(node.rhs)) {
     if (node.op == ast::BinaryExpr::LogicalAnd) {
-      ctx.appendInst(lhsLastBB, std::make_shared<Branch>(
+      ctx.appendInst(lhsLastBB, ctx.makeInst<Branch>(
                                     ctx.getExprAddr(node.lhs->getID()),
                                     rhsFirstLabel, successorLabel));
     } else {
-      ctx.appendInst(lhsLastBB, std::make_shared<Branch>(
+      ctx.appendInst(lhsLastBB, ctx.makeInst<Branch>(
                                     ctx.getExprAddr(node.lhs->getID()),
                                     successorLabel, rhsFirstLabel));
     }
@@ -533,7 +544,7 @@ void Builder::translateEscapedLogicBinary(
     return;
   }
 
-  ctx.appendInst(lhsLastBB, std::make_shared<Jump>(rhsFirstLabel));
+  ctx.appendInst(lhsLastBB, ctx.makeInst<Jump>(rhsFirstLabel));
   ctx.setCurBasicBlock(successorBB);
 
   rhsVal = ctx.getExprAddr(node.rhs->getID());
@@ -568,26 +579,24 @@ void Builder::translateLogicBinary(const ast::BinaryExpr &node) const {
       break;
 
     auto boolExpAddr = ctx.makeTempLocalReg("boolExpAddr");
-    ctx.appendInstFront(func.getFirstBB(),
-                        std::make_shared<Alloca>(boolExpAddr));
+    ctx.appendInstFront(func.getFirstBB(), ctx.makeInst<Alloca>(boolExpAddr));
 
     auto succBB = func.pushBackBB();
     auto succLabel = getBBLabel(succBB);
     auto val = ctx.makeTempLocalReg("v");
-    ctx.appendInst(succBB, std::make_shared<Load>(val, boolExpAddr));
+    ctx.appendInst(succBB, ctx.makeInst<Load>(val, boolExpAddr));
     ctx.setExprAddr(node.getID(), val);
 
-    auto jumpSucc = std::make_shared<Jump>(succLabel);
     info.trueNext = func.pushBackBB();
     ctx.appendInst(
         info.trueNext,
-        std::make_shared<Store>(boolExpAddr, std::make_shared<IntLiteral>(1)));
-    ctx.appendInst(info.trueNext, jumpSucc);
+        ctx.makeInst<Store>(boolExpAddr, std::make_shared<IntLiteral>(1)));
+    ctx.appendInst(info.trueNext, ctx.makeInst<Jump>(succLabel));
     info.falseNext = func.pushBackBB();
     ctx.appendInst(
         info.falseNext,
-        std::make_shared<Store>(boolExpAddr, std::make_shared<IntLiteral>(0)));
-    ctx.appendInst(info.falseNext, jumpSucc);
+        ctx.makeInst<Store>(boolExpAddr, std::make_shared<IntLiteral>(0)));
+    ctx.appendInst(info.falseNext, ctx.makeInst<Jump>(succLabel));
 
     undo = Defer([this, succBB] {
       ctx.getLogicalExprInfo().empty = true;
@@ -635,8 +644,7 @@ void Builder::translateLoop(
   auto defer2 =
       Defer([this, &successorBB] { ctx.setCurBasicBlock(successorBB); });
 
-  auto jump2Cond = std::make_shared<Jump>(conditionLabel);
-  ctx.appendInst(originBB, jump2Cond);
+  ctx.appendInst(originBB, ctx.makeInst<Jump>(conditionLabel));
 
   // condition
   ctx.setCurBasicBlock(conditionFirstBB);
@@ -650,7 +658,7 @@ void Builder::translateLoop(
     info.empty = true;
     info.inCondition = false;
   } else {
-    auto br = std::make_shared<Branch>(makeILit(1), bodyLabel, successorLabel);
+    auto br = ctx.makeInst<Branch>(makeILit(1), bodyLabel, successorLabel);
     ctx.appendInst(conditionFirstBB, br);
   }
   ctx.pushLoopEntry(conditionLabel);
@@ -668,12 +676,12 @@ void Builder::translateLoop(
   visit(*body);
   auto bodyLastBB = ctx.getCurBasicBlock();
   if (!bodyLastBB->isCompleted())
-    ctx.appendInst(std::make_shared<ir::Jump>(updateLabel));
+    ctx.emplaceInst<ir::Jump>(updateLabel);
 
   ctx.setCurBasicBlock(updateBB);
   if (update)
     visit(*update);
-  ctx.appendInst(updateBB, jump2Cond);
+  ctx.appendInst(updateBB, ctx.makeInst<Jump>(conditionLabel));
 }
 
 std::shared_ptr<Addr> Builder::translateNewArray(
@@ -685,7 +693,8 @@ std::shared_ptr<Addr> Builder::translateNewArray(
   // the array elements.) It is the return value of this function. Hence, the
   // first step is
   //   1. to malloc a piece of memory of length 8 + 8 * N and store the address
-  //      + 8 into arrayInstPtr;
+  //      + 8 into arrayInstPtr; (An array of bool is packed, hence the length
+  //      is 8 + N, rounded up to a multiple of 8.)
   //   2. and store N into the first 8 bytes.
   // Then, we shall construct the array. If T is int or bool, then there is
   // nothing to do. Otherwise, we shall construct each element via a loop. To
@@ -727,11 +736,19 @@ std::shared_ptr<Addr> Builder::translateNewArray(
   auto memLen = ctx.makeTempLocalReg("memLen");
   ctx.emplaceInst<AttachedComment>("Calculate the memory needed");
   auto contentLen = ctx.makeTempLocalReg("contentLen");
-  ctx.emplaceInst<ArithBinaryInst>(contentLen, ArithBinaryInst::Mul,
-                                   makeILit(8),
-                                   size); // calcMemLen
-  ctx.emplaceInst<ArithBinaryInst>(memLen, ArithBinaryInst::Add, contentLen,
-                                   makeILit(8));
+  if (isBoolTy(elementType)) {
+    auto paddedLen = ctx.makeTempLocalReg("paddedLen");
+    ctx.emplaceInst<ArithBinaryInst>(paddedLen, ArithBinaryInst::Add, size,
+                                     makeILit(15));
+    ctx.emplaceInst<ArithBinaryInst>(memLen, ArithBinaryInst::BitAnd,
+                                     paddedLen, makeILit(-8));
+  } else {
+    ctx.emplaceInst<ArithBinaryInst>(contentLen, ArithBinaryInst::Mul,
+                                     makeILit(8),
+                                     size); // calcMemLen
+    ctx.emplaceInst<ArithBinaryInst>(memLen, ArithBinaryInst::Add, contentLen,
+                                     makeILit(8));
+  }
   auto memPtr = ctx.makeTempLocalReg("memPtr");
   ctx.emplaceInst<Malloc>(memPtr, memLen);
 
@@ -755,7 +772,7 @@ std::shared_ptr<Addr> Builder::translateNewArray(
 
   auto curElementPtrPtr = ctx.makeTempLocalReg("curElementPtrPtr");
   ctx.appendInstFront(func.getFirstBB(),
-                      std::make_shared<Alloca>(curElementPtrPtr));
+                      ctx.makeInst<Alloca>(curElementPtrPtr));
   ctx.emplaceInst<Store>(curElementPtrPtr, arrayInstPtr);
   auto contentEndPtr = ctx.makeTempLocalReg("contentEndPtr");
   // calcContentEndPtr
@@ -770,8 +787,7 @@ std::shared_ptr<Addr> Builder::translateNewArray(
   auto successorBB = func.insertBBAfter(bodyFirstBB);
   auto successorLabel = getBBLabel(successorBB);
 
-  auto jump2condition = std::make_shared<Jump>(conditionLabel);
-  ctx.appendInst(jump2condition);
+  ctx.emplaceInst<Jump>(conditionLabel);
 
   // 4.
   ctx.setCurBasicBlock(conditionFirstBB);
@@ -797,7 +813,7 @@ std::shared_ptr<Addr> Builder::translateNewArray(
                                    curElementPtr,
                                    makeILit(8)); // calcNextElementPtr
   ctx.emplaceInst<Store>(curElementPtrPtr, nextElementPtr);
-  ctx.appendInst(jump2condition);
+  ctx.emplaceInst<Jump>(conditionLabel);
 
   ctx.setCurBasicBlock(successorBB);
   return arrayInstPtr;
@@ -850,11 +866,11 @@ void Builder::addGlobalVariable(
   if (!decl->decl->initExpr)
     return;
 
-  auto reg = makeReg(ident);
   auto funcName = "_init_" + ident;
   auto &func = ctx.addFunc(FunctionModule(funcName, {}));
   ctx.initFuncCtx(0);
   ctx.setCurBasicBlock(func.pushBackBB());
+  auto reg = makeReg(ident);
   visit(*decl->decl->initExpr);
   ctx.emplaceInst<Store>(reg, ctx.getExprAddr(decl->decl->initExpr->getID()));
   ctx.emplaceInst<Ret>();
@@ -925,9 +941,9 @@ std::shared_ptr<Reg>
 Builder::getMemberElementPtr(const std::shared_ptr<Addr> &base,
                              const std::string &className,
                              const std::string &varName) const {
-  auto attachedComment = std::make_shared<AttachedComment>(
+  auto attachedComment = ctx.makeInst<AttachedComment>(
       "getElementPtr: " + className + "::" + varName);
-  ctx.appendInst(std::move(attachedComment));
+  ctx.appendInst(attachedComment);
 
   std::size_t offset = ctx.getOffset(className, varName);
   auto offsetLit = std::make_shared<IntLiteral>((Integer)offset);
@@ -939,16 +955,16 @@ Builder::getMemberElementPtr(const std::shared_ptr<Addr> &base,
 
 std::shared_ptr<Reg> Builder::makeReg(std::string identifier) const {
   if (identifier.at(0) == '@') // is global variable
-    return std::make_shared<Reg>(std::move(identifier));
+    return ctx.makeReg(identifier);
   if (identifier.at(0) == '#') { // is member variable
     std::string className, varName;
     std::tie(className, varName) = splitMemberVarIdent(identifier);
-    auto instancePtrPtr = std::make_shared<Reg>("this");
+    auto instancePtrPtr = ctx.makeReg("this");
     auto instancePtr = ctx.makeTempLocalReg("instPtr");
     ctx.emplaceInst<Load>(instancePtr, instancePtrPtr);
     return getMemberElementPtr(instancePtr, className, varName);
   }
-  return std::make_shared<Reg>(std::move(identifier));
+  return ctx.makeReg(identifier);
 }
 
 std::shared_ptr<Addr>
@@ -984,6 +1000,19 @@ Builder::getTypeIdentifier(const std::shared_ptr<ast::Type> &type) const {
   assert(false);
 }
 
+std::size_t Builder::getAccessWidth(const ast::Expression &exp) const {
+  if (!isBoolTy(ctx.getExprType(exp.getID())))
+    return 8;
+  if (auto p = dynamic_cast<const ast::IdentifierExpr *>(&exp))
+    return p->identifier->val.at(0) == '#' ? 1 : 8; // member variable
+  if (auto p = dynamic_cast<const ast::BinaryExpr *>(&exp))
+    return p->op == ast::BinaryExpr::Subscript ||
+                   p->op == ast::BinaryExpr::Member
+               ? 1
+               : 8;
+  return 8;
+}
+
 std::size_t Builder::getTypeSize(const std::shared_ptr<ast::Type> &type) const {
   if (auto p = std::dynamic_pointer_cast<ast::BuiltinType>(type)) {
     if (p->type == ast::BuiltinType::String)
@@ -145,6 +145,12 @@ private:
 
   std::size_t getTypeSize(const std::shared_ptr<ast::Type> &type) const;
 
+  // The width of the loads and stores of [exp], which is a left value. The
+  // fields of type bool and the elements of the arrays of bool take a single
+  // byte. The other values, including the local and the global variables,
+  // take 8 bytes.
+  std::size_t getAccessWidth(const ast::Expression &exp) const;
+
 private:
   BuilderContext &ctx;
 };
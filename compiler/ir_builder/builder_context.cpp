@@ -12,6 +12,10 @@ std::shared_ptr<Reg> BuilderContext::makeTempLocalReg(const std::string &hint) {
   return curFunc->makeTempLocalReg(hint);
 }
 
+std::shared_ptr<Reg> BuilderContext::makeReg(const std::string &identifier) {
+  return curFunc->makeReg(identifier);
+}
+
 std::shared_ptr<Addr> BuilderContext::getExprAddr(ast::NodeID id) const {
   return exprAddr.at(id);
 }
@@ -26,26 +30,25 @@ Module &BuilderContext::getResult() {
   auto iter = insts.begin();
   while (ir::dyc<ir::Alloca>(*iter))
     ++iter;
-  insts.emplace(iter,
-                std::make_shared<ir::Call>(std::string("_init_global_vars")));
+  insts.insert(iter, module.getFuncs().at("main").makeInst<ir::Call>(
+                        std::string("_init_global_vars")));
 
   emplaceGlobalInitInst<ir::Ret>();
   return module;
 }
 
-void BuilderContext::appendInst(std::shared_ptr<IRInst> inst) {
-  appendInst(curBasicBlock, std::move(inst));
+void BuilderContext::appendInst(IRInst *inst) {
+  appendInst(curBasicBlock, inst);
 }
 
-void BuilderContext::appendInst(BBLIter bblIter, std::shared_ptr<IRInst> inst) {
+void BuilderContext::appendInst(BBLIter bblIter, IRInst *inst) {
   bbReside[inst->getID()] = bblIter;
-  bblIter->appendInst(std::move(inst));
+  bblIter->appendInst(inst);
 }
 
-void BuilderContext::appendInstFront(BBLIter bblIter,
-                                     std::shared_ptr<IRInst> inst) {
+void BuilderContext::appendInstFront(BBLIter bblIter, IRInst *inst) {
   bbReside[inst->getID()] = bblIter;
-  bblIter->appendInstFront(std::move(inst));
+  bblIter->appendInstFront(inst);
 }
 
 void BuilderContext::setCurBasicBlock(BBLIter val) { curBasicBlock = val; }
@@ -124,11 +127,10 @@ BuilderContext::addStringLiteral(const std::string &literal) {
 
   auto iter = strLits.find(literal);
   if (iter != strLits.end())
-    return iter->second;
+    return makeReg(iter->second);
 
   auto ident = "@_strlit_" + std::to_string(strLitCounter++);
   addGlobalVar(ident);
-  auto instPtr = std::make_shared<Reg>(ident);
 
   auto strInstIdent = ident + "c";
   char buffer[8 + literal.size() + 1];
@@ -141,13 +143,13 @@ BuilderContext::addStringLiteral(const std::string &literal) {
   auto &bb = func.getMutableBBs().back();
   assert(!bb.isCompleted());
   auto contentPtr = func.makeTempLocalReg();
-  bb.appendInst(std::make_shared<ArithBinaryInst>(
-      contentPtr, ArithBinaryInst::Add, std::make_shared<Reg>(strInstIdent),
+  bb.appendInst(func.makeInst<ArithBinaryInst>(
+      contentPtr, ArithBinaryInst::Add, func.makeReg(strInstIdent),
       std::make_shared<IntLiteral>(8)));
-  bb.appendInst(std::make_shared<Store>(instPtr, contentPtr));
+  bb.appendInst(func.makeInst<Store>(func.makeReg(ident), contentPtr));
 
-  strLits.emplace(literal, instPtr);
-  return instPtr;
+  strLits.emplace(literal, ident);
+  return makeReg(ident);
 }
 
 void BuilderContext::addGlobalVar(std::string ident, std::string data) {
@@ -43,16 +43,24 @@ public:
 
   std::shared_ptr<Reg> makeTempLocalReg(const std::string &hint = "");
 
+  // Return the register of the current function named [identifier].
+  std::shared_ptr<Reg> makeReg(const std::string &identifier);
+
+  // Construct an instruction owned by the current function.
+  template <class InstType, class... Args>
+  InstType *makeInst(Args &&... args) {
+    return curFunc->makeInst<InstType>(std::forward<Args>(args)...);
+  }
+
   template <class InstType, class... Args> void emplaceInst(Args &&... args) {
-    auto inst = std::make_shared<InstType>(std::forward<Args>(args)...);
-    appendInst(std::move(inst));
+    appendInst(makeInst<InstType>(std::forward<Args>(args)...));
   }
 
-  void appendInst(std::shared_ptr<IRInst> inst);
+  void appendInst(IRInst *inst);
 
-  void appendInst(BBLIter bblIter, std::shared_ptr<IRInst> inst);
+  void appendInst(BBLIter bblIter, IRInst *inst);
 
-  void appendInstFront(BBLIter bblIter, std::shared_ptr<IRInst> inst);
+  void appendInstFront(BBLIter bblIter, IRInst *inst);
 
   void setCurBasicBlock(BBLIter val);
 
@@ -108,7 +116,7 @@ public:
   void emplaceGlobalInitInst(Args &&... args) {
     auto &func = module.getFuncs().at("_init_global_vars");
     func.getMutableBBs().back().appendInst(
-        std::make_shared<Inst>(std::forward<Args>(args)...));
+        func.makeInst<Inst>(std::forward<Args>(args)...));
   }
 
   void markExprTrivial(const ast::Expression &node) {
@@ -152,7 +160,8 @@ private:
   std::stack<std::shared_ptr<Label>> loopEntry, loopSuccessor, loopUpdate;
   // The key is <class name> + '_' + <variable name>
   std::unordered_map<std::string, ClassLayout> classLayout;
-  std::unordered_map<std::string, std::shared_ptr<Reg>> strLits;
+  // literal -> identifier of the global variable
+  std::unordered_map<std::string, std::string> strLits;
 
   std::unordered_set<ast::NodeID> trivialExpr;
 
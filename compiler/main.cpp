@@ -1,25 +1,38 @@
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "ast/ast_node.h"
 #include "codegen/instruction_selection.h"
 #include "codegen/naive_register_allocation.h"
 #include "codegen/peephole.h"
 #include "codegen/register_allocation.h"
+#include "common/time_report.h"
+#include "defer.h"
 #include "ir/helper.h"
 #include "ir/printer.h"
+#include "ir/profile.h"
+#include "ir/serialize.h"
 #include "ir/stats.h"
 #include "ir_builder/build.h"
 #include "ir_builder/builder.h"
 #include "ir_builder/builder_context.h"
+#include "nasm/emulator.h"
 #include "nasm/printer.h"
 #include "nasm/stats.h"
+#include "optim/analysis/analysis_manager.h"
 #include "optim/codegen_prepare.h"
 #include "optim/constant_propagation.h"
 #include "optim/copy_propagation.h"
 #include "optim/dead_code_elimination.h"
+#include "optim/dynamic_stats.h"
 #include "optim/function_inline.h"
 #include "optim/global_const_inline.h"
 #include "optim/global_value_numbering.h"
@@ -28,20 +41,34 @@
 #include "optim/loopinv.h"
 #include "optim/module_simplification.h"
 #include "optim/optimizer.h"
+#include "optim/pass_stats.h"
+#include "optim/pipeline.h"
+#include "optim/profile_use.h"
 #include "optim/promote_global_variables.h"
 #include "optim/reassociation.h"
 #include "optim/simplify_cfg.h"
 #include "optim/ssa.h"
+#include "optim/worklist_scheduler.h"
 #include "parse/lexer.h"
 #include "parse/parser.h"
 #include "semantic/semantic_checker.h"
 #include "semantic/sym_tbl.h"
+#include "thread_pool.h"
+
+#include <dirent.h>
 
 mocker::ir::Module runFrontend(const std::string &srcPath);
 
-void optimize(mocker::ir::Module &module);
+// Run [pipeline], or the full -O3 pipeline if it is null.
+void optimize(mocker::ir::Module &module, const mocker::Pipeline *pipeline);
+
+// Emulate the program after register allocation and after peephole
+// optimization, reading [emulationInput], unless it is null.
+mocker::nasm::Module codegen(const mocker::ir::Module &irModule,
+                             const std::string *emulationInput);
 
-mocker::nasm::Module codegen(const mocker::ir::Module &irModule);
+void printEmulatorStats(const mocker::nasm::Module &module,
+                        const std::string &input);
 
 void printIRStats(const mocker::ir::Stats &stats);
 
@@ -49,32 +76,168 @@ void printNasmStats(const mocker::nasm::Stats &stats);
 
 void runOptsUntilFixedPoint(mocker::ir::Module &module);
 
+// Accumulated over the calls of runOptsUntilFixedPoint
+mocker::WorklistScheduler::Stats &fixedPointStats();
+
+void runBenchmarks(const std::string &dir, bool json,
+                   const mocker::Pipeline *pipeline);
+
 int main(int argc, char **argv) {
-  bool semanticOnly = false;
-  for (int i = 0; i < argc; ++i) {
-    if (std::string(argv[i]) == "--semantic")
+  bool semanticOnly = false, benchJson = false, emulate = false;
+  std::string irStatsPath, profilePath, benchDir, emulationInputPath;
+  std::size_t jobs = 1;
+  int level = 3;
+  bool customPasses = false;
+  std::string passes;
+  bool timeReportEnabled = false;
+  std::string timeReportPath;
+  // <source> [<IR output> [<asm output>]], in any order with the options,
+  // which are those starting with '-'
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.empty() || arg[0] != '-') {
+      paths.emplace_back(arg);
+      continue;
+    }
+    if (arg == "--semantic")
       semanticOnly = true;
+    if (arg.compare(0, 11, "--ir-stats=") == 0)
+      irStatsPath = arg.substr(11);
+    if (arg.compare(0, 14, "--profile-use=") == 0)
+      profilePath = arg.substr(14);
+    if (arg.compare(0, 8, "--bench=") == 0)
+      benchDir = arg.substr(8);
+    if (arg == "--bench-json")
+      benchJson = true;
+    if (arg == "--emulate")
+      emulate = true;
+    if (arg.compare(0, 10, "--emulate=") == 0) {
+      emulate = true;
+      emulationInputPath = arg.substr(10);
+    }
+    if (arg.compare(0, 2, "-j") == 0 &&
+        !mocker::parseNumThreads(arg.substr(2), jobs)) {
+      std::cerr << "invalid number of threads: " << arg << std::endl;
+      return 1;
+    }
+    if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' &&
+        arg[2] <= '3')
+      level = arg[2] - '0';
+    if (arg.compare(0, 9, "--passes=") == 0) {
+      customPasses = true;
+      passes = arg.substr(9);
+    }
+    if (arg == "--time-report")
+      timeReportEnabled = true;
+    if (arg.compare(0, 19, "--time-report-json=") == 0) {
+      timeReportEnabled = true;
+      timeReportPath = arg.substr(19);
+    }
+  }
+
+  // Printed when main returns.
+  mocker::TimeReport report;
+  mocker::Defer printReport;
+  if (timeReportEnabled) {
+    mocker::enableAllocationTracking();
+    mocker::timeReport() = &report;
+    printReport = mocker::Defer([&report, &timeReportPath] {
+      mocker::timeReport() = nullptr;
+      report.printTable(std::cerr);
+      auto &analyses = mocker::getAnalysisManager();
+      std::cerr << "\nanalysis cache: " << analyses.getHits() << " hits, "
+                << analyses.getMisses() << " misses" << std::endl;
+      auto &fixedPoint = fixedPointStats();
+      std::cerr << "fixed point: " << fixedPoint.rounds << " rounds, "
+                << fixedPoint.runs << " runs (" << fixedPoint.productiveRuns
+                << " productive), " << fixedPoint.skippedRuns << " skipped, "
+                << fixedPoint.exhausted << " out of budget" << std::endl;
+      if (!timeReportPath.empty()) {
+        std::ofstream fout(timeReportPath);
+        report.printJson(fout);
+      }
+    });
+  }
+
+  // --passes overrides -O. An empty one only lowers the IR for the codegen.
+  std::unique_ptr<mocker::Pipeline> pipeline;
+  try {
+    if (customPasses)
+      pipeline.reset(new mocker::Pipeline(
+          mocker::Pipeline::parse(mocker::getCustomPipeline(passes))));
+    else if (level < 3)
+      pipeline.reset(new mocker::Pipeline(
+          mocker::Pipeline::parse(mocker::getPresetPipeline(level))));
+  } catch (std::invalid_argument &e) {
+    std::cerr << e.what() << "\nThe passes are:";
+    for (auto &name : mocker::Pipeline::getPassNames())
+      std::cerr << ' ' << name;
+    std::cerr << std::endl;
+    return 1;
+  }
+
+  // The function passes run on [jobs] threads.
+  mocker::ThreadPool pool(jobs);
+  mocker::optimizerThreadPool() = &pool;
+
+  // Collected by running the IR printed by a previous compilation with
+  // "ir-interpreter <ir> --profile=<path>"
+  mocker::ir::Profile profile;
+  if (!profilePath.empty()) {
+    std::ifstream fin(profilePath);
+    profile = mocker::ir::readProfile(fin);
+    mocker::installedProfile() = &profile;
   }
 
-  auto irModule = runFrontend(argv[1]);
+  if (!benchDir.empty()) {
+    runBenchmarks(benchDir, benchJson, pipeline.get());
+    return 0;
+  }
+
+  if (paths.empty()) {
+    std::cerr << "no source file" << std::endl;
+    return 1;
+  }
+  auto irModule = runFrontend(paths[0]);
 
   if (semanticOnly)
     return 0;
 
   mocker::ir::Stats stats(irModule);
-  assert(stats.countInsts<mocker::ir::Phi>() == 0);
-
-  optimize(irModule);
+  assert(stats.getHistogram().countPhis() == 0);
+
+  mocker::PassStatsRecorder recorder;
+  if (!irStatsPath.empty())
+    mocker::passStatsRecorder() = &recorder;
+  {
+    mocker::TimeReport::Scope scope(mocker::timeReport(), "optimization");
+    optimize(irModule, pipeline.get());
+  }
+  mocker::passStatsRecorder() = nullptr;
+  if (!irStatsPath.empty()) {
+    std::ofstream dumpStats(irStatsPath);
+    recorder.printJson(dumpStats);
+  }
 
-  if (argc >= 3) {
-    std::string irPath = argv[2];
+  if (paths.size() >= 2) {
+    auto &irPath = paths[1];
     std::ofstream dumpIR(irPath);
     mocker::ir::printModule(irModule, dumpIR);
+    std::ofstream dumpBinary(irPath + ".bin", std::ios::binary);
+    mocker::ir::serializeModule(irModule, dumpBinary);
   }
 
-  auto nasmModule = codegen(irModule);
-  if (argc >= 4) {
-    std::ofstream fout(argv[3]);
+  std::string emulationInput;
+  if (!emulationInputPath.empty()) {
+    std::ifstream fin(emulationInputPath);
+    std::stringstream sstr;
+    sstr << fin.rdbuf();
+    emulationInput = sstr.str();
+  }
+  auto nasmModule = codegen(irModule, emulate ? &emulationInput : nullptr);
+  if (paths.size() >= 3) {
+    std::ofstream fout(paths[2]);
     mocker::nasm::printModule(nasmModule, fout);
     fout.close();
   } else {
@@ -91,25 +254,40 @@ mocker::ir::Module runFrontend(const std::string &srcPath) {
   std::string src = sstr.str();
 
   std::unordered_map<mocker::ast::NodeID, mocker::PosPair> pos;
-
-  std::vector<mocker::Token> toks = mocker::Lexer(src.begin(), src.end())();
-  mocker::Parser parser(toks.begin(), toks.end(), pos);
-  std::shared_ptr<mocker::ast::ASTNode> p = parser.root();
-  assert(parser.exhausted());
+  using mocker::TimeReport;
+  auto report = mocker::timeReport();
+
+  auto toks = [&] {
+    TimeReport::Scope scope(report, "lexing");
+    return mocker::Lexer(src.begin(), src.end())();
+  }();
+  auto p = [&] {
+    TimeReport::Scope scope(report, "parsing");
+    mocker::Parser parser(toks.begin(), toks.end(), pos);
+    std::shared_ptr<mocker::ast::ASTNode> res = parser.root();
+    assert(parser.exhausted());
+    return res;
+  }();
 
   auto root = std::static_pointer_cast<mocker::ast::ASTRoot>(p);
   assert(root);
   mocker::SemanticChecker semantic(root, pos);
-  semantic.check();
+  {
+    TimeReport::Scope scope(report, "semantic check");
+    semantic.check();
+  }
 
-  auto module = buildIR(root, semantic.getContext());
+  auto module = [&] {
+    TimeReport::Scope scope(report, "IR building");
+    return buildIR(root, semantic.getContext());
+  }();
   for (auto &func : module.getFuncs())
-    func.second.buildContext();
+    func.second.renumberBasicBlocks();
 
   return module;
 }
 
-void optimize(mocker::ir::Module &module) {
+void optimize(mocker::ir::Module &module, const mocker::Pipeline *pipeline) {
   // ATTENTION!
   // * Unreachable blocks should be removed as soon as possible since every
   //   pass that uses the dominator tree requires such blocks having been
@@ -118,15 +296,25 @@ void optimize(mocker::ir::Module &module) {
   using namespace mocker;
 
   mocker::ir::Stats stats(module);
-  std::cerr << "Original:\n";
-  printIRStats(stats);
+  auto stage = [&module, &stats](const std::string &name) {
+    std::cerr << (name == "Original" ? "" : "\n") << name << ":\n";
+    printIRStats(stats);
+    if (auto recorder = dynamicStatsRecorder())
+      recorder->record(name, module);
+  };
+  stage("Original");
+
+  if (pipeline) {
+    pipeline->run(module);
+    stage("After optimization");
+    return;
+  }
 
-  FuncAttr funcAttr;
+  auto &analyses = getAnalysisManager();
 
   runOptPasses<SparseSimpleConstantPropagation>(module);
   runOptPasses<GlobalConstantInline>(module);
 
-  funcAttr.init(module);
   runOptPasses<RemoveUnreachableBlocks>(module);
   runOptPasses<FunctionInline>(module);
   runOptPasses<UnusedFunctionRemoval>(module);
@@ -137,42 +325,35 @@ void optimize(mocker::ir::Module &module) {
 
   runOptPasses<PromoteGlobalVariables>(module);
 
-  std::cerr << "\nAfter inline and promotion of global variables:\n";
-  printIRStats(stats);
+  stage("After inline and promotion of global variables");
 
   runOptPasses<RewriteBranches>(module);
   runOptPasses<SimplifyPhiFunctions>(module);
   runOptPasses<MergeBlocks>(module);
   runOptPasses<RemoveUnreachableBlocks>(module);
 
-  std::cerr << "\nAfter pre-SSA optimization:\n";
-  printIRStats(stats);
+  stage("After pre-SSA optimization");
 
   runOptPasses<SSAConstruction>(module);
-  funcAttr.init(module);
-  runOptPasses<DeadCodeElimination>(module, funcAttr);
+  runOptPasses<DeadCodeElimination>(module, *analyses.getFuncAttr(module));
 
   runOptPasses<RewriteBranches>(module);
   runOptPasses<SimplifyPhiFunctions>(module);
   runOptPasses<MergeBlocks>(module);
   runOptPasses<RemoveUnreachableBlocks>(module);
   runOptsUntilFixedPoint(module);
-  funcAttr.init(module);
-  runOptPasses<LoopInvariantCodeMotion>(module, funcAttr);
+  runOptPasses<LoopInvariantCodeMotion>(module, *analyses.getFuncAttr(module));
   runOptsUntilFixedPoint(module);
 
-  std::cerr << "\nBefore SSA destruction:\n";
-  printIRStats(stats);
+  stage("Before SSA destruction");
   runOptPasses<SSADestruction>(module);
-  assert(stats.countInsts<ir::Phi>() == 0);
+  assert(stats.getHistogram().countPhis() == 0);
 
-  std::cerr << "\nAfter SSA destruction:\n";
-  printIRStats(stats);
+  stage("After SSA destruction");
 
   runOptsUntilFixedPoint(module);
 
-  std::cerr << "\nAfter optimization:\n";
-  printIRStats(stats);
+  stage("After optimization");
 
   runOptPasses<RemoveUnreachableBlocks>(module);
   runOptPasses<SSAConstruction>(module);
@@ -180,92 +361,137 @@ void optimize(mocker::ir::Module &module) {
     runOptPasses<SimplifyPhiFunctions>(module);
     runOptPasses<MergeBlocks>(module);
     runOptPasses<RemoveUnreachableBlocks>(module);
-    funcAttr.init(module);
-    runOptPasses<DeadCodeElimination>(module, funcAttr);
+    runOptPasses<DeadCodeElimination>(module, *analyses.getFuncAttr(module));
     runOptPasses<RemoveUnreachableBlocks>(module);
   }
 
   runOptPasses<CodegenPreparation>(module);
 
-  std::cerr << "\nAfter SSA reconstruction:\n";
-  printIRStats(stats);
+  stage("After SSA reconstruction");
 }
 
-mocker::nasm::Module codegen(const mocker::ir::Module &irModule) {
+mocker::nasm::Module codegen(const mocker::ir::Module &irModule,
+                             const std::string *emulationInput) {
   using namespace mocker;
-  auto res = runInstructionSelection(irModule);
+  auto report = timeReport();
+  auto res = [&] {
+    TimeReport::Scope scope(report, "instruction selection");
+    return runInstructionSelection(irModule);
+  }();
   //  nasm::printModule(res);
 
   std::cerr << "\nNASM:\n";
   std::cerr << "After instruction selection:\n";
   printNasmStats(nasm::Stats(res));
 
-  res = allocateRegisters(res);
+  std::unordered_map<std::string, const ir::FuncProfile *> profiles;
+  for (auto &kv : irModule.getFuncs()) {
+    if (auto profile = findProfile(kv.second))
+      profiles.emplace(renameIdentifier(kv.first), profile);
+  }
+  {
+    TimeReport::Scope scope(report, "register allocation");
+    res = allocateRegisters(res, profiles);
+  }
   //  res = allocateRegistersNaively(res);
   std::cerr << "\nAfter register allocation:\n";
   printNasmStats(nasm::Stats(res));
+  if (emulationInput)
+    printEmulatorStats(res, *emulationInput);
 
   //  nasm::printModule(res, std::cerr);
 
-  res = runPeepholeOptimization(res);
+  {
+    TimeReport::Scope scope(report, "peephole optimization");
+    res = runPeepholeOptimization(res);
+  }
   std::cerr << "\nAfter peephole optimization:\n";
   printNasmStats(nasm::Stats(res));
+  if (emulationInput)
+    printEmulatorStats(res, *emulationInput);
   return res;
 }
 
+// Compile each Mx program in [dir], with the input in the .in file of the same
+// name if any, and record the dynamic statistics at the stages of optimize().
+void runBenchmarks(const std::string &dir, bool json,
+                   const mocker::Pipeline *pipeline) {
+  std::vector<std::string> names;
+  if (auto handle = opendir(dir.c_str())) {
+    while (auto entry = readdir(handle)) {
+      std::string name = entry->d_name;
+      if (name.size() > 3 && name.compare(name.size() - 3, 3, ".mx") == 0)
+        names.emplace_back(name.substr(0, name.size() - 3));
+    }
+    closedir(handle);
+  }
+  std::sort(names.begin(), names.end());
+
+  mocker::DynamicStatsRecorder recorder;
+  for (auto &name : names) {
+    auto path = dir + "/" + name;
+    std::ifstream fin(path + ".in");
+    std::stringstream input;
+    input << fin.rdbuf();
+    recorder.beginProgram(name, input.str());
+
+    auto module = runFrontend(path + ".mx");
+    mocker::dynamicStatsRecorder() = &recorder;
+    optimize(module, pipeline);
+    mocker::dynamicStatsRecorder() = nullptr;
+  }
+
+  if (json)
+    recorder.printJson(std::cout);
+  else
+    recorder.printCsv(std::cout);
+}
+
 void printIRStats(const mocker::ir::Stats &stats) {
-  using namespace mocker::ir;
-  std::cerr << "#BB = " << stats.countBBs() << std::endl;
-  std::cerr << "#insts = " << stats.countInsts<IRInst>() << std::endl;
-  std::cerr << "#phis = " << stats.countInsts<Phi>() << std::endl;
-  std::cerr << "#store and load "
-            << stats.countInsts<Store>() + stats.countInsts<Load>()
-            << std::endl;
+  auto histogram = stats.getHistogram();
+  std::cerr << "#BB = " << histogram.bbs << std::endl;
+  std::cerr << "#insts = " << histogram.countInsts() << std::endl;
+  std::cerr << "#phis = " << histogram.countPhis() << std::endl;
+  std::cerr << "#store and load " << histogram.countMemOps() << std::endl;
 }
 
 void runOptsUntilFixedPoint(mocker::ir::Module &module) {
   using namespace mocker;
-  std::size_t cnt = 0;
-
-  FuncAttr funcAttr;
-  bool optimizable = true;
-  while (optimizable) {
-    ++cnt;
-    optimizable = false;
-
-    optimizable |= runOptPasses<RewriteBranches>(module);
-    optimizable |= runOptPasses<SimplifyPhiFunctions>(module);
-    optimizable |= runOptPasses<MergeBlocks>(module);
-    optimizable |= runOptPasses<RemoveUnreachableBlocks>(module);
-
-    runOptPasses<CopyPropagation>(module);
-    funcAttr.init(module);
-    runOptPasses<InductionVariable>(module, funcAttr);
-    if (cnt <= 2)
-      runOptPasses<Reassociation>(module);
-    optimizable |= runOptPasses<GlobalValueNumbering>(module);
-    optimizable |= runOptPasses<LocalValueNumbering>(module);
-
-    optimizable |= runOptPasses<CopyPropagation>(module);
-    optimizable |= runOptPasses<SparseSimpleConstantPropagation>(module);
-    optimizable |= runOptPasses<CopyPropagation>(module);
-    optimizable |= runOptPasses<SimplifyPhiFunctions>(module);
-    optimizable |= runOptPasses<RemoveUnreachableBlocks>(module);
-    optimizable |= runOptPasses<RewriteBranches>(module);
-    optimizable |= runOptPasses<SimplifyPhiFunctions>(module);
-    optimizable |= runOptPasses<MergeBlocks>(module);
-    optimizable |= runOptPasses<SimplifyPhiFunctions>(module);
-    optimizable |= runOptPasses<RemoveUnreachableBlocks>(module);
-    optimizable |= runOptPasses<RemoveTrivialBlocks>(module);
-    optimizable |= runOptPasses<SimplifyPhiFunctions>(module);
-    optimizable |= runOptPasses<MergeBlocks>(module);
-    optimizable |= runOptPasses<RemoveUnreachableBlocks>(module);
-    funcAttr.init(module);
-    optimizable |= runOptPasses<DeadCodeElimination>(module, funcAttr);
-    optimizable |= runOptPasses<RemoveUnreachableBlocks>(module);
-
-    ir::verifyModule(module);
-  }
+  using S = WorklistScheduler;
+
+  WorklistScheduler scheduler;
+  scheduler.add<RewriteBranches>()
+      .add<SimplifyPhiFunctions>()
+      .add<MergeBlocks>(S::CFGOnly)
+      .add<RemoveUnreachableBlocks>(S::CFGOnly)
+      .add<CopyPropagation>(S::Uncounted)
+      .add<InductionVariable>(S::Uncounted)
+      .add<Reassociation>(S::Uncounted, 2)
+      .add<GlobalValueNumbering>()
+      .add<LocalValueNumbering>()
+      .add<CopyPropagation>()
+      .add<SparseSimpleConstantPropagation>()
+      .add<CopyPropagation>()
+      .add<SimplifyPhiFunctions>()
+      .add<RemoveUnreachableBlocks>(S::CFGOnly)
+      .add<RewriteBranches>()
+      .add<SimplifyPhiFunctions>()
+      .add<MergeBlocks>(S::CFGOnly)
+      .add<SimplifyPhiFunctions>()
+      .add<RemoveUnreachableBlocks>(S::CFGOnly)
+      .add<RemoveTrivialBlocks>()
+      .add<SimplifyPhiFunctions>()
+      .add<MergeBlocks>(S::CFGOnly)
+      .add<RemoveUnreachableBlocks>(S::CFGOnly)
+      .add<DeadCodeElimination>()
+      .add<RemoveUnreachableBlocks>(S::CFGOnly);
+  scheduler.run(module);
+  fixedPointStats() += scheduler.getStats();
+}
+
+mocker::WorklistScheduler::Stats &fixedPointStats() {
+  static mocker::WorklistScheduler::Stats res;
+  return res;
 }
 
 void printNasmStats(const mocker::nasm::Stats &stats) {
@@ -274,3 +500,24 @@ void printNasmStats(const mocker::nasm::Stats &stats) {
   std::cerr << "#insts = " << stats.countInsts() << std::endl;
   std::cerr << "#MemOperation = " << stats.countMemOperation() << std::endl;
 }
+
+void printEmulatorStats(const mocker::nasm::Module &module,
+                        const std::string &input) {
+  std::istringstream in(input);
+  std::ostringstream out;
+  mocker::nasm::Emulator emulator(module);
+  emulator.redirect(in, out);
+  try {
+    std::cerr << "emulated exit = " << emulator.run() << std::endl;
+  } catch (std::runtime_error &e) {
+    std::cerr << "emulation failed: " << e.what() << std::endl;
+  }
+  auto &stats = emulator.getStats();
+  std::cerr << "emulated #insts = " << stats.insts << std::endl;
+  std::cerr << "emulated #load and store = " << stats.loads << ", "
+            << stats.stores << std::endl;
+  std::cerr << "emulated #spill load and store = " << stats.spillLoads << ", "
+            << stats.spillStores << std::endl;
+  std::cerr << "emulated #calls = " << stats.calls << " ("
+            << stats.builtinCalls << " builtin)" << std::endl;
+}
@@ -0,0 +1,154 @@
+#include "analysis_manager.h"
+
+#include <cassert>
+
+namespace mocker {
+namespace {
+
+#ifndef NDEBUG
+std::vector<std::size_t> buildCFGFingerprint(const ir::FunctionModule &func) {
+  std::vector<std::size_t> res;
+  for (auto &bb : func.getBBs()) {
+    res.emplace_back(bb.getLabelID());
+    for (auto succ : bb.getSuccessors())
+      res.emplace_back(succ);
+    res.emplace_back((std::size_t)-1);
+  }
+  return res;
+}
+#endif
+
+} // namespace
+
+template <class T, class Compute>
+std::shared_ptr<const T>
+AnalysisManager::get(const ir::FunctionModule &func,
+                     Cached<T> FuncEntry::*member, bool isCFG,
+                     Compute compute) {
+  auto epoch = func.getEpoch();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &cached = funcs[func.getIdentifier()].*member;
+    if (cached.val && cached.epoch == epoch) {
+      ++hits;
+      return cached.val;
+    }
+    ++misses;
+  }
+
+  // The function is not modified while it is being analyzed, so the
+  // computation need not hold the lock.
+  auto res = std::make_shared<T>();
+  compute(*res);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &entry = funcs[func.getIdentifier()];
+  entry.*member = {epoch, res};
+#ifndef NDEBUG
+  if (isCFG) {
+    entry.cfgEpoch = epoch;
+    entry.cfg = buildCFGFingerprint(func);
+  }
+#else
+  (void)isCFG;
+#endif
+  return res;
+}
+
+std::shared_ptr<const DominatorTree>
+AnalysisManager::getDominatorTree(const ir::FunctionModule &func) {
+  return get(func, &FuncEntry::dominatorTree, true,
+             [&func](DominatorTree &res) { res.init(func); });
+}
+
+std::shared_ptr<const DominatorTree>
+AnalysisManager::getPostDominatorTree(const ir::FunctionModule &func) {
+  return get(func, &FuncEntry::postDominatorTree, true,
+             [&func](DominatorTree &res) { res.init(func, true); });
+}
+
+std::shared_ptr<const LoopInfo>
+AnalysisManager::getLoopInfo(const ir::FunctionModule &func) {
+  return get(func, &FuncEntry::loopInfo, true,
+             [&func](LoopInfo &res) { res.init(func); });
+}
+
+std::shared_ptr<const DefUseChain>
+AnalysisManager::getDefUseChain(const ir::FunctionModule &func) {
+  return get(func, &FuncEntry::defUse, false,
+             [&func](DefUseChain &res) { res.init(func); });
+}
+
+std::shared_ptr<const UseDefChain>
+AnalysisManager::getUseDefChain(const ir::FunctionModule &func) {
+  return get(func, &FuncEntry::useDef, false,
+             [&func](UseDefChain &res) { res.init(func); });
+}
+
+std::shared_ptr<const FuncAttr>
+AnalysisManager::getFuncAttr(const ir::Module &module) {
+  std::vector<std::pair<std::string, std::uint64_t>> epochs;
+  for (auto &func : module.getFuncs())
+    epochs.emplace_back(func.first, func.second.getEpoch());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (funcAttr && epochs == funcAttrEpochs) {
+    ++hits;
+    return funcAttr;
+  }
+  ++misses;
+  auto res = std::make_shared<FuncAttr>();
+  res->init(module);
+  funcAttr = res;
+  funcAttrEpochs = std::move(epochs);
+  return res;
+}
+
+void AnalysisManager::invalidate(const ir::FunctionModule &func,
+                                 std::uint64_t oldEpoch, unsigned preserved) {
+  auto epoch = func.getEpoch();
+  if (epoch == oldEpoch || !preserved)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = funcs.find(func.getIdentifier());
+  if (iter == funcs.end())
+    return;
+  auto &entry = iter->second;
+  auto restamp = [oldEpoch, epoch](auto &cached) {
+    if (cached.val && cached.epoch == oldEpoch)
+      cached.epoch = epoch;
+  };
+  if (preserved & DominatorTreeAnalysis)
+    restamp(entry.dominatorTree);
+  if (preserved & PostDominatorTreeAnalysis)
+    restamp(entry.postDominatorTree);
+  if (preserved & LoopInfoAnalysis)
+    restamp(entry.loopInfo);
+  if (preserved & DefUseAnalysis)
+    restamp(entry.defUse);
+  if (preserved & UseDefAnalysis)
+    restamp(entry.useDef);
+
+#ifndef NDEBUG
+  if ((preserved & CFGAnalyses) && entry.cfgEpoch == oldEpoch) {
+    assert(entry.cfg == buildCFGFingerprint(func) &&
+           "a pass preserving the CFG analyses has changed the CFG");
+    entry.cfgEpoch = epoch;
+  }
+#endif
+}
+
+void AnalysisManager::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  funcs.clear();
+  funcAttrEpochs.clear();
+  funcAttr.reset();
+}
+
+AnalysisManager &getAnalysisManager() {
+  static AnalysisManager res;
+  return res;
+}
+
+} // namespace mocker
@@ -0,0 +1,110 @@
+#ifndef MOCKER_ANALYSIS_MANAGER_H
+#define MOCKER_ANALYSIS_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "defuse.h"
+#include "dominance.h"
+#include "func_attr.h"
+#include "ir/module.h"
+#include "loop_info.h"
+
+namespace mocker {
+
+// The analyses of a function cached by the AnalysisManager. A pass declares
+// those remaining valid after it modifies a function with a static member
+// [Preserved], which is none by default. See OptPass.
+enum Analysis : unsigned {
+  DominatorTreeAnalysis = 1u << 0,
+  PostDominatorTreeAnalysis = 1u << 1,
+  LoopInfoAnalysis = 1u << 2,
+  DefUseAnalysis = 1u << 3,
+  UseDefAnalysis = 1u << 4,
+
+  // Those depending only on the control flow graph
+  CFGAnalyses =
+      DominatorTreeAnalysis | PostDominatorTreeAnalysis | LoopInfoAnalysis,
+};
+
+// Computes the analyses lazily and caches them until the function changes.
+// An analysis computed at an epoch is valid as long as the function remains at
+// that epoch, or has only been modified by passes preserving it. FuncAttr is
+// cached for the module until any function changes.
+//
+// The analyses are handed out as shared pointers, so that a pass may keep
+// using one while the function it describes is modified. The manager may be
+// used by the passes visiting the functions concurrently.
+class AnalysisManager {
+public:
+  std::shared_ptr<const DominatorTree>
+  getDominatorTree(const ir::FunctionModule &func);
+
+  std::shared_ptr<const DominatorTree>
+  getPostDominatorTree(const ir::FunctionModule &func);
+
+  // Without the loop invariant variables, which depend on a FuncAttr
+  std::shared_ptr<const LoopInfo> getLoopInfo(const ir::FunctionModule &func);
+
+  std::shared_ptr<const DefUseChain>
+  getDefUseChain(const ir::FunctionModule &func);
+
+  std::shared_ptr<const UseDefChain>
+  getUseDefChain(const ir::FunctionModule &func);
+
+  std::shared_ptr<const FuncAttr> getFuncAttr(const ir::Module &module);
+
+  // [func] has been modified from [oldEpoch] by a pass preserving the
+  // analyses in [preserved].
+  void invalidate(const ir::FunctionModule &func, std::uint64_t oldEpoch,
+                  unsigned preserved);
+
+  void clear();
+
+  std::size_t getHits() const { return hits; }
+  std::size_t getMisses() const { return misses; }
+
+private:
+  template <class T> struct Cached {
+    std::uint64_t epoch = 0;
+    std::shared_ptr<const T> val;
+  };
+
+  struct FuncEntry {
+    Cached<DominatorTree> dominatorTree, postDominatorTree;
+    Cached<LoopInfo> loopInfo;
+    Cached<DefUseChain> defUse;
+    Cached<UseDefChain> useDef;
+#ifndef NDEBUG
+    // The control flow graph at [cfgEpoch], when a CFG analysis was last
+    // computed, to check the passes claiming to preserve them.
+    std::uint64_t cfgEpoch = 0;
+    std::vector<std::size_t> cfg;
+#endif
+  };
+
+  template <class T, class Compute>
+  std::shared_ptr<const T> get(const ir::FunctionModule &func,
+                               Cached<T> FuncEntry::*member, bool isCFG,
+                               Compute compute);
+
+  std::mutex mutex;
+  std::unordered_map<std::string, FuncEntry> funcs;
+  // The epochs of the functions when [funcAttr] was computed
+  std::vector<std::pair<std::string, std::uint64_t>> funcAttrEpochs;
+  std::shared_ptr<const FuncAttr> funcAttr;
+  std::atomic<std::size_t> hits{0}, misses{0};
+};
+
+// The manager used by the passes.
+AnalysisManager &getAnalysisManager();
+
+} // namespace mocker
+
+#endif // MOCKER_ANALYSIS_MANAGER_H
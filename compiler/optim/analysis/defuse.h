@@ -12,31 +12,30 @@ class DefUseChain {
 public:
   class Use {
   public:
-    Use(std::size_t bbLabel, std::shared_ptr<ir::IRInst> inst)
-        : bbLabel(bbLabel), inst(std::move(inst)) {}
+    Use(std::size_t bbLabel, ir::IRInst *inst) : bbLabel(bbLabel), inst(inst) {}
     Use(const Use &) = default;
     Use &operator=(const Use &) = default;
     ~Use() = default;
 
     const std::size_t getBBLabel() const { return bbLabel; }
 
-    const std::shared_ptr<ir::IRInst> getInst() const { return inst; }
+    ir::IRInst *getInst() const { return inst; }
 
   private:
     std::size_t bbLabel = 0;
-    std::shared_ptr<ir::IRInst> inst;
+    ir::IRInst *inst = nullptr;
   };
 
   void init(const ir::FunctionModule &func) {
     for (auto &bb : func.getBBs()) {
-      for (auto &inst : bb.getInsts()) {
+      for (auto inst : bb.getInsts()) {
         if (auto dest = ir::getDest(inst))
           chain[dest] = {};
       }
     }
 
     for (auto &bb : func.getBBs()) {
-      for (auto &inst : bb.getInsts()) {
+      for (auto inst : bb.getInsts()) {
         auto operands = ir::getOperandsUsed(inst);
         for (auto &operand : operands) {
           auto reg = ir::dycLocalReg(operand);
@@ -64,28 +63,27 @@ class UseDefChain {
 public:
   class Def {
   public:
-    Def(std::size_t bbLabel, std::shared_ptr<ir::IRInst> inst)
-        : bbLabel(bbLabel), inst(std::move(inst)) {}
+    Def(std::size_t bbLabel, ir::IRInst *inst) : bbLabel(bbLabel), inst(inst) {}
     Def(const Def &) = default;
     Def &operator=(const Def &) = default;
     ~Def() = default;
 
     const std::size_t getBBLabel() const { return bbLabel; }
 
-    const std::shared_ptr<ir::IRInst> &getInst() const { return inst; }
+    ir::IRInst *getInst() const { return inst; }
 
   private:
     std::size_t bbLabel = 0;
-    std::shared_ptr<ir::IRInst> inst;
+    ir::IRInst *inst = nullptr;
   };
 
   void init(const ir::FunctionModule &func) {
     for (auto &bb : func.getBBs()) {
-      for (auto &inst : bb.getInsts()) {
+      for (auto inst : bb.getInsts()) {
         auto dest = ir::getDest(inst);
         if (!dest)
           continue;
-        chain.emplace(std::make_pair(dest, Def(bb.getLabelID(), inst)));
+        chain.emplace(dest, Def(bb.getLabelID(), inst));
       }
     }
   }
@@ -4,26 +4,22 @@
 #include <functional>
 
 #include "optim/helper.h"
-#include "set_operation.h"
 
 namespace mocker {
 namespace {
-template <class T> using LabelMap = std::unordered_map<std::size_t, T>;
-using LabelSet = std::unordered_set<std::size_t>;
 
-std::unordered_set<std::size_t> buildDominatingImpl(
-    const ir::FunctionModule &func, std::size_t node,
-    const std::unordered_map<std::size_t, std::vector<std::size_t>> &preds) {
+ir::LabelSet
+buildDominatingImpl(const ir::FunctionModule &func, std::size_t node,
+                    const ir::LabelMap<std::vector<std::size_t>> &preds) {
   // Construct the set [avoidable] of nodes which are reachable from the entry
   // without passing [node]. The nodes dominated by [node] are just the nodes
   // which are not in [avoidable].
   bool reverse = !preds.empty();
-  std::unordered_set<std::size_t> avoidable;
+  ir::LabelSet avoidable;
   std::function<void(std::size_t cur)> visit =
       [&visit, &avoidable, node, &preds, &func, reverse](std::size_t cur) {
-        if (cur == node || avoidable.find(cur) != avoidable.end())
+        if (cur == node || !avoidable.emplace(cur).second)
           return;
-        avoidable.emplace(cur);
         if (!reverse) {
           for (auto suc : func.getBasicBlock(cur).getSuccessors())
             visit(suc);
@@ -40,11 +36,10 @@ std::unordered_set<std::size_t> buildDominatingImpl(
         visit(bb.getLabelID());
   }
 
-  std::unordered_set<std::size_t> res;
-  for (const auto &bb : func.getBBs()) {
-    if (!isIn(avoidable, bb.getLabelID()))
-      res.emplace(bb.getLabelID());
-  }
+  ir::LabelSet res;
+  for (const auto &bb : func.getBBs())
+    res.emplace(bb.getLabelID());
+  res.subtract(avoidable);
   return res;
 }
 
@@ -66,17 +61,16 @@ void DominatorTree::init(const ir::FunctionModule &func, bool reverse_) {
 }
 
 void DominatorTree::buildDominating(const ir::FunctionModule &func) {
+  auto preds = reverse ? buildBlockPredecessors(func)
+                       : ir::LabelMap<std::vector<std::size_t>>();
   for (const auto &bb : func.getBBs()) {
-    auto preds =
-        reverse ? buildBlockPredecessors(func)
-                : std::unordered_map<std::size_t, std::vector<std::size_t>>();
     dominating[bb.getLabelID()] =
         buildDominatingImpl(func, bb.getLabelID(), preds);
   }
 }
 
 bool DominatorTree::isDominating(std::size_t u, std::size_t v) const {
-  return isIn(dominating.at(u), v);
+  return dominating.at(u).count(v);
 }
 
 bool DominatorTree::isStrictlyDominating(std::size_t u, std::size_t v) const {
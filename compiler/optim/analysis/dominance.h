@@ -1,8 +1,6 @@
 #ifndef MOCKER_DOMINANCE_H
 #define MOCKER_DOMINANCE_H
 
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "ir/module.h"
@@ -13,7 +13,7 @@ std::vector<std::string> collectCallees(const ir::FunctionModule &func) {
   std::vector<std::string> res;
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto call = ir::dyc<ir::Call>(inst);
       if (!call)
         continue;
@@ -82,7 +82,7 @@ void FuncAttr::buildGlobalVarInfo(const ir::Module &module) {
     auto &fUse = globalVarUses[kv.first];
     auto &fDef = globalVarDefs[kv.first];
 
-    auto update = [&fUse, &fDef](const std::shared_ptr<ir::IRInst> &inst) {
+    auto update = [&fUse, &fDef](const ir::IRInst *inst) {
       if (auto p = ir::dyc<ir::Store>(inst)) {
         if (auto reg = ir::dycGlobalReg(p->getAddr()))
           fDef.emplace(reg->getIdentifier());
@@ -96,7 +96,7 @@ void FuncAttr::buildGlobalVarInfo(const ir::Module &module) {
     };
 
     for (auto &bb : func.getBBs()) {
-      for (auto &inst : bb.getInsts())
+      for (auto inst : bb.getInsts())
         update(inst);
     }
   }
@@ -164,7 +164,7 @@ void FuncAttr::buildGlobalVarInfo(const ir::Module &module) {
 
 bool FuncAttr::isPureFunc(const ir::FunctionModule &func) {
   std::unordered_set<std::string> stackVar;
-  for (auto &inst : func.getBasicBlock(func.getFirstBBLabel()).getInsts()) {
+  for (auto inst : func.getBasicBlock(func.getFirstBBLabel()).getInsts()) {
     auto alloca = ir::dyc<ir::Alloca>(inst);
     if (!alloca)
       continue;
@@ -172,7 +172,7 @@ bool FuncAttr::isPureFunc(const ir::FunctionModule &func) {
   }
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       if (auto p = ir::dyc<ir::Store>(inst)) {
         auto reg = ir::dycLocalReg(p->getAddr());
         if (!reg || !isIn(stackVar, reg->getIdentifier()))
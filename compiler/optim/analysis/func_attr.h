@@ -32,6 +32,13 @@ public:
     return isIn(pureFuncs, funcName);
   }
 
+  bool operator==(const FuncAttr &rhs) const {
+    return globalVarUses == rhs.globalVarUses &&
+           globalVarDefs == rhs.globalVarDefs && pureFuncs == rhs.pureFuncs;
+  }
+
+  bool operator!=(const FuncAttr &rhs) const { return !(*this == rhs); }
+
 private:
   void buildGlobalVarInfo(const ir::Module & module);
 
@@ -3,8 +3,6 @@
 #include <cassert>
 #include <functional>
 #include <queue>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -40,9 +38,9 @@ findBackEdges(const DominatorTree &dominatorTree,
 }
 
 // Find the natural loop corresponding to the back edge n -> h
-std::vector<std::size_t> findNaturalLoop(const DominatorTree &dominatorTree,
-                                         const ir::FunctionModule &func,
-                                         std::size_t n, std::size_t h) {
+ir::LabelSet findNaturalLoop(const DominatorTree &dominatorTree,
+                             const ir::FunctionModule &func, std::size_t n,
+                             std::size_t h) {
   // NaturalLoop(h, n) =
   //   {x | h dominates x and there exists a path from x to n not passing h}
   // To construct NaturalLoop(h, n), we first traverse the CFG backward from n
@@ -51,28 +49,26 @@ std::vector<std::size_t> findNaturalLoop(const DominatorTree &dominatorTree,
 
   auto Preds = buildBlockPredecessors(func);
 
-  std::unordered_set<std::size_t> visited;
+  ir::LabelSet visited;
   std::function<void(std::size_t)> dfs = [h, &Preds, &dfs,
                                           &visited](std::size_t cur) {
-    if (isIn(visited, cur) || cur == h)
+    if (cur == h || !visited.emplace(cur).second)
       return;
-    visited.emplace(cur);
     for (auto pred : Preds.at(cur))
       dfs(pred);
   };
   dfs(n);
 
-  std::vector<std::size_t> res;
+  ir::LabelSet res;
   for (auto x : visited) {
     if (dominatorTree.isDominating(h, x))
-      res.emplace_back(x);
+      res.emplace(x);
   }
   return res;
 }
 
-std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
-    std::unordered_map<std::size_t, std::unordered_set<std::size_t>> loops) {
-  std::unordered_map<std::size_t, std::unordered_set<std::size_t>> res;
+ir::LabelMap<ir::LabelSet> buildLoopTree(ir::LabelMap<ir::LabelSet> loops) {
+  ir::LabelMap<ir::LabelSet> res;
 
   //  std::cerr << "Loops:\n";
   //  for (auto & loop : loops) {
@@ -87,11 +83,11 @@ std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
   const auto Bak = loops;
 
   loops.clear();
-  std::vector<std::size_t> loopNodes;
+  ir::LabelSet loopNodes;
   for (auto &kv : Bak) {
     res[kv.first] = {};
     if (kv.second.size() > 1) {
-      loopNodes.emplace_back(kv.first);
+      loopNodes.emplace(kv.first);
       loops[kv.first] = Bak.at(kv.first);
     }
   }
@@ -99,7 +95,7 @@ std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
   std::queue<std::size_t> worklist;
   std::vector<std::size_t> toBeRemoved;
   for (auto &kv : loops) {
-    intersectSet(kv.second, loopNodes);
+    kv.second.intersectWith(loopNodes);
     assert(!kv.second.empty());
     if (kv.second.size() == 1) {
       worklist.emplace(kv.first);
@@ -107,7 +103,7 @@ std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
     }
   }
   for (auto &n : toBeRemoved) {
-    loops.erase(loops.find(n));
+    loops.erase(n);
   }
   toBeRemoved.clear();
 
@@ -120,9 +116,9 @@ std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
     for (auto &kv : loops) {
       auto pnt = kv.first;
       auto &loop = kv.second;
-      if (!isIn(loop, leaf))
+      if (!loop.count(leaf))
         continue;
-      subSet(loop, Bak.at(leaf));
+      loop.subtract(Bak.at(leaf));
       if (loop.size() == 1) {
         res[pnt].emplace(leaf);
         worklist.emplace(pnt);
@@ -130,7 +126,7 @@ std::unordered_map<std::size_t, std::unordered_set<std::size_t>> buildLoopTree(
       }
     }
     for (auto &n : toBeRemoved) {
-      loops.erase(loops.find(n));
+      loops.erase(n);
     }
   }
 
@@ -166,8 +162,7 @@ void LoopInfo::init(const ir::FunctionModule &func) {
   const auto BackEdges = findBackEdges(dominatorTree, func);
   for (auto &backEdge : BackEdges) {
     auto h = backEdge.second, n = backEdge.first;
-    const auto NaturalLoop = findNaturalLoop(dominatorTree, func, n, h);
-    unionSet(loops.at(h), NaturalLoop);
+    loops.at(h).unionWith(findNaturalLoop(dominatorTree, func, n, h));
   }
 
   loopTree = buildLoopTree(loops);
@@ -177,13 +172,12 @@ void LoopInfo::init(const ir::FunctionModule &func) {
 std::vector<std::size_t> LoopInfo::postOrder() const {
   std::vector<std::size_t> res;
 
-  std::unordered_set<std::size_t> visited;
+  ir::LabelSet visited;
   std::function<void(std::size_t)> dfs = [&res, &visited, &dfs,
                                           this](std::size_t cur) {
-    if (isIn(visited, cur))
+    if (!visited.emplace(cur).second)
       return;
-    visited.emplace(cur);
-    auto children = loopTree.at(cur);
+    const auto &children = loopTree.at(cur);
     for (auto ch : children)
       dfs(ch);
     res.emplace_back(cur);
@@ -196,7 +190,7 @@ std::vector<std::size_t> LoopInfo::postOrder() const {
 void LoopInfo::buildDepth() {
   std::function<void(std::size_t, std::size_t)> dfs =
       [this, &dfs](std::size_t cur, std::size_t curDepth) {
-        for (auto &node : loops.at(cur))
+        for (auto node : loops.at(cur))
           depth[node] = std::max(depth[node], curDepth);
         for (auto child : loopTree.at(cur))
           dfs(child, curDepth + 1);
@@ -213,7 +207,7 @@ ir::RegSet LoopInfo::findLoopInvariantVariables(const ir::FunctionModule &func,
   ir::RegSet res;
 
   auto isLoopInvariant = [&res, &loopNodes, &useDef,
-                          &func](const std::shared_ptr<ir::IRInst> &inst) {
+                          &func](const ir::IRInst *inst) {
     auto operands = ir::getOperandsUsed(inst);
     for (auto &operand : operands) {
       auto reg = ir::dycLocalReg(operand);
@@ -236,7 +230,7 @@ ir::RegSet LoopInfo::findLoopInvariantVariables(const ir::FunctionModule &func,
 
   for (auto node : loopNodes) {
     const auto &bb = func.getBasicBlock(node);
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       if (!ir::dyc<ir::Assign>(inst) && !ir::dyc<ir::ArithUnaryInst>(inst) &&
           !ir::dyc<ir::ArithBinaryInst>(inst) &&
           !ir::dyc<ir::RelationInst>(inst) && !ir::dyc<ir::Call>(inst))
@@ -1,8 +1,6 @@
 #ifndef MOCKER_LOOP_INFO_H
 #define MOCKER_LOOP_INFO_H
 
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "defuse.h"
@@ -19,10 +17,7 @@ public:
   // Also find all loop invariant variables
   void init(const ir::FunctionModule &func, const FuncAttr &funcAttr);
 
-  const std::unordered_map<std::size_t, std::unordered_set<std::size_t>> &
-  getLoops() const {
-    return loops;
-  }
+  const ir::LabelMap<ir::LabelSet> &getLoops() const { return loops; }
 
   // inner loops first traversal
   std::vector<std::size_t> postOrder() const;
@@ -49,15 +44,15 @@ private:
 private:
   // The mapping from the headers to the union of the natural loops
   // If loops[x] is contains only itself, then x is not a header of any loop.
-  std::unordered_map<std::size_t, std::unordered_set<std::size_t>> loops;
+  ir::LabelMap<ir::LabelSet> loops;
 
   // The loop tree, where each loop is represented by its header.
-  std::unordered_map<std::size_t, std::unordered_set<std::size_t>> loopTree;
+  ir::LabelMap<ir::LabelSet> loopTree;
   std::size_t root = (std::size_t)-1;
 
-  std::unordered_map<std::size_t, std::size_t> depth;
+  ir::LabelMap<std::size_t> depth;
 
-  std::unordered_map<std::size_t, ir::RegSet> loopInvariant;
+  ir::LabelMap<ir::RegSet> loopInvariant;
 };
 
 } // namespace mocker
@@ -5,11 +5,13 @@
 #include <unordered_set>
 #include <vector>
 
+#include "analysis/analysis_manager.h"
 #include "analysis/defuse.h"
 #include "helper.h"
 #include "ir/helper.h"
 #include "ir/ir_inst.h"
 #include "optim/global_value_numbering.h"
+#include "optim/profile_use.h"
 #include "set_operation.h"
 
 #include "ir/printer.h"
@@ -39,7 +41,6 @@ std::vector<std::size_t> getPreOrder(const ir::FunctionModule &func) {
 
 bool CodegenPreparation::operator()() {
   sortBlocks();
-  func.buildContext();
   for (auto &bb : func.getMutableBBs())
     scheduleCmps(bb);
   removeDeletedInsts(func);
@@ -52,7 +53,8 @@ bool CodegenPreparation::operator()() {
 }
 
 void CodegenPreparation::sortBlocks() {
-  loopTree.init(func);
+  auto loopTree = getAnalysisManager().getLoopInfo(func);
+  auto profile = findProfile(func);
 
   const auto PreOrder = getPreOrder(func);
 
@@ -72,7 +74,7 @@ void CodegenPreparation::sortBlocks() {
       continue;
     }
 
-    if (loopTree.isLoopHeader(n)) {
+    if (loopTree->isLoopHeader(n)) {
       auto nxt = br->getThen()->getID();
       order.emplace_back(nxt);
       visited.emplace(nxt);
@@ -81,8 +83,16 @@ void CodegenPreparation::sortBlocks() {
 
     auto &thenBB = func.getBasicBlock(br->getThen()->getID());
     auto &elseBB = func.getBasicBlock(br->getElse()->getID());
-    if (ir::dyc<ir::Ret>(thenBB.getInsts().back()) &&
-        !isIn(visited, elseBB.getLabelID())) {
+    // Place the successor taken more often right after the branch. Without a
+    // profile, prefer the one that does not return immediately.
+    bool preferElse = ir::dyc<ir::Ret>(thenBB.getInsts().back()) != nullptr;
+    if (profile) {
+      auto thenCnt = profile->getEdgeCount(n, thenBB.getLabelID());
+      auto elseCnt = profile->getEdgeCount(n, elseBB.getLabelID());
+      if (thenCnt != elseCnt)
+        preferElse = elseCnt > thenCnt;
+    }
+    if (preferElse && !isIn(visited, elseBB.getLabelID())) {
       order.emplace_back(elseBB.getLabelID());
       visited.emplace(elseBB.getLabelID());
     } else if (!isIn(visited, thenBB.getLabelID())) {
@@ -93,16 +103,15 @@ void CodegenPreparation::sortBlocks() {
 
   assert(order.size() == PreOrder.size());
 
-  ir::BasicBlockList newBBs;
-  for (auto cur : order) {
-    for (auto &bb : func.getBBs()) {
-      if (bb.getLabelID() != cur)
-        continue;
-      newBBs.emplace_back(bb);
-      break;
-    }
-  }
-  func.getMutableBBs() = std::move(newBBs);
+  ir::LabelMap<ir::BBLIter> pos;
+  for (auto iter = func.getMutableBBs().begin();
+       iter != func.getMutableBBs().end(); ++iter)
+    pos[iter->getLabelID()] = iter;
+  for (auto cur : order)
+    func.moveBB(func.getMutableBBs().end(), pos.at(cur));
+  func.removeBBIf([&visited](const ir::BasicBlock &bb) {
+    return !isIn(visited, bb.getLabelID());
+  });
 }
 
 void CodegenPreparation::scheduleCmps(ir::BasicBlock &bb) {
@@ -140,8 +149,10 @@ void CodegenPreparation::scheduleCmps(ir::BasicBlock &bb) {
     return;
 
   //  std::cerr << ir::fmtInst(*riter) << std::endl;
-  bb.appendInstBeforeTerminator(*riter);
-  *riter = std::make_shared<ir::Deleted>();
+  auto defInst = *riter;
+  auto &insts = bb.getMutableInsts();
+  insts.erase(insts.iteratorTo(defInst));
+  bb.appendInstBeforeTerminator(defInst);
 }
 
 namespace {
@@ -160,8 +171,9 @@ int getNonzeroPos(std::uint64_t n) {
 
 void CodegenPreparation::naiveStrengthReduction() {
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      auto binary = ir::dyc<ir::ArithBinaryInst>(inst);
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      auto binary = ir::dyc<ir::ArithBinaryInst>(*iter);
       if (!binary)
         continue;
       auto lhs = binary->getLhs(), rhs = binary->getRhs();
@@ -171,25 +183,25 @@ void CodegenPreparation::naiveStrengthReduction() {
         std::swap(lhs, rhs);
       auto lit = ir::dyc<ir::IntLiteral>(rhs);
 
-      if (binary->getOp() == ir::ArithBinaryInst::Mul ||
-          binary->getOp() == ir::ArithBinaryInst::Div) {
+      // A division can not become a shift, which rounds a negative dividend
+      // toward negative infinity instead of zero.
+      if (binary->getOp() == ir::ArithBinaryInst::Mul) {
         if (!lit || lit->getVal() <= 0)
           continue;
         auto pos = getNonzeroPos(lit->getVal());
         if (pos == -1)
           continue;
-        inst = std::make_shared<ir::ArithBinaryInst>(
-            binary->getDest(),
-            binary->getOp() == ir::ArithBinaryInst::Mul
-                ? ir::ArithBinaryInst::Shl
-                : ir::ArithBinaryInst::Shr,
-            lhs, std::make_shared<ir::IntLiteral>(pos));
+        auto shift = func.makeInst<ir::ArithBinaryInst>(
+            binary->getDest(), ir::ArithBinaryInst::Shl, lhs,
+            std::make_shared<ir::IntLiteral>(pos));
+        iter = insts.replace(iter, shift);
         continue;
       }
 
       if (binary->getOp() == ir::ArithBinaryInst::Add && lit &&
           lit->getVal() == 0) {
-        inst = std::make_shared<ir::Assign>(binary->getDest(), lhs);
+        iter = insts.replace(iter,
+                             func.makeInst<ir::Assign>(binary->getDest(), lhs));
         continue;
       }
     }
@@ -197,11 +209,12 @@ void CodegenPreparation::naiveStrengthReduction() {
 }
 
 void CodegenPreparation::removeRedundantLoadStore(ir::BasicBlock &bb) {
-  auto iter = bb.getMutableInsts().begin();
+  auto &insts = bb.getMutableInsts();
+  auto iter = insts.begin();
   auto nextIter = iter;
   nextIter++;
 
-  for (auto end = bb.getMutableInsts().end(); nextIter != end;
+  for (auto end = insts.end(); nextIter != end;
        ++iter, ++nextIter) {
     auto load = ir::dyc<ir::Load>(*iter);
     auto store = ir::dyc<ir::Store>(*nextIter);
@@ -210,10 +223,11 @@ void CodegenPreparation::removeRedundantLoadStore(ir::BasicBlock &bb) {
     auto lAddr = ir::dyc<ir::Reg>(load->getAddr());
     auto sAddr = ir::dyc<ir::Reg>(store->getAddr());
     assert(lAddr && sAddr);
-    if (lAddr->getIdentifier() != sAddr->getIdentifier())
+    if (lAddr->getIdentifier() != sAddr->getIdentifier() ||
+        load->getWidth() != store->getWidth())
       continue;
-    *iter = std::make_shared<ir::Deleted>();
-    *nextIter = std::make_shared<ir::Deleted>();
+    iter = insts.replace(iter, func.makeInst<ir::Deleted>());
+    nextIter = insts.replace(nextIter, func.makeInst<ir::Deleted>());
   }
 }
 
@@ -3,8 +3,6 @@
 
 #include "opt_pass.h"
 
-#include "optim/analysis/loop_info.h"
-
 namespace mocker {
 
 class CodegenPreparation : public FuncPass {
@@ -24,9 +22,6 @@ private:
   // x = load addr
   // store addr x
   void removeRedundantLoadStore(ir::BasicBlock & bb);
-
-private:
-  LoopInfo loopTree;
 };
 
 } // namespace mocker
@@ -25,7 +25,7 @@ bool SparseSimpleConstantPropagation::operator()() {
 }
 
 void SparseSimpleConstantPropagation::buildInstDefineAndInstsUse() {
-  auto updateInstsUse = [&](const std::shared_ptr<ir::IRInst> &inst) {
+  auto updateInstsUse = [&](ir::IRInst *inst) {
     auto operands = ir::getOperandsUsed(inst);
     for (auto &operand : operands) {
       if (auto p = ir::dycLocalReg(operand))
@@ -34,7 +34,7 @@ void SparseSimpleConstantPropagation::buildInstDefineAndInstsUse() {
   };
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto dest = ir::getDest(inst);
       if (!dest)
         continue;
@@ -79,8 +79,7 @@ void SparseSimpleConstantPropagation::propagate() {
 }
 
 void SparseSimpleConstantPropagation::rewrite() {
-  auto rewriteIfPossible = [&](const std::shared_ptr<ir::IRInst> &inst)
-      -> std::shared_ptr<ir::IRInst> {
+  auto rewriteIfPossible = [&](ir::IRInst *inst) -> ir::IRInst * {
     auto dest = ir::dycLocalReg(ir::getDest(inst));
     if (dest) {
       auto destName = dest->getIdentifier();
@@ -89,29 +88,29 @@ void SparseSimpleConstantPropagation::rewrite() {
         // All the insts that use this value will be rewrite so that they use
         // the constant directly. This inst can therefore be deleted.
         ++modificationCnt;
-        return std::make_shared<ir::Deleted>();
+        return func.makeInst<ir::Deleted>();
       }
     }
 
-    // Rewrite the operands
-    auto operands = ir::getOperandsUsed(inst);
-    for (auto &operand : operands) {
-      auto reg = ir::dycLocalReg(operand);
+    // Rewrite the operands in place
+    for (std::size_t i = 0; i < inst->getNumOperands(); ++i) {
+      auto reg = ir::dycLocalReg(inst->getOperand(i));
       if (!reg)
         continue;
       auto name = reg->getIdentifier();
       auto val = values[name];
       if (val.type == Value::Constant) {
         ++modificationCnt;
-        operand = std::make_shared<ir::IntLiteral>(val.val);
+        func.setOperand(inst, i, std::make_shared<ir::IntLiteral>(val.val));
       }
     }
-    return ir::copyWithReplacedOperands(inst, operands);
+    return inst;
   };
 
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts())
-      inst = rewriteIfPossible(inst);
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter)
+      iter = insts.replace(iter, rewriteIfPossible(*iter));
   }
 }
 
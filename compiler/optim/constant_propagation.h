@@ -5,6 +5,7 @@
 #include <queue>
 #include <unordered_map>
 
+#include "analysis/analysis_manager.h"
 #include "opt_pass.h"
 
 namespace mocker {
@@ -14,6 +15,8 @@ class SparseSimpleConstantPropagation : public FuncPass {
 public:
   explicit SparseSimpleConstantPropagation(ir::FunctionModule &func);
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 
 private:
@@ -48,9 +51,8 @@ private:
   Value getValue(const std::shared_ptr<ir::Addr> &addr);
 
 private:
-  std::unordered_map<std::string, std::shared_ptr<ir::IRInst>> instDefine;
-  std::unordered_map<std::string, std::vector<std::shared_ptr<ir::IRInst>>>
-      instsUse;
+  std::unordered_map<std::string, ir::IRInst *> instDefine;
+  std::unordered_map<std::string, std::vector<ir::IRInst *>> instsUse;
   std::unordered_map<std::string, Value> values; // values of an SSA name
   std::queue<std::string> workList;
 
@@ -3,6 +3,8 @@
 #include <cassert>
 #include <functional>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "ir/helper.h"
 
@@ -18,6 +20,8 @@ bool CopyPropagation::operator()() {
 
 void CopyPropagation::buildValue() {
   std::unordered_set<std::size_t> visited;
+  // value[dest] = iter->second must not move the entry [iter] points to.
+  value.reserve(func.getRegTable().size());
 
   std::function<void(std::size_t)> impl = [this, &visited,
                                            &impl](std::size_t bbLabel) {
@@ -26,24 +30,23 @@ void CopyPropagation::buildValue() {
     visited.emplace(bbLabel);
     const auto &bb = func.getBasicBlock(bbLabel);
 
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto assign = ir::dyc<ir::Assign>(inst);
       if (!assign)
         continue;
-      auto destName = ir::dycLocalReg(assign->getDest())->getIdentifier();
+      auto dest = ir::dycLocalReg(assign->getDest());
       auto val = assign->getOperand();
       if (ir::dyc<ir::IntLiteral>(val) || ir::dycGlobalReg(val)) {
-        value[destName] = val;
+        value[dest] = val;
         continue;
       }
       if (auto reg = ir::dycLocalReg(val)) {
-        auto iter = value.find(reg->getIdentifier());
+        auto iter = value.find(reg);
         if (iter != value.end()) {
-          value[destName] = iter->second;
+          value[dest] = iter->second;
           continue;
         }
-        auto &tmp = value[destName];
-        tmp = val;
+        value[dest] = val;
         continue;
       }
       assert(false);
@@ -57,22 +60,16 @@ void CopyPropagation::buildValue() {
 }
 
 void CopyPropagation::rewrite() {
-  for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      auto operands = ir::getOperandsUsed(inst);
-      for (auto &operand : operands) {
-        auto reg = ir::dycLocalReg(operand);
-        if (!reg)
-          continue;
-        auto iter = value.find(reg->getIdentifier());
-        if (iter == value.end())
-          continue;
-        operand = iter->second;
-        ++cnt;
-      }
-      inst = ir::copyWithReplacedOperands(inst, operands);
-    }
+  // Collect the uses first, so that each operand is substituted at most once.
+  std::vector<std::pair<ir::Use, std::shared_ptr<ir::Addr>>> replacements;
+  for (auto &kv : value) {
+    for (auto &use : func.getUses(kv.first))
+      replacements.emplace_back(use, kv.second);
   }
+  for (auto &replacement : replacements)
+    func.setOperand(replacement.first.user, replacement.first.idx,
+                    replacement.second);
+  cnt += replacements.size();
 }
 
 } // namespace mocker
@@ -1,9 +1,10 @@
 #ifndef MOCKER_COPY_PROPAGATION_H
 #define MOCKER_COPY_PROPAGATION_H
 
+#include "analysis/analysis_manager.h"
 #include "opt_pass.h"
 
-#include <unordered_map>
+#include "ir/reg_table.h"
 
 namespace mocker {
 
@@ -11,6 +12,8 @@ class CopyPropagation : public FuncPass {
 public:
   explicit CopyPropagation(ir::FunctionModule &func);
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 
 private:
@@ -20,7 +23,7 @@ private:
 
 private:
   // The value to propagate
-  std::unordered_map<std::string, std::shared_ptr<ir::Addr>> value;
+  ir::RegMap<std::shared_ptr<ir::Addr>> value;
   std::size_t cnt = 0;
 };
 
@@ -15,7 +15,7 @@ DeadCodeElimination::DeadCodeElimination(ir::FunctionModule &func,
     : FuncPass(func), funcAttr(funcAttr) {}
 
 bool DeadCodeElimination::operator()() {
-  rdt.init(func, true);
+  rdt = getAnalysisManager().getPostDominatorTree(func);
   init();
   mark();
   sweep();
@@ -34,7 +34,7 @@ bool DeadCodeElimination::isParameter(const std::string &identifier) {
 }
 
 void DeadCodeElimination::init() {
-  auto isCritical = [this](const std::shared_ptr<ir::IRInst> &inst) -> bool {
+  auto isCritical = [this](const ir::IRInst *inst) -> bool {
     if (auto call = ir::dyc<ir::Call>(inst)) {
       return !funcAttr.isPure(call->getFuncName());
     }
@@ -42,7 +42,7 @@ void DeadCodeElimination::init() {
   };
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       residingBB[inst->getID()] = bb.getLabelID();
       if (!isCritical(inst))
         continue;
@@ -53,7 +53,7 @@ void DeadCodeElimination::init() {
 }
 
 void DeadCodeElimination::mark() {
-  std::unordered_map<std::string, std::shared_ptr<ir::IRInst>> instDefine =
+  std::unordered_map<std::string, ir::IRInst *> instDefine =
       buildInstDefine(func);
 
   auto markUsefulBB = [this](std::size_t label) {
@@ -88,7 +88,7 @@ void DeadCodeElimination::mark() {
     }
 
     auto curBB = residingBB.at(inst->getID());
-    for (auto label : rdt.getDominanceFrontier(curBB)) {
+    for (auto label : rdt->getDominanceFrontier(curBB)) {
       markUsefulBB(label);
     }
   }
@@ -96,24 +96,26 @@ void DeadCodeElimination::mark() {
 
 void DeadCodeElimination::sweep() {
   for (auto &bb : func.getMutableBBs()) {
-    ir::InstList newInsts;
-    for (auto &inst : bb.getInsts()) {
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end();) {
+      auto inst = *iter;
       if (isIn(useful, inst->getID()) || ir::dyc<ir::Jump>(inst)) {
-        newInsts.emplace_back(inst);
+        ++iter;
         continue;
       }
       auto br = ir::dyc<ir::Branch>(inst);
-      if (!br)
+      if (!br) {
+        iter = insts.erase(iter);
+        ++cnt;
         continue;
-      auto target = rdt.getImmediateDominator(bb.getLabelID());
+      }
+      auto target = rdt->getImmediateDominator(bb.getLabelID());
       while (!isIn(usefulBB, target))
-        target = rdt.getImmediateDominator(target);
-      newInsts.emplace_back(
-          std::make_shared<ir::Jump>(std::make_shared<ir::Label>(target)));
+        target = rdt->getImmediateDominator(target);
+      iter = insts.replace(
+          iter, func.makeInst<ir::Jump>(std::make_shared<ir::Label>(target)));
+      ++iter;
     }
-
-    cnt += bb.getInsts().size() - newInsts.size();
-    bb.getMutableInsts() = std::move(newInsts);
   }
 }
 
@@ -1,11 +1,12 @@
 #ifndef MOCKER_DEAD_CODE_ELIMINATION_H
 #define MOCKER_DEAD_CODE_ELIMINATION_H
 
+#include <memory>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
 
-#include "analysis/dominance.h"
+#include "analysis/analysis_manager.h"
 #include "analysis/func_attr.h"
 #include "ir/ir_inst.h"
 #include "opt_pass.h"
@@ -30,11 +31,11 @@ private:
 private:
   const FuncAttr &funcAttr;
 
-  DominatorTree rdt;
-  std::queue<std::shared_ptr<ir::IRInst>> worklist;
+  std::shared_ptr<const DominatorTree> rdt;
+  std::queue<ir::IRInst *> worklist;
   std::unordered_map<ir::InstID, std::size_t> residingBB;
   std::unordered_set<ir::InstID> useful;
-  std::unordered_set<std::size_t> usefulBB; // contains a useful instruction
+  ir::LabelSet usefulBB; // contains a useful instruction
   std::size_t cnt = 0;
 };
 
@@ -0,0 +1,84 @@
+#include "dynamic_stats.h"
+
+#include <cassert>
+#include <sstream>
+
+#include "interpreter.h"
+
+namespace mocker {
+
+void DynamicStatsRecorder::beginProgram(std::string name, std::string input) {
+  programs.emplace_back();
+  programs.back().name = std::move(name);
+  programs.back().input = std::move(input);
+}
+
+void DynamicStatsRecorder::record(std::string stage,
+                                  const ir::Module &module) {
+  assert(!programs.empty());
+  auto &program = programs.back();
+
+  std::istringstream in(program.input);
+  std::ostringstream out;
+  ir::Interpreter interpreter(module);
+  interpreter.redirect(in, out);
+  interpreter.enableProfiling();
+  auto exitCode = interpreter.run();
+
+  if (program.records.empty())
+    program.output = out.str();
+  program.records.push_back({std::move(stage), exitCode,
+                             out.str() == program.output,
+                             interpreter.getDynamicHistogram()});
+}
+
+void DynamicStatsRecorder::printCsv(std::ostream &out) const {
+  out << "program,stage,exit,output,blocks,insts,memOps,calls";
+  for (std::size_t i = 0; i < ir::NumInstTypes; ++i)
+    out << ',' << ir::getInstTypeName((ir::IRInst::InstType)i);
+  out << '\n';
+
+  for (auto &program : programs) {
+    for (auto &record : program.records) {
+      auto &histogram = record.histogram;
+      out << program.name << ',' << record.stage << ',' << record.exitCode
+          << ',' << (record.sameOutput ? "same" : "diff") << ','
+          << histogram.bbs << ',' << histogram.countInsts() << ','
+          << histogram.countMemOps() << ','
+          << histogram.countInsts(ir::IRInst::Call);
+      for (auto cnt : histogram.insts)
+        out << ',' << cnt;
+      out << '\n';
+    }
+  }
+  out.flush();
+}
+
+void DynamicStatsRecorder::printJson(std::ostream &out) const {
+  out << "{\"programs\": [";
+  for (std::size_t i = 0; i < programs.size(); ++i) {
+    auto &program = programs[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "  {\"program\": \"" << program.name << "\", \"stages\": [";
+    for (std::size_t j = 0; j < program.records.size(); ++j) {
+      auto &record = program.records[j];
+      out << (j == 0 ? "\n" : ",\n");
+      out << "    {\"stage\": \"" << record.stage
+          << "\", \"exit\": " << record.exitCode << ", \"output\": \""
+          << (record.sameOutput ? "same" : "diff") << "\", \"calls\": "
+          << record.histogram.countInsts(ir::IRInst::Call)
+          << ", \"dynamic\": ";
+      ir::printHistogramJson(record.histogram, out);
+      out << "}";
+    }
+    out << (program.records.empty() ? "]}" : "\n  ]}");
+  }
+  out << "\n]}" << std::endl;
+}
+
+DynamicStatsRecorder *&dynamicStatsRecorder() {
+  static DynamicStatsRecorder *res = nullptr;
+  return res;
+}
+
+} // namespace mocker
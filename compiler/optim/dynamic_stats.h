@@ -0,0 +1,54 @@
+#ifndef MOCKER_DYNAMIC_STATS_H
+#define MOCKER_DYNAMIC_STATS_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ir/module.h"
+#include "ir/stats.h"
+
+namespace mocker {
+
+// Runs the module in the interpreter at the stages of the pipeline and
+// records the numbers of the blocks entered and of the instructions executed.
+// Unlike the static histograms, these tell which passes reduce the work done.
+class DynamicStatsRecorder {
+public:
+  // The following stages belong to the program [name], which reads [input].
+  void beginProgram(std::string name, std::string input);
+
+  void record(std::string stage, const ir::Module &module);
+
+  // program,stage,exit,output,blocks,insts,memOps,calls,<the types>...
+  // where output is "same" if the program prints what it printed at the
+  // first stage, and "diff" otherwise.
+  void printCsv(std::ostream &out) const;
+
+  // {"programs": [{"program": ..., "stages": [{"stage": ..., "exit": ...,
+  // "output": ..., "calls": ..., "dynamic": <histogram>}]}]}
+  void printJson(std::ostream &out) const;
+
+private:
+  struct Record {
+    std::string stage;
+    std::int64_t exitCode;
+    bool sameOutput;
+    ir::Histogram histogram;
+  };
+
+  struct Program {
+    std::string name, input, output;
+    std::vector<Record> records;
+  };
+
+  std::vector<Program> programs;
+};
+
+// The recorder used by optimize(), if any.
+DynamicStatsRecorder *&dynamicStatsRecorder();
+
+} // namespace mocker
+
+#endif // MOCKER_DYNAMIC_STATS_H
@@ -9,7 +9,8 @@
 
 #include "helper.h"
 #include "ir/helper.h"
-#include "optim/analysis/loop_info.h"
+#include "optim/analysis/analysis_manager.h"
+#include "optim/profile_use.h"
 
 namespace mocker {
 
@@ -22,9 +23,13 @@ bool FunctionInline::operator()() {
     std::cerr << func << ", ";
   }
   std::cerr << std::endl;
-  auto funcsCopy = module.getFuncs();
 
-  for (auto &kv : funcsCopy) {
+  // The callees are inlined as they are before this pass. Only the inlineable
+  // functions, which are small, are copied.
+  for (auto &name : inlineable)
+    originals.emplace(name, module.getFuncs().at(name));
+
+  for (auto &kv : module.getFuncs()) {
     auto &func = kv.second;
     if (func.isExternalFunc())
       continue;
@@ -32,7 +37,7 @@ bool FunctionInline::operator()() {
     while (bbIter != func.getMutableBBs().end()) {
       auto callIter = std::find_if(
           bbIter->getMutableInsts().begin(), bbIter->getMutableInsts().end(),
-          [this](const std::shared_ptr<ir::IRInst> &inst) {
+          [this](const ir::IRInst *inst) {
             auto call = ir::dyc<ir::Call>(inst);
             if (!call)
               return false;
@@ -50,7 +55,6 @@ bool FunctionInline::operator()() {
     }
   }
 
-  module.getFuncs() = funcsCopy;
   for (auto &func : module.getFuncs())
     removeDeletedInsts(func.second);
 
@@ -67,8 +71,7 @@ std::size_t countInsts(const ir::FunctionModule &func, std::size_t threshold) {
   if (preCount > threshold)
     return threshold;
 
-  LoopInfo loopTree;
-  loopTree.init(func);
+  auto loopTree = getAnalysisManager().getLoopInfo(func);
 
   // a^b
   auto power = [threshold](std::size_t a, std::size_t b) {
@@ -82,19 +85,41 @@ std::size_t countInsts(const ir::FunctionModule &func, std::size_t threshold) {
 
   std::size_t res = 0;
   for (auto &bb : func.getBBs()) {
-    res += bb.getInsts().size() * power(10, loopTree.getDepth(bb.getLabelID()));
+    res +=
+        bb.getInsts().size() * power(10, loopTree->getDepth(bb.getLabelID()));
   }
 
   return res;
 }
 
+bool isRecursive(const ir::FunctionModule &func) {
+  for (auto &bb : func.getBBs()) {
+    for (auto inst : bb.getInsts()) {
+      auto call = ir::dyc<ir::Call>(inst);
+      if (call && call->getFuncName() == func.getIdentifier())
+        return true;
+    }
+  }
+  return false;
+}
+
 } // namespace
 
 void FunctionInline::buildInlineable() {
+  // A function called often enough in the installed profile may be larger,
+  // unless it is recursive and would grow each time this pass runs. The call
+  // sites are counted by the callee, since the profile is collected on the IR
+  // after this pass.
+  constexpr std::uint64_t HotCalls = 1000;
+  auto profile = installedProfile();
   for (auto &kv : module.getFuncs()) {
     if (kv.second.isExternalFunc())
       continue;
-    if (countInsts(kv.second, 201) <= 150) {
+    std::size_t limit = 150;
+    if (profile && profile->countCalls(kv.first) >= HotCalls &&
+        !isRecursive(kv.second))
+      limit = 400;
+    if (countInsts(kv.second, limit + 51) <= limit) {
       inlineable.emplace(kv.first);
     }
   }
@@ -116,8 +141,7 @@ ir::BBLIter FunctionInline::inlineFunction(ir::FunctionModule &caller,
                                            ir::BBLIter bbIter,
                                            ir::InstListIter callInstIter) {
   auto call = ir::dyc<ir::Call>(*callInstIter);
-  // do not use a reference here
-  auto callee = module.getFuncs().at(call->getFuncName());
+  const auto &callee = originals.at(call->getFuncName());
   if (callee.isExternalFunc())
     return ++bbIter;
 
@@ -125,7 +149,7 @@ ir::BBLIter FunctionInline::inlineFunction(ir::FunctionModule &caller,
   std::shared_ptr<ir::Reg> retVal = nullptr;
   if (call->getDest()) {
     retVal = caller.makeTempLocalReg("retVal");
-    caller.getFirstBB()->appendInstFront(std::make_shared<ir::Alloca>(retVal));
+    caller.getFirstBB()->appendInstFront(caller.makeInst<ir::Alloca>(retVal));
   }
 
   // move the subsequent instructions to a new BB
@@ -135,63 +159,48 @@ ir::BBLIter FunctionInline::inlineFunction(ir::FunctionModule &caller,
                                        bbIter->getMutableInsts().end());
   succBBIter->getMutableInsts().pop_front();
   if (call->getDest())
-    succBBIter->getMutableInsts().emplace_front(
-        std::make_shared<ir::Load>(call->getDest(), retVal));
+    succBBIter->getMutableInsts().push_front(
+        caller.makeInst<ir::Load>(call->getDest(), retVal));
+
+  // rename the registers: the parameters are replaced with the arguments, and
+  // the local registers with new ones of the caller
+  ir::RegMap<std::shared_ptr<ir::Addr>> regs;
+  const auto &calleeRegs = callee.getRegTable();
+  for (std::size_t id = 0; id < calleeRegs.size(); ++id) {
+    const auto &reg = calleeRegs.at(id);
+    if (ir::dycGlobalReg(reg)) {
+      regs[reg] = caller.makeReg(reg->getIdentifier());
+    } else if (isParameter(callee, reg->getIdentifier())) {
+      auto n = std::stol(reg->getIdentifier(), nullptr);
+      regs[reg] = call->getArgs().at((std::size_t)n);
+    }
+  }
+  for (auto &bb : callee.getBBs()) {
+    for (auto inst : bb.getInsts()) {
+      if (auto dest = ir::dycLocalReg(ir::getDest(inst)))
+        regs[dest] = caller.makeTempLocalReg(dest->getIdentifier());
+    }
+  }
 
   // insert new BBs
-  std::unordered_map<std::size_t, std::size_t> newLabelID;
-  for (auto riter = callee.getBBs().rbegin(); riter != callee.getBBs().rend();
-       ++riter) {
-    const auto &bb = *riter;
-    auto &curBB = *caller.insertBBAfter(bbIter);
-    curBB.getMutableInsts() = bb.getInsts();
-    newLabelID[bb.getLabelID()] = curBB.getLabelID();
-  }
-  bbIter->appendInst(std::make_shared<ir::Jump>(std::make_shared<ir::Label>(
-      newLabelID.at(callee.getFirstBB()->getLabelID()))));
+  auto newLabelID = caller.cloneBBsAfter(bbIter, callee, regs);
+  bbIter->appendInst(caller.makeInst<ir::Jump>(std::make_shared<ir::Label>(
+      newLabelID.at(callee.getFirstBBLabel()))));
 
-  // rename identifiers & LabelID; move alloca's to the first block
-  std::unordered_map<std::string, std::string> newIdent;
+  // move alloca's to the first block
   auto insertedBeg = bbIter;
   ++insertedBeg;
   for (auto iter = insertedBeg; iter != succBBIter; ++iter) {
-    auto &bb = *iter;
-    for (auto &inst : bb.getMutableInsts()) {
+    auto &insts = iter->getMutableInsts();
+    for (auto instIter = insts.begin(); instIter != insts.end();) {
+      auto inst = *instIter;
       assert(!ir::dyc<ir::Phi>(inst));
-      if (auto dest = ir::dycLocalReg(ir::getDest(inst))) {
-        auto newDest = caller.makeTempLocalReg(dest->getIdentifier());
-        inst = ir::copyWithReplacedDest(inst, newDest);
-        newIdent[dest->getIdentifier()] = newDest->getIdentifier();
-      }
-
-      auto operands = ir::getOperandsUsed(inst);
-      for (auto &operand : operands) {
-        auto reg = ir::dycLocalReg(operand);
-        if (!reg)
-          continue;
-        if (isParameter(callee, reg->getIdentifier())) {
-          auto n = std::stol(reg->getIdentifier(), nullptr);
-          operand = call->getArgs().at((std::size_t)n);
-          continue;
-        }
-        operand = std::make_shared<ir::Reg>(newIdent.at(reg->getIdentifier()));
-      }
-      inst = ir::copyWithReplacedOperands(inst, operands);
-
-      if (auto br = ir::dyc<ir::Branch>(inst)) {
-        inst = std::make_shared<ir::Branch>(
-            br->getCondition(),
-            std::make_shared<ir::Label>(newLabelID.at(br->getThen()->getID())),
-            std::make_shared<ir::Label>(newLabelID.at(br->getElse()->getID())));
-      } else if (auto jump = ir::dyc<ir::Jump>(inst)) {
-        inst = std::make_shared<ir::Jump>(std::make_shared<ir::Label>(
-            newLabelID.at(jump->getLabel()->getID())));
-      }
-
-      if (auto alloca = ir::dyc<ir::Alloca>(inst)) {
-        caller.getFirstBB()->getMutableInsts().push_front(std::move(inst));
-        inst = std::make_shared<ir::Deleted>();
+      if (!ir::dyc<ir::Alloca>(inst)) {
+        ++instIter;
+        continue;
       }
+      instIter = insts.erase(instIter);
+      caller.getFirstBB()->getMutableInsts().push_front(inst);
     }
   }
 
@@ -203,11 +212,11 @@ ir::BBLIter FunctionInline::inlineFunction(ir::FunctionModule &caller,
       continue;
     bb.getMutableInsts().pop_back();
     if (call->getDest()) {
-      bb.appendInst(std::make_shared<ir::Store>(
+      bb.appendInst(caller.makeInst<ir::Store>(
           retVal,
           ret->getVal() ? ret->getVal() : std::make_shared<ir::IntLiteral>(0)));
     }
-    bb.appendInst(std::make_shared<ir::Jump>(
+    bb.appendInst(caller.makeInst<ir::Jump>(
         std::make_shared<ir::Label>(succBBIter->getLabelID())));
   }
 
@@ -1,6 +1,8 @@
 #ifndef MOCKER_FUNCTION_INLINE_H
 #define MOCKER_FUNCTION_INLINE_H
 
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "opt_pass.h"
@@ -25,6 +27,8 @@ private:
 
 private:
   std::unordered_set<std::string> inlineable;
+  // The inlineable functions as they are before this pass
+  std::unordered_map<std::string, ir::FunctionModule> originals;
 };
 
 } // namespace mocker
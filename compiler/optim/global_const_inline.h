@@ -1,6 +1,11 @@
 #ifndef MOCKER_GLOBAL_CONST_INLINE_H
 #define MOCKER_GLOBAL_CONST_INLINE_H
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "ir/ir_inst.h"
 #include "opt_pass.h"
 
@@ -19,8 +24,9 @@ private:
   bool rewrite(ir::FunctionModule &func);
 
 private:
-  ir::RegSet defined;
-  ir::RegMap<std::int64_t> constant;
+  // Keyed by identifiers since every function has its own registers.
+  std::unordered_set<std::string> defined;
+  std::unordered_map<std::string, std::int64_t> constant;
 };
 
 } // namespace mocker
@@ -21,13 +21,14 @@ bool GlobalConstantInline::operator()() {
 
 void GlobalConstantInline::checkFunc(const ir::FunctionModule &func) {
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto store = ir::dyc<ir::Store>(inst);
       if (!store)
         continue;
-      auto globalReg = ir::dycGlobalReg(store->getAddr());
-      if (!globalReg)
+      auto reg = ir::dycGlobalReg(store->getAddr());
+      if (!reg)
         continue;
+      const auto &globalReg = reg->getIdentifier();
 
       bool firstTime = !isIn(defined, globalReg);
       defined.emplace(globalReg);
@@ -53,23 +54,26 @@ void GlobalConstantInline::checkFunc(const ir::FunctionModule &func) {
 bool GlobalConstantInline::rewrite(ir::FunctionModule &func) {
   bool modified = false;
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      if (auto store = ir::dyc<ir::Store>(inst)) {
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      if (auto store = ir::dyc<ir::Store>(*iter)) {
         auto globalReg = ir::dycGlobalReg(store->getAddr());
-        if (!globalReg || !isIn(constant, globalReg))
+        if (!globalReg || !isIn(constant, globalReg->getIdentifier()))
           continue;
-        inst = std::make_shared<ir::Deleted>();
+        iter = insts.replace(iter, func.makeInst<ir::Deleted>());
         continue;
       }
 
-      auto load = ir::dyc<ir::Load>(inst);
+      auto load = ir::dyc<ir::Load>(*iter);
       if (!load)
         continue;
       auto globalReg = ir::dycGlobalReg(load->getAddr());
-      if (!globalReg || !isIn(constant, globalReg))
+      if (!globalReg || !isIn(constant, globalReg->getIdentifier()))
         continue;
-      auto lit = std::make_shared<ir::IntLiteral>(constant.at(globalReg));
-      inst = std::make_shared<ir::Assign>(load->getDest(), lit);
+      auto lit = std::make_shared<ir::IntLiteral>(
+          constant.at(globalReg->getIdentifier()));
+      iter = insts.replace(iter,
+                           func.makeInst<ir::Assign>(load->getDest(), lit));
       modified = true;
     }
   }
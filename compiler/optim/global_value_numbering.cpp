@@ -31,7 +31,7 @@ ValueNumberTable::get(const std::shared_ptr<ir::Addr> &addr) {
 
 void ValueNumberTable::set(const std::shared_ptr<ir::Reg> &reg,
                            const std::shared_ptr<ir::Addr> &valueNumber) {
-  auto success = vn.emplace(std::make_pair(reg, valueNumber)).second;
+  auto success = vn.emplace(reg, valueNumber).second;
   assert(success);
 }
 
@@ -49,7 +49,7 @@ std::string hash(const std::shared_ptr<ir::Addr> &addr) {
 
 } // namespace
 
-InstHash::Key InstHash::operator()(const std::shared_ptr<ir::IRInst> &inst) {
+InstHash::Key InstHash::operator()(const ir::IRInst *inst) {
   using namespace std::string_literals;
 
   if (auto p = ir::dyc<ir::Assign>(inst)) {
@@ -116,7 +116,7 @@ GlobalValueNumbering::GlobalValueNumbering(ir::FunctionModule &func)
     : FuncPass(func) {}
 
 bool GlobalValueNumbering::operator()() {
-  dominatorTree.init(func);
+  dominatorTree = getAnalysisManager().getDominatorTree(func);
   detail::ValueNumberTable valueNumber;
   detail::InstHash instHash;
   ExprRegMap exprReg;
@@ -144,7 +144,7 @@ bool areSameAddrs(const std::shared_ptr<ir::Addr> &lhs,
 
 // If all values in the phi-function options are the same, return that value,
 // otherwise nullptr.
-std::shared_ptr<ir::Addr> uniquePhiValues(const std::shared_ptr<ir::Phi> &phi) {
+std::shared_ptr<ir::Addr> uniquePhiValues(const ir::Phi *phi) {
   auto res = phi->getOptions().front().first;
   for (auto &option : phi->getOptions()) {
     if (!areSameAddrs(res, option.first))
@@ -160,9 +160,10 @@ void GlobalValueNumbering::doValueNumbering(
     detail::InstHash instHash, ExprRegMap exprReg) {
   auto &bb = func.getMutableBasicBlock(bbLabel);
 
-  auto iter = bb.getMutableInsts().begin();
+  auto &insts = bb.getMutableInsts();
+  auto iter = insts.begin();
   for (;; ++iter) {
-    auto &inst = *iter;
+    auto inst = *iter;
     if (ir::dyc<ir::Deleted>(inst))
       continue;
     const auto phi = ir::dyc<ir::Phi>(inst);
@@ -176,7 +177,7 @@ void GlobalValueNumbering::doValueNumbering(
 
     if (auto val = uniquePhiValues(phi)) { // phi is meaningless
       valueNumber.set(phi->getDest(), val);
-      inst = std::make_shared<ir::Deleted>();
+      iter = insts.replace(iter, func.makeInst<ir::Deleted>());
       ++cnt;
       continue;
     }
@@ -184,7 +185,7 @@ void GlobalValueNumbering::doValueNumbering(
     auto key = instHash(inst);
     if (isIn(exprReg, key)) { // reusable
       valueNumber.set(phi->getDest(), exprReg.at(key));
-      inst = std::make_shared<ir::Deleted>();
+      iter = insts.replace(iter, func.makeInst<ir::Deleted>());
       ++cnt;
       continue;
     }
@@ -193,12 +194,13 @@ void GlobalValueNumbering::doValueNumbering(
     exprReg[key] = phi->getDest();
   }
 
-  for (auto End = bb.getMutableInsts().end(); iter != End; ++iter) {
-    auto &inst = *iter;
-    auto newOperands = ir::getOperandsUsed(inst);
-    for (auto &operand : newOperands)
-      operand = valueNumber.get(operand);
-    inst = ir::copyWithReplacedOperands(inst, newOperands);
+  for (auto End = insts.end(); iter != End; ++iter) {
+    auto inst = *iter;
+    for (std::size_t i = 0; i < inst->getNumOperands(); ++i) {
+      auto newOperand = valueNumber.get(inst->getOperand(i));
+      if (!mocker::areSameAddrs(newOperand, inst->getOperand(i)))
+        func.setOperand(inst, i, std::move(newOperand));
+    }
 
     auto dest = ir::getDest(inst);
     if (!dest)
@@ -219,7 +221,7 @@ void GlobalValueNumbering::doValueNumbering(
     if (isIn(exprReg, key)) {
       auto res = exprReg.at(key);
       valueNumber.set(dest, res);
-      inst = std::make_shared<ir::Deleted>();
+      iter = insts.replace(iter, func.makeInst<ir::Deleted>());
       ++cnt;
       continue;
     }
@@ -227,8 +229,7 @@ void GlobalValueNumbering::doValueNumbering(
     exprReg[key] = dest;
   }
 
-  auto adjustPhi = [bbLabel,
-                    &valueNumber](const std::shared_ptr<ir::Phi> &phi) {
+  auto adjustPhi = [this, bbLabel, &valueNumber](const ir::Phi *phi) {
     std::vector<ir::Phi::Option> newOptions;
     for (auto &option : phi->getOptions()) {
       if (option.second->getID() != bbLabel) {
@@ -238,26 +239,27 @@ void GlobalValueNumbering::doValueNumbering(
       newOptions.emplace_back(
           std::make_pair(valueNumber.get(option.first), option.second));
     }
-    return std::make_shared<ir::Phi>(phi->getDest(), std::move(newOptions));
+    return func.makeInst<ir::Phi>(phi->getDest(), std::move(newOptions));
   };
   for (auto sucLabel : bb.getSuccessors()) {
-    auto &sucBB = func.getMutableBasicBlock(sucLabel);
-    for (auto &inst : sucBB.getMutableInsts()) {
-      if (ir::dyc<ir::Deleted>(inst))
+    auto &sucInsts = func.getMutableBasicBlock(sucLabel).getMutableInsts();
+    for (auto sucIter = sucInsts.begin(); sucIter != sucInsts.end();
+         ++sucIter) {
+      if (ir::dyc<ir::Deleted>(*sucIter))
         continue;
-      auto phi = ir::dyc<ir::Phi>(inst);
+      auto phi = ir::dyc<ir::Phi>(*sucIter);
       if (!phi)
         break;
-      inst = adjustPhi(phi);
+      sucIter = sucInsts.replace(sucIter, adjustPhi(phi));
     }
   }
 
-  for (auto c : dominatorTree.getChildren(bbLabel))
+  for (auto c : dominatorTree->getChildren(bbLabel))
     doValueNumbering(c, valueNumber, instHash, exprReg);
 }
 
 bool GlobalValueNumbering::canProcessPhi(
-    const std::shared_ptr<ir::Phi> &phi,
+    const ir::Phi *phi,
     const detail::ValueNumberTable &vn) const {
   for (auto &option : phi->getOptions()) {
     if (!vn.has(option.first))
@@ -5,11 +5,12 @@
 #define MOCKER_GLOBAL_VALUE_NUMBERING_H
 
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <cassert>
 
-#include "analysis/dominance.h"
+#include "analysis/analysis_manager.h"
 #include "opt_pass.h"
 #include "set_operation.h"
 #include "ir/helper.h"
@@ -44,7 +45,7 @@ public:
   using Key = std::string;
   InstHash() = default;
 
-  Key operator()(const std::shared_ptr<ir::IRInst> &inst);
+  Key operator()(const ir::IRInst *inst);
 
 };
 
@@ -54,6 +55,8 @@ class GlobalValueNumbering : public FuncPass {
 public:
   explicit GlobalValueNumbering(ir::FunctionModule &func);
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 
 private:
@@ -64,10 +67,10 @@ private:
                         detail::ValueNumberTable valueNumber,
                         detail::InstHash instHash, ExprRegMap exprReg);
 
-  bool canProcessPhi(const std::shared_ptr<ir::Phi> & phi, const detail::ValueNumberTable & vn) const;
+  bool canProcessPhi(const ir::Phi *phi, const detail::ValueNumberTable & vn) const;
 
 private:
-  DominatorTree dominatorTree;
+  std::shared_ptr<const DominatorTree> dominatorTree;
   std::size_t cnt = 0;
 };
 
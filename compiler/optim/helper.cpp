@@ -4,12 +4,12 @@
 
 namespace mocker {
 
-std::unordered_map<std::string, std::shared_ptr<ir::IRInst>>
+std::unordered_map<std::string, ir::IRInst *>
 buildInstDefine(const ir::FunctionModule &func) {
-  std::unordered_map<std::string, std::shared_ptr<ir::IRInst>> res;
+  std::unordered_map<std::string, ir::IRInst *> res;
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto dest = ir::getDest(inst);
       if (!dest)
         continue;
@@ -22,42 +22,32 @@ buildInstDefine(const ir::FunctionModule &func) {
   return res;
 }
 
-std::unordered_map<std::size_t, std::vector<std::size_t>>
+ir::LabelMap<std::vector<std::size_t>>
 buildBlockPredecessors(const ir::FunctionModule &func) {
-  std::unordered_map<std::size_t, std::vector<std::size_t>> res;
-  for (auto &bb : func.getBBs())
-    res[bb.getLabelID()] = {};
-
-  for (auto &bb : func.getBBs()) {
-    auto succ = bb.getSuccessors();
-    for (auto &s : succ)
-      res[s].emplace_back(bb.getLabelID());
-  }
-
-  return res;
+  return func.getPredecessorMap();
 }
 
-void removeInstIf(
-    ir::FunctionModule &func,
-    std::function<bool(const std::shared_ptr<ir::IRInst> &)> condition) {
+void removeInstIf(ir::FunctionModule &func,
+                  std::function<bool(const ir::IRInst *)> condition) {
   for (auto &bb : func.getMutableBBs()) {
-    ir::InstList newInsts;
-    for (auto &inst : bb.getMutableInsts()) {
-      if (!condition(inst))
-        newInsts.emplace_back(std::move(inst));
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end();) {
+      if (condition(*iter))
+        iter = insts.erase(iter);
+      else
+        ++iter;
     }
-    bb.getMutableInsts() = std::move(newInsts);
   }
 }
 
 void removeDeletedInsts(ir::FunctionModule &func) {
-  removeInstIf(func, [](const std::shared_ptr<ir::IRInst> &inst) {
-    return (bool)ir::dyc<ir::Deleted>(inst);
+  removeInstIf(func, [](const ir::IRInst *inst) {
+    return inst->getInstType() == ir::IRInst::Deleted;
   });
 }
 
-std::shared_ptr<ir::IRInst> deletePhiOption(const std::shared_ptr<ir::Phi> &phi,
-                                            std::size_t bbLabel) {
+ir::IRInst *deletePhiOption(ir::FunctionModule &func, const ir::Phi *phi,
+                            std::size_t bbLabel) {
   std::vector<ir::Phi::Option> newOptions;
 
   for (auto &option : phi->getOptions())
@@ -66,12 +56,11 @@ std::shared_ptr<ir::IRInst> deletePhiOption(const std::shared_ptr<ir::Phi> &phi,
           std::make_pair(option.first, ir::dyc<ir::Label>(option.second)));
     }
 
-  return std::make_shared<ir::Phi>(phi->getDest(), std::move(newOptions));
+  return func.makeInst<ir::Phi>(phi->getDest(), std::move(newOptions));
 }
 
-std::shared_ptr<ir::IRInst>
-replacePhiOption(const std::shared_ptr<ir::Phi> &phi, std::size_t oldLabel,
-                 std::size_t newLabel) {
+ir::IRInst *replacePhiOption(ir::FunctionModule &func, const ir::Phi *phi,
+                             std::size_t oldLabel, std::size_t newLabel) {
   std::vector<ir::Phi::Option> newOptions;
   for (auto &option : phi->getOptions()) {
     newOptions.emplace_back(std::make_pair(
@@ -80,48 +69,50 @@ replacePhiOption(const std::shared_ptr<ir::Phi> &phi, std::size_t oldLabel,
                                         ? newLabel
                                         : option.second->getID())));
   }
-  return std::make_shared<ir::Phi>(phi->getDest(), std::move(newOptions));
+  return func.makeInst<ir::Phi>(phi->getDest(), std::move(newOptions));
 }
 
-std::shared_ptr<ir::IRInst>
-replaceTerminatorLabel(const std::shared_ptr<ir::IRInst> &inst,
-                       std::size_t oldLabel, std::size_t newLabel) {
+ir::IRInst *replaceTerminatorLabel(ir::FunctionModule &func,
+                                   const ir::IRInst *inst,
+                                   std::size_t oldLabel, std::size_t newLabel) {
   if (auto p = ir::dyc<ir::Jump>(inst)) {
     assert(p->getLabel()->getID() == oldLabel);
-    return std::make_shared<ir::Jump>(std::make_shared<ir::Label>(newLabel));
+    (void)p;
+    return func.makeInst<ir::Jump>(std::make_shared<ir::Label>(newLabel));
   }
   if (auto p = ir::dyc<ir::Branch>(inst)) {
     assert(p->getThen()->getID() != p->getElse()->getID());
     if (p->getThen()->getID() == oldLabel)
-      return std::make_shared<ir::Branch>(p->getCondition(),
-                                          std::make_shared<ir::Label>(newLabel),
-                                          p->getElse());
+      return func.makeInst<ir::Branch>(p->getCondition(),
+                                       std::make_shared<ir::Label>(newLabel),
+                                       p->getElse());
     if (p->getElse()->getID() == oldLabel)
-      return std::make_shared<ir::Branch>(
-          p->getCondition(), p->getThen(),
-          std::make_shared<ir::Label>(newLabel));
+      return func.makeInst<ir::Branch>(p->getCondition(), p->getThen(),
+                                       std::make_shared<ir::Label>(newLabel));
     assert(false);
   }
   assert(false);
 }
 
-void simplifyPhiFunctions(ir::BasicBlock &bb) {
+void simplifyPhiFunctions(ir::FunctionModule &func, ir::BasicBlock &bb) {
+  auto &insts = bb.getMutableInsts();
   // find the insertion point
-  auto insertionPoint = bb.getMutableInsts().begin();
+  auto insertionPoint = insts.begin();
   while (ir::dyc<ir::Phi>(*insertionPoint))
     ++insertionPoint;
 
-  for (auto &inst : bb.getMutableInsts()) {
-    auto phi = ir::dyc<ir::Phi>(inst);
+  for (auto iter = insts.begin(); iter != insertionPoint;) {
+    auto phi = ir::dyc<ir::Phi>(*iter);
     if (!phi)
       break;
-
-    if (phi->getOptions().size() == 1) {
-      auto assign = std::make_shared<ir::Assign>(phi->getDest(),
-                                                 phi->getOptions()[0].first);
-      inst = std::make_shared<ir::Deleted>();
-      bb.getMutableInsts().emplace(insertionPoint, std::move(assign));
+    if (phi->getOptions().size() != 1) {
+      ++iter;
+      continue;
     }
+    auto assign =
+        func.makeInst<ir::Assign>(phi->getDest(), phi->getOptions()[0].first);
+    iter = insts.erase(iter);
+    insts.insert(insertionPoint, assign);
   }
 }
 
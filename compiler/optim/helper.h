@@ -10,30 +10,30 @@
 
 namespace mocker {
 
-std::unordered_map<std::string, std::shared_ptr<ir::IRInst>>
+std::unordered_map<std::string, ir::IRInst *>
 buildInstDefine(const ir::FunctionModule &func);
 
-std::unordered_map<std::size_t, std::vector<std::size_t>>
+// A snapshot of the predecessors maintained by [func].
+ir::LabelMap<std::vector<std::size_t>>
 buildBlockPredecessors(const ir::FunctionModule &func);
 
-void removeInstIf(
-    ir::FunctionModule &func,
-    std::function<bool(const std::shared_ptr<ir::IRInst> &)> condition);
+void removeInstIf(ir::FunctionModule &func,
+                  std::function<bool(const ir::IRInst *)> condition);
 
 void removeDeletedInsts(ir::FunctionModule &func);
 
-std::shared_ptr<ir::IRInst> deletePhiOption(const std::shared_ptr<ir::Phi> &phi,
-                                            std::size_t bbLabel);
+// The following functions return a new instruction owned by [func].
+ir::IRInst *deletePhiOption(ir::FunctionModule &func, const ir::Phi *phi,
+                            std::size_t bbLabel);
 
-std::shared_ptr<ir::IRInst>
-replacePhiOption(const std::shared_ptr<ir::Phi> &phi, std::size_t oldLabel,
-                 std::size_t newLabel);
+ir::IRInst *replacePhiOption(ir::FunctionModule &func, const ir::Phi *phi,
+                             std::size_t oldLabel, std::size_t newLabel);
 
-std::shared_ptr<ir::IRInst>
-replaceTerminatorLabel(const std::shared_ptr<ir::IRInst> &inst,
-                       std::size_t oldLabel, std::size_t newLabel);
+ir::IRInst *replaceTerminatorLabel(ir::FunctionModule &func,
+                                   const ir::IRInst *inst,
+                                   std::size_t oldLabel, std::size_t newLabel);
 
-void simplifyPhiFunctions(ir::BasicBlock &bb);
+void simplifyPhiFunctions(ir::FunctionModule &func, ir::BasicBlock &bb);
 
 bool isParameter(const ir::FunctionModule &func, const std::string &identifier);
 
@@ -12,7 +12,7 @@
 namespace mocker {
 
 bool InductionVariable::isInductionVariable(
-    const std::shared_ptr<ir::ArithBinaryInst> &defInst,
+    const ir::ArithBinaryInst *defInst,
     const ir::RegSet &curIVs, const ir::RegSet &loopInv) const {
   if (defInst->getOp() == ir::ArithBinaryInst::Sub) {
     auto lhsReg = ir::dycLocalReg(defInst->getLhs());
@@ -37,7 +37,7 @@ bool InductionVariable::isInductionVariable(
   return false;
 }
 bool InductionVariable::isInductionVariable(
-    const std::shared_ptr<ir::Phi> &defInst, const ir::RegSet &loopInv) const {
+    const ir::Phi *defInst, const ir::RegSet &loopInv) const {
   for (auto &option : defInst->getOptions()) {
     auto reg = ir::dyc<ir::Reg>(option.first);
     if (!reg)
@@ -50,8 +50,8 @@ bool InductionVariable::isInductionVariable(
 
 bool InductionVariable::operator()() {
   loopInfo.init(func, funcAttr);
-  useDef.init(func);
-  defUse.init(func);
+  useDef = getAnalysisManager().getUseDefChain(func);
+  defUse = getAnalysisManager().getDefUseChain(func);
   auto loopHeads = loopInfo.postOrder();
   for (auto header : loopHeads) {
     if (header == func.getFirstBBLabel())
@@ -65,8 +65,8 @@ namespace {
 
 // return the initial value and the value from the loop
 std::pair<std::shared_ptr<ir::Addr>, std::shared_ptr<ir::Addr>>
-getInitAndLoopVal(const std::shared_ptr<ir::Phi> &phi,
-                  const std::unordered_set<std::size_t> &loopNodes) {
+getInitAndLoopVal(const ir::Phi *phi,
+                  const ir::LabelSet &loopNodes) {
   assert(phi->getOptions().size() == 2);
   auto out = phi->getOptions().at(0).second->getID();
   auto in = phi->getOptions().at(1).second->getID();
@@ -91,7 +91,7 @@ InductionVariable::findCandidatePhis(std::size_t header) {
   const auto &loopNodes = loopInfo.getLoops().at(header);
   const auto &loopInv = loopInfo.getLoopInvariantVariables(header);
 
-  for (auto &inst : bb.getInsts()) {
+  for (auto inst : bb.getInsts()) {
     auto phi = ir::dyc<ir::Phi>(inst);
     if (!phi)
       break;
@@ -103,7 +103,7 @@ InductionVariable::findCandidatePhis(std::size_t header) {
     auto loopVal = ir::dycLocalReg(initAndLoopVal.second);
     if (!loopVal)
       continue;
-    auto def = useDef.getDef(loopVal);
+    auto def = useDef->getDef(loopVal);
     assert(isIn(loopNodes, def.getBBLabel()));
     auto binary = ir::dyc<ir::ArithBinaryInst>(def.getInst());
     if (!binary || binary->getOp() != ir::ArithBinaryInst::Add)
@@ -164,27 +164,26 @@ void InductionVariable::processLoop(std::size_t header) {
 //  std::cerr << std::endl;
 
   // Finally, we replace the phi functions by assignment
-  auto &bb = func.getMutableBasicBlock(header);
-  auto pos = bb.getMutableInsts().begin();
+  auto &insts = func.getMutableBasicBlock(header).getMutableInsts();
+  auto pos = insts.begin();
   for (;; ++pos) {
     if (!ir::dyc<ir::Phi>(*pos))
       break;
   }
-  std::vector<std::shared_ptr<ir::Assign>> toBeInserted;
-  for (auto &inst : bb.getMutableInsts()) {
-    auto phi = ir::dyc<ir::Phi>(inst);
-    if (!phi)
-      break;
-    if (!isIn(newName, phi->getDest()))
+  std::vector<ir::Assign *> toBeInserted;
+  for (auto iter = insts.begin(); iter != pos;) {
+    auto phi = ir::dyc<ir::Phi>(*iter);
+    if (!isIn(newName, phi->getDest())) {
+      ++iter;
       continue;
+    }
     auto reuse = newName.at(phi->getDest());
-    toBeInserted.emplace_back(
-        std::make_shared<ir::Assign>(phi->getDest(), reuse));
-    inst = std::make_shared<ir::Deleted>();
+    toBeInserted.emplace_back(func.makeInst<ir::Assign>(phi->getDest(), reuse));
+    iter = insts.erase(iter);
   }
 
-  for (auto &assign : toBeInserted)
-    bb.getMutableInsts().insert(pos, assign);
+  for (auto assign : toBeInserted)
+    insts.insert(pos, assign);
 
   removeDeletedInsts(func);
 }
@@ -1,6 +1,9 @@
 #ifndef MOCKER_INDUCTION_VARIABLE_H
 #define MOCKER_INDUCTION_VARIABLE_H
 
+#include <memory>
+
+#include "analysis/analysis_manager.h"
 #include "analysis/defuse.h"
 #include "analysis/func_attr.h"
 #include "analysis/loop_info.h"
@@ -13,6 +16,8 @@ public:
   InductionVariable(ir::FunctionModule &func, const FuncAttr &funcAttr)
       : FuncPass(func), funcAttr(funcAttr) {}
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 
 private:
@@ -29,17 +34,17 @@ private:
 
   ir::RegMap<IVar> findCandidatePhis(std::size_t header);
 
-  bool isInductionVariable(const std::shared_ptr<ir::ArithBinaryInst> &defInst,
+  bool isInductionVariable(const ir::ArithBinaryInst *defInst,
                            const ir::RegSet &curIVs,
                            const ir::RegSet &loopInv) const;
 
-  bool isInductionVariable(const std::shared_ptr<ir::Phi> &defInst,
+  bool isInductionVariable(const ir::Phi *defInst,
                            const ir::RegSet &loopInv) const;
 
   // check whether all uses of the register is in the loop
   bool isLoopVariables(const std::shared_ptr<ir::Reg> &reg,
-                       const std::unordered_set<std::size_t> &loopNodes) const {
-    const auto &Uses = defUse.getUses(reg);
+                       const ir::LabelSet &loopNodes) const {
+    const auto &Uses = defUse->getUses(reg);
     for (auto &use : Uses) {
       auto bb = use.getBBLabel();
       if (!isIn(loopNodes, bb))
@@ -51,8 +56,8 @@ private:
 private:
   const FuncAttr &funcAttr;
   LoopInfo loopInfo;
-  UseDefChain useDef;
-  DefUseChain defUse;
+  std::shared_ptr<const UseDefChain> useDef;
+  std::shared_ptr<const DefUseChain> defUse;
   // IV contained by this loop
   std::unordered_map<std::size_t, ir::RegSet> inductionVars;
 };
@@ -11,12 +11,15 @@
 
 namespace mocker {
 
-LocalValueNumbering::LocalValueNumbering(ir::BasicBlock &bb)
-    : BasicBlockPass(bb) {}
+LocalValueNumbering::LocalValueNumbering(ir::FunctionModule &func,
+                                         ir::BasicBlock &bb)
+    : BasicBlockPass(func, bb) {}
 
 bool LocalValueNumbering::operator()() {
   std::size_t cnt = 0;
-  for (auto &inst : bb.getMutableInsts()) {
+  auto &insts = bb.getMutableInsts();
+  for (auto instIter = insts.begin(); instIter != insts.end(); ++instIter) {
+    auto inst = *instIter;
     auto dest = ir::getDest(inst);
     if (!dest)
       continue;
@@ -42,7 +45,8 @@ bool LocalValueNumbering::operator()() {
           assert(false);
       }
 
-      inst = std::make_shared<ir::Assign>(dest, rhsVal);
+      instIter =
+          insts.replace(instIter, func.makeInst<ir::Assign>(dest, rhsVal));
       ++cnt;
       continue;
     }
@@ -77,7 +81,7 @@ void LocalValueNumbering::makeSureDefined(
 }
 
 std::string
-LocalValueNumbering::hash(const std::shared_ptr<ir::IRInst> &inst,
+LocalValueNumbering::hash(const ir::IRInst *inst,
                           const std::vector<std::size_t> &valueNumbers) {
   using namespace std::string_literals;
   std::vector<std::string> vnStr;
@@ -125,7 +129,7 @@ LocalValueNumbering::hash(const std::shared_ptr<ir::IRInst> &inst,
       std::swap(vnStr[0], vnStr[1]);
     return names.at(op) + vnStr[0] + "," + vnStr[1];
   }
-  if (auto p = ir::dyc<ir::Phi>(inst)) {
+  if (ir::dyc<ir::Phi>(inst)) {
     std::string res = "phi,";
     for (auto &s : vnStr)
       res += s + ",";
@@ -1,6 +1,7 @@
 #ifndef MOCKER_LOCAL_VALUE_NUMBERING_H
 #define MOCKER_LOCAL_VALUE_NUMBERING_H
 
+#include "analysis/analysis_manager.h"
 #include "opt_pass.h"
 
 #include <string>
@@ -11,7 +12,9 @@ namespace mocker {
 
 class LocalValueNumbering : public BasicBlockPass {
 public:
-  explicit LocalValueNumbering(ir::BasicBlock &bb);
+  LocalValueNumbering(ir::FunctionModule &func, ir::BasicBlock &bb);
+
+  static constexpr unsigned Preserved = CFGAnalyses;
 
   bool operator()() override;
 
@@ -20,7 +23,7 @@ private:
 
   void makeSureDefined(const std::shared_ptr<ir::Addr> &addr);
 
-  std::string hash(const std::shared_ptr<ir::IRInst> &inst,
+  std::string hash(const ir::IRInst *inst,
                    const std::vector<std::size_t> &valueNumbers);
 
 private:
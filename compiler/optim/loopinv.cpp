@@ -16,9 +16,9 @@ namespace {
 // result is
 //   I1: a = phi <b2, 2> <c, 3>
 //   I2: c = phi <b0, 0> <b1, 1>
-std::pair<std::shared_ptr<ir::Phi>, std::shared_ptr<ir::Phi>>
-splitPhi(ir::FunctionModule &func, const std::shared_ptr<ir::Phi> &phi,
-         const std::unordered_set<std::size_t> &s,
+std::pair<ir::Phi *, ir::Phi *>
+splitPhi(ir::FunctionModule &func, ir::Phi *phi,
+         const ir::LabelSet &s,
          const std::size_t preHeader) {
   std::vector<ir::Phi::Option> optionLeft, optionMoved;
   for (auto &option : phi->getOptions()) {
@@ -35,8 +35,8 @@ splitPhi(ir::FunctionModule &func, const std::shared_ptr<ir::Phi> &phi,
   optionLeft.emplace_back(preHeaderPhiDest,
                           std::make_shared<ir::Label>(preHeader));
   return {
-      std::make_shared<ir::Phi>(phi->getDest(), optionLeft),
-      std::make_shared<ir::Phi>(preHeaderPhiDest, optionMoved),
+      func.makeInst<ir::Phi>(phi->getDest(), optionLeft),
+      func.makeInst<ir::Phi>(preHeaderPhiDest, optionMoved),
   };
 }
 
@@ -50,9 +50,9 @@ void LoopInvariantCodeMotion::insertPreHeaders() {
     auto &loopNodes = kv.second;
     if (loopNodes.size() == 1) // is not a loop header
       continue;
-    std::unordered_set<std::size_t> outerPreds(Preds.at(header).begin(),
-                                               Preds.at(header).end());
-    subSet(outerPreds, loopNodes);
+    ir::LabelSet outerPreds;
+    unionSet(outerPreds, Preds.at(header));
+    outerPreds.subtract(loopNodes);
 
     if (kv.first == func.getFirstBBLabel())
       continue;
@@ -63,31 +63,32 @@ void LoopInvariantCodeMotion::insertPreHeaders() {
     auto &headBB = func.getMutableBasicBlock(header);
     auto &preHeaderBB = *func.pushBackBB();
     auto preHeader = preHeaderBB.getLabelID();
-    auto tmp = preHeaders.emplace(std::make_pair(header, preHeader)).second;
+    auto tmp = preHeaders.emplace(header, preHeader).second;
     assert(tmp);
 
     // adjust the terminators of the outer predecessors
-    for (auto &pred : outerPreds) {
-      auto &bb = func.getMutableBasicBlock(pred);
-      auto &terminator = bb.getMutableInsts().back();
-      terminator = replaceTerminatorLabel(terminator, header, preHeader);
+    for (auto pred : outerPreds) {
+      auto &insts = func.getMutableBasicBlock(pred).getMutableInsts();
+      insts.replace(--insts.end(), replaceTerminatorLabel(func, insts.back(),
+                                                          header, preHeader));
     }
 
     // adjust the phi-functions
-    for (auto &inst : headBB.getMutableInsts()) {
-      const auto phi = ir::dyc<ir::Phi>(inst);
+    auto &headInsts = headBB.getMutableInsts();
+    for (auto iter = headInsts.begin(); iter != headInsts.end(); ++iter) {
+      const auto phi = ir::dyc<ir::Phi>(*iter);
       if (!phi)
         break;
       auto newPhis = splitPhi(func, phi, outerPreds, preHeader);
       if (newPhis.second) {
         preHeaderBB.appendInst(newPhis.second);
-        inst = newPhis.first;
+        iter = headInsts.replace(iter, newPhis.first);
       }
     }
     preHeaderBB.appendInst(
-        std::make_shared<ir::Jump>(std::make_shared<ir::Label>(header)));
-    simplifyPhiFunctions(headBB);
-    simplifyPhiFunctions(preHeaderBB);
+        func.makeInst<ir::Jump>(std::make_shared<ir::Label>(header)));
+    simplifyPhiFunctions(func, headBB);
+    simplifyPhiFunctions(func, preHeaderBB);
   }
   removeDeletedInsts(func);
 }
@@ -95,9 +96,8 @@ void LoopInvariantCodeMotion::insertPreHeaders() {
 bool LoopInvariantCodeMotion::operator()() {
   std::cerr << "\nLICM: " + func.getIdentifier() + "\n";
 
-  loopTree.init(func);
+  loopTree = *getAnalysisManager().getLoopInfo(func);
   insertPreHeaders();
-  func.buildContext();
   LoopInfo newLoopTree;
   newLoopTree.init(func, funcAttr);
   loopTree = newLoopTree;
@@ -117,9 +117,8 @@ std::size_t LoopInvariantCodeMotion::processLoop(const std::size_t header) {
   if (loopNodes.size() == 1)
     return 0;
 
-  UseDefChain useDef;
-  useDef.init(func);
-  auto invariant = findLoopInvariantComputation(header, useDef);
+  auto useDef = getAnalysisManager().getUseDefChain(func);
+  auto invariant = findLoopInvariantComputation(header, *useDef);
   hoist(loopNodes, invariant, preHeaders.at(header));
   return invariant.size();
 }
@@ -132,7 +131,7 @@ LoopInvariantCodeMotion::findLoopInvariantComputation(
   std::unordered_set<ir::InstID> res;
 
   auto loopInvVars = loopTree.getLoopInvariantVariables(header);
-  std::queue<std::shared_ptr<ir::IRInst>> worklist;
+  std::queue<ir::IRInst *> worklist;
 
   // we only hoist Calls that can not be avoided
   auto &headerBB = func.getBasicBlock(header);
@@ -158,12 +157,12 @@ LoopInvariantCodeMotion::findLoopInvariantComputation(
 
   for (auto &node : mustPass) {
     const auto &bb = func.getBasicBlock(node);
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto dest = ir::getDest(inst);
       if (!dest || !isIn(loopInvVars, dest))
         continue;
       res.emplace(inst->getID());
-      if (auto call = ir::dyc<ir::Call>(inst)) {
+      if (ir::dyc<ir::Call>(inst)) {
         worklist.emplace(inst);
       }
     }
@@ -189,17 +188,20 @@ LoopInvariantCodeMotion::findLoopInvariantComputation(
 }
 
 void LoopInvariantCodeMotion::hoist(
-    const std::unordered_set<std::size_t> &loopNodes,
+    const ir::LabelSet &loopNodes,
     const std::unordered_set<ir::InstID> &invariant, std::size_t preHeader) {
   auto &preHeaderBB = func.getMutableBasicBlock(preHeader);
   for (auto node : loopNodes) {
-    auto &bb = func.getMutableBasicBlock(node);
-    for (auto &inst : bb.getMutableInsts()) {
-      if (!isIn(invariant, inst->getID()))
+    auto &insts = func.getMutableBasicBlock(node).getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end();) {
+      auto inst = *iter;
+      if (!isIn(invariant, inst->getID())) {
+        ++iter;
         continue;
+      }
       std::cerr << "hoist: " << ir::fmtInst(inst) << std::endl;
+      iter = insts.erase(iter);
       preHeaderBB.appendInstBeforeTerminator(inst);
-      inst = std::make_shared<ir::Deleted>();
     }
   }
   removeDeletedInsts(func);
@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "analysis/analysis_manager.h"
 #include "analysis/defuse.h"
 #include "analysis/func_attr.h"
 #include "opt_pass.h"
@@ -29,14 +30,14 @@ private:
   std::unordered_set<ir::InstID>
   findLoopInvariantComputation(std::size_t header, const UseDefChain &useDef);
 
-  void hoist(const std::unordered_set<std::size_t> &loopNodes,
+  void hoist(const ir::LabelSet &loopNodes,
              const std::unordered_set<ir::InstID> &invariant,
              std::size_t preHeader);
 
 private:
   const FuncAttr &funcAttr;
   LoopInfo loopTree;
-  std::unordered_map<std::size_t, std::size_t> preHeaders;
+  ir::LabelMap<std::size_t> preHeaders;
 };
 
 } // namespace mocker
@@ -23,7 +23,7 @@ bool UnusedFunctionRemoval::operator()() {
     if (func.isExternalFunc())
       continue;
     for (auto &bb : func.getBBs()) {
-      for (auto &inst : bb.getInsts()) {
+      for (auto inst : bb.getInsts()) {
         auto call = ir::dyc<ir::Call>(inst);
         if (!call)
           continue;
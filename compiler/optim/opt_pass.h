@@ -16,15 +16,24 @@ class FuncPass : public OptPass {
 public:
   explicit FuncPass(ir::FunctionModule &func) : func(func) {}
 
+  // The set of Analysis flags remaining valid after the pass modifies the
+  // function. A pass hiding it declares what it preserves.
+  static constexpr unsigned Preserved = 0;
+
 protected:
   ir::FunctionModule &func;
 };
 
 class BasicBlockPass : public OptPass {
 public:
-  explicit BasicBlockPass(ir::BasicBlock &bb) : bb(bb) {}
+  BasicBlockPass(ir::FunctionModule &func, ir::BasicBlock &bb)
+      : func(func), bb(bb) {}
+
+  // See FuncPass
+  static constexpr unsigned Preserved = 0;
 
 protected:
+  ir::FunctionModule &func; // where [bb] resides
   ir::BasicBlock &bb;
 };
 
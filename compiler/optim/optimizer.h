@@ -1,61 +1,244 @@
 #ifndef MOCKER_OPTIMIZER_H
 #define MOCKER_OPTIMIZER_H
 
+#include "analysis/analysis_manager.h"
+#include "common/time_report.h"
+#include "ir/helper.h"
 #include "ir/module.h"
 #include "opt_pass.h"
+#include "pass_stats.h"
+#include "thread_pool.h"
 
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <typeinfo>
 #include <unordered_set>
 #include <vector>
 
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
 namespace mocker {
+
+// The pool on which runOptPasses runs a function pass or a basic block pass on
+// the functions concurrently, if any.
+inline ThreadPool *&optimizerThreadPool() {
+  static ThreadPool *res = nullptr;
+  return res;
+}
+
 namespace detail {
 
+// The epochs at which [Pass] has been found to change nothing. Since equal
+// epochs imply identical contents, a function still at such an epoch need not
+// be visited by [Pass] again.
+template <class Pass> std::unordered_set<std::uint64_t> &noOpEpochs() {
+  static std::unordered_set<std::uint64_t> res;
+  return res;
+}
+
+// The epochs at which the functions have been verified.
+inline std::unordered_set<std::uint64_t> &verifiedEpochs() {
+  static std::unordered_set<std::uint64_t> res;
+  return res;
+}
+
+// The name of [Pass] without the namespace.
+template <class Pass> std::string passName() {
+  std::string res = typeid(Pass).name();
+#ifdef __GNUG__
+  int status = 0;
+  auto demangled = abi::__cxa_demangle(res.c_str(), nullptr, nullptr, &status);
+  if (status == 0)
+    res = demangled;
+  std::free(demangled);
+#endif
+  auto pos = res.rfind("::");
+  return pos == std::string::npos ? res : res.substr(pos + 2);
+}
+
 template <class Pass, class... Args>
-bool runOptPassImpl(ir::Module &module, BasicBlockPass *, Args &&... args) {
+bool runOptPassOnFunc(ir::FunctionModule &func, BasicBlockPass *,
+                      Args &&... args) {
   auto res = false;
-  for (auto &func : module.getFuncs()) {
-    if (func.second.isExternalFunc())
-      continue;
-    for (auto &bb : func.second.getMutableBBs()) {
-      res |= Pass{bb, std::forward<Args>(args)...}();
-    }
+  for (auto &bb : func.getMutableBBs()) {
+    res |= Pass{func, bb, std::forward<Args>(args)...}();
   }
   return res;
 }
 
 template <class Pass, class... Args>
-bool runOptPassImpl(ir::Module &module, FuncPass *, Args &&... args) {
-  auto res = false;
+bool runOptPassOnFunc(ir::FunctionModule &func, FuncPass *, Args &&... args) {
+  return Pass{func, std::forward<Args>(args)...}();
+}
+
+} // namespace detail
+
+// What a function pass or a basic block pass has done to a function.
+struct PassOutcome {
+  bool skipped = true;   // since it has changed nothing at the epoch
+  bool changed = false;  // as reported by the pass
+  bool modified = false; // whether the epoch of the function has been renewed
+};
+
+namespace detail {
+
+// Since a function pass only modifies its own function, the functions may be
+// visited concurrently. The extra arguments, such as a FuncAttr, are shared by
+// all of them and hence passed as const references, and the shared containers
+// are only updated after all the functions have been visited.
+template <class Pass, class PassKind, class... Args>
+std::vector<PassOutcome>
+runOptPassOnFuncs(const std::vector<ir::FunctionModule *> &funcs,
+                  PassKind *kind, Args &&... args) {
+  // A pass taking extra arguments may depend on more than the function.
+  constexpr bool Skippable = sizeof...(Args) == 0;
+  auto &noOp = noOpEpochs<Pass>();
+  std::vector<std::size_t> todo;
+  for (std::size_t i = 0; i < funcs.size(); ++i) {
+    if (!Skippable || noOp.find(funcs[i]->getEpoch()) == noOp.end())
+      todo.emplace_back(i);
+  }
+
+  std::vector<PassOutcome> res(funcs.size());
+  std::vector<std::uint64_t> epochs(funcs.size());
+  auto report = timeReport();
+  auto name = report ? passName<Pass>() : std::string();
+  auto run = [&](std::size_t k) {
+    auto begin = std::chrono::steady_clock::now();
+    auto i = todo[k];
+    auto &func = *funcs[i];
+    epochs[i] = func.getEpoch();
+    res[i].skipped = false;
+    res[i].changed = runOptPassOnFunc<Pass>(
+        func, kind,
+        static_cast<const std::remove_reference_t<Args> &>(args)...);
+    res[i].modified = func.getEpoch() != epochs[i];
+    getAnalysisManager().invalidate(func, epochs[i], Pass::Preserved);
+    if (report) {
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - begin;
+      report->addFuncTime(name, func.getIdentifier(), elapsed.count());
+    }
+  };
+  auto pool = optimizerThreadPool();
+  if (pool && pool->size() > 1 && todo.size() > 1) {
+    pool->parallelFor(todo.size(), run);
+  } else {
+    for (std::size_t k = 0; k < todo.size(); ++k)
+      run(k);
+  }
+
+  for (auto i : todo) {
+    if (Skippable && !res[i].changed && !res[i].modified)
+      noOp.emplace(epochs[i]);
+  }
+  return res;
+}
+
+template <class Pass, class PassKind, class... Args>
+bool runOptPassOnModuleFuncs(ir::Module &module, PassKind *kind,
+                             Args &&... args) {
+  std::vector<ir::FunctionModule *> funcs;
   for (auto &func : module.getFuncs()) {
-    if (func.second.isExternalFunc())
-      continue;
-    res |= Pass{func.second, std::forward<Args>(args)...}();
+    if (!func.second.isExternalFunc())
+      funcs.emplace_back(&func.second);
   }
+  auto res = false;
+  for (auto &outcome : runOptPassOnFuncs<Pass>(funcs, kind,
+                                               std::forward<Args>(args)...))
+    res |= outcome.changed;
   return res;
 }
 
+template <class Pass, class... Args>
+bool runOptPassImpl(ir::Module &module, BasicBlockPass *kind,
+                    Args &&... args) {
+  return runOptPassOnModuleFuncs<Pass>(module, kind,
+                                       std::forward<Args>(args)...);
+}
+
+template <class Pass, class... Args>
+bool runOptPassImpl(ir::Module &module, FuncPass *kind, Args &&... args) {
+  return runOptPassOnModuleFuncs<Pass>(module, kind,
+                                       std::forward<Args>(args)...);
+}
+
 template <class Pass, class... Args>
 bool runOptPassImpl(ir::Module &module, ModulePass *, Args &&... args) {
   return Pass{module, std::forward<Args>(args)...}();
 }
 
+// Run [body] with the statistics and the time of [Pass] recorded.
+template <class Pass, class Body>
+auto runInstrumented(ir::Module &module, Body body) -> decltype(body()) {
+  auto recorder = passStatsRecorder();
+  if (recorder)
+    recorder->beforePass(module);
+  auto report = timeReport();
+  decltype(body()) res;
+  {
+    TimeReport::Scope scope(report, report ? passName<Pass>() : "", true);
+    res = body();
+  }
+  if (recorder)
+    recorder->afterPass(passName<Pass>(), module);
+  return res;
+}
+
 } // namespace detail
 
+// Verify the functions modified since they were verified last time.
+inline void verifyModifiedFuncs(const ir::Module &module) {
+  for (auto &func : module.getFuncs()) {
+    if (!detail::verifiedEpochs().emplace(func.second.getEpoch()).second)
+      continue;
+#ifndef NDEBUG
+    func.second.checkContext();
+#endif
+    ir::verifyFuncModule(func.second);
+  }
+}
+
+// A function pass or a basic block pass without extra arguments is skipped on
+// the functions on which it has changed nothing since they were last modified.
+// The statistics are recorded if a PassStatsRecorder is installed, and the
+// time spent if a TimeReport is installed.
 template <class Pass, class... Args>
 bool runOptPasses(ir::Module &module, Args &&... args) {
   for (auto &func : module.getFuncs())
-    func.second.buildContext();
-  auto res = detail::runOptPassImpl<Pass>(module, (Pass *)(nullptr),
-                                          std::forward<Args>(args)...);
-  for (auto &func : module.getFuncs())
-    func.second.buildContext();
-  ir::verifyModule(module);
+    func.second.renumberBasicBlocks();
+  auto res = detail::runInstrumented<Pass>(module, [&] {
+    return detail::runOptPassImpl<Pass>(module, (Pass *)(nullptr),
+                                        std::forward<Args>(args)...);
+  });
+  verifyModifiedFuncs(module);
   return res;
 }
 
+// Like runOptPasses, but only visit [funcs] with a function pass or a basic
+// block pass, and leave the verification to the caller.
+template <class Pass, class... Args>
+std::vector<PassOutcome>
+runOptPassesOn(ir::Module &module,
+               const std::vector<ir::FunctionModule *> &funcs,
+               Args &&... args) {
+  static_assert(!std::is_base_of<ModulePass, Pass>::value,
+                "a module pass cannot be run on some functions only");
+  for (auto func : funcs)
+    func->renumberBasicBlocks();
+  return detail::runInstrumented<Pass>(module, [&] {
+    return detail::runOptPassOnFuncs<Pass>(funcs, (Pass *)(nullptr),
+                                           std::forward<Args>(args)...);
+  });
+}
+
 } // namespace mocker
 
 #endif // MOCKER_OPTIMIZER_H
@@ -0,0 +1,91 @@
+#include "pass_stats.h"
+
+namespace mocker {
+
+void PassStatsRecorder::beforePass(const ir::Module &module) {
+  epochsBefore.clear();
+  for (auto &kv : module.getFuncs()) {
+    if (kv.second.isExternalFunc())
+      continue;
+    getHistogram(kv.second);
+    epochsBefore.emplace(kv.first, kv.second.getEpoch());
+  }
+}
+
+void PassStatsRecorder::afterPass(std::string passName,
+                                  const ir::Module &module) {
+  Record record;
+  record.pass = std::move(passName);
+
+  std::unordered_map<std::uint64_t, ir::Histogram> alive;
+  for (auto &kv : module.getFuncs()) {
+    if (kv.second.isExternalFunc())
+      continue;
+    auto epoch = kv.second.getEpoch();
+    const auto &after = getHistogram(kv.second);
+    alive.emplace(epoch, after);
+    record.after += after;
+
+    auto iter = epochsBefore.find(kv.first);
+    if (iter == epochsBefore.end()) { // added by the pass
+      record.funcs[kv.first] = {ir::Histogram(), after};
+      continue;
+    }
+    const auto &before = histograms.at(iter->second);
+    alive.emplace(iter->second, before);
+    record.before += before;
+    if (iter->second != epoch)
+      record.funcs[kv.first] = {before, after};
+  }
+  for (auto &kv : epochsBefore) { // removed by the pass
+    if (module.getFuncs().find(kv.first) != module.getFuncs().end())
+      continue;
+    const auto &before = histograms.at(kv.second);
+    record.before += before;
+    record.funcs[kv.first] = {before, ir::Histogram()};
+  }
+
+  records.emplace_back(std::move(record));
+  histograms = std::move(alive);
+}
+
+void PassStatsRecorder::printJson(std::ostream &out) const {
+  out << "{\"passes\": [";
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    const auto &record = records[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "  {\"pass\": \"" << record.pass << "\", \"before\": ";
+    ir::printHistogramJson(record.before, out);
+    out << ", \"after\": ";
+    ir::printHistogramJson(record.after, out);
+    out << ", \"funcs\": {";
+    bool first = true;
+    for (auto &kv : record.funcs) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "    \"" << kv.first << "\": {\"before\": ";
+      ir::printHistogramJson(kv.second.first, out);
+      out << ", \"after\": ";
+      ir::printHistogramJson(kv.second.second, out);
+      out << "}";
+    }
+    out << (first ? "}}" : "\n  }}");
+  }
+  out << "\n]}" << std::endl;
+}
+
+const ir::Histogram &
+PassStatsRecorder::getHistogram(const ir::FunctionModule &func) {
+  auto iter = histograms.find(func.getEpoch());
+  if (iter != histograms.end())
+    return iter->second;
+  return histograms.emplace(func.getEpoch(), ir::buildHistogram(func))
+      .first->second;
+}
+
+PassStatsRecorder *&passStatsRecorder() {
+  static PassStatsRecorder *res = nullptr;
+  return res;
+}
+
+} // namespace mocker
@@ -0,0 +1,49 @@
+#ifndef MOCKER_PASS_STATS_H
+#define MOCKER_PASS_STATS_H
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir/module.h"
+#include "ir/stats.h"
+
+namespace mocker {
+
+// Records the histograms of the functions before and after each pass. Since
+// equal epochs imply identical contents, the histogram of a function is only
+// rebuilt after the function has been modified.
+class PassStatsRecorder {
+public:
+  void beforePass(const ir::Module &module);
+
+  void afterPass(std::string passName, const ir::Module &module);
+
+  // {"passes": [{"pass": ..., "before": ..., "after": ..., "funcs": {...}}]},
+  // where "funcs" only contains the functions changed by the pass.
+  void printJson(std::ostream &out) const;
+
+private:
+  const ir::Histogram &getHistogram(const ir::FunctionModule &func);
+
+  struct Record {
+    std::string pass;
+    ir::Histogram before, after;
+    std::map<std::string, std::pair<ir::Histogram, ir::Histogram>> funcs;
+  };
+
+  std::unordered_map<std::uint64_t, ir::Histogram> histograms; // by epoch
+  std::map<std::string, std::uint64_t> epochsBefore;
+  std::vector<Record> records;
+};
+
+// The recorder used by runOptPasses, if any.
+PassStatsRecorder *&passStatsRecorder();
+
+} // namespace mocker
+
+#endif // MOCKER_PASS_STATS_H
@@ -0,0 +1,248 @@
+#include "pipeline.h"
+
+#include <cctype>
+#include <map>
+#include <stdexcept>
+
+#include "analysis/analysis_manager.h"
+#include "codegen_prepare.h"
+#include "constant_propagation.h"
+#include "copy_propagation.h"
+#include "dead_code_elimination.h"
+#include "function_inline.h"
+#include "global_const_inline.h"
+#include "global_value_numbering.h"
+#include "induction_variable.h"
+#include "local_value_numbering.h"
+#include "loopinv.h"
+#include "module_simplification.h"
+#include "optimizer.h"
+#include "promote_global_variables.h"
+#include "reassociation.h"
+#include "simplify_cfg.h"
+#include "ssa.h"
+
+namespace mocker {
+namespace {
+
+using PassRunner = bool (*)(ir::Module &module);
+
+template <class Pass> bool runPass(ir::Module &module) {
+  return runOptPasses<Pass>(module);
+}
+
+template <class Pass> bool runPassWithFuncAttr(ir::Module &module) {
+  return runOptPasses<Pass>(module,
+                            *getAnalysisManager().getFuncAttr(module));
+}
+
+const std::map<std::string, PassRunner> &getPasses() {
+  static const std::map<std::string, PassRunner> res = {
+      {"CodegenPreparation", &runPass<CodegenPreparation>},
+      {"CopyPropagation", &runPass<CopyPropagation>},
+      {"DeadCodeElimination", &runPassWithFuncAttr<DeadCodeElimination>},
+      {"FunctionInline", &runPass<FunctionInline>},
+      {"GlobalConstantInline", &runPass<GlobalConstantInline>},
+      {"GlobalValueNumbering", &runPass<GlobalValueNumbering>},
+      {"InductionVariable", &runPassWithFuncAttr<InductionVariable>},
+      {"LocalValueNumbering", &runPass<LocalValueNumbering>},
+      {"LoopInvariantCodeMotion",
+       &runPassWithFuncAttr<LoopInvariantCodeMotion>},
+      {"MergeBlocks", &runPass<MergeBlocks>},
+      {"PromoteGlobalVariables", &runPass<PromoteGlobalVariables>},
+      {"Reassociation", &runPass<Reassociation>},
+      {"RemoveTrivialBlocks", &runPass<RemoveTrivialBlocks>},
+      {"RemoveUnreachableBlocks", &runPass<RemoveUnreachableBlocks>},
+      {"RewriteBranches", &runPass<RewriteBranches>},
+      {"SSAConstruction", &runPass<SSAConstruction>},
+      {"SSADestruction", &runPass<SSADestruction>},
+      {"SimplifyPhiFunctions", &runPass<SimplifyPhiFunctions>},
+      {"SparseSimpleConstantPropagation",
+       &runPass<SparseSimpleConstantPropagation>},
+      {"UnusedFunctionRemoval", &runPass<UnusedFunctionRemoval>}};
+  return res;
+}
+
+void skipSpaces(const std::string &desc, std::size_t &pos) {
+  while (pos < desc.size() && std::isspace((unsigned char)desc[pos]))
+    ++pos;
+}
+
+} // namespace
+
+constexpr std::size_t Pipeline::MaxIterations;
+
+Pipeline Pipeline::parse(const std::string &desc) {
+  Pipeline res;
+  std::size_t pos = 0;
+  skipSpaces(desc, pos);
+  if (pos == desc.size())
+    return res;
+  res.nodes = parseList(desc, pos);
+  if (pos != desc.size())
+    throw std::invalid_argument("unexpected '" + desc.substr(pos, 1) +
+                                "' in the pipeline");
+  auto ssa = false;
+  checkList(res.nodes, ssa, true);
+  return res;
+}
+
+void Pipeline::checkList(const std::vector<Node> &nodes, bool &ssa,
+                         bool isTopLevel) {
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    auto &node = nodes[i];
+    if (node.pass.empty()) {
+      // A rerun starts from where the previous one ends.
+      auto entry = ssa;
+      checkList(node.group, ssa, false);
+      if (ssa != entry)
+        checkList(node.group, ssa, false);
+      continue;
+    }
+    if (node.pass == "CodegenPreparation" &&
+        (!isTopLevel || i + 1 != nodes.size()))
+      throw std::invalid_argument(
+          "CodegenPreparation can only be the last pass of the pipeline");
+    if (node.pass == "FunctionInline" && ssa)
+      throw std::invalid_argument("FunctionInline can not run on the SSA "
+                                  "form, i.e. between SSAConstruction and "
+                                  "SSADestruction");
+    if (node.pass == "SSAConstruction")
+      ssa = true;
+    else if (node.pass == "SSADestruction")
+      ssa = false;
+  }
+}
+
+std::vector<Pipeline::Node> Pipeline::parseList(const std::string &desc,
+                                                std::size_t &pos) {
+  std::vector<Node> res;
+  while (true) {
+    skipSpaces(desc, pos);
+    auto begin = pos;
+    while (pos < desc.size() &&
+           (std::isalnum((unsigned char)desc[pos]) || desc[pos] == '_'))
+      ++pos;
+    auto name = desc.substr(begin, pos - begin);
+    skipSpaces(desc, pos);
+
+    Node node;
+    if (name == "fixpoint" && pos < desc.size() && desc[pos] == '(') {
+      ++pos;
+      node.group = parseList(desc, pos);
+      if (pos == desc.size() || desc[pos] != ')')
+        throw std::invalid_argument("unclosed fixpoint group in the pipeline");
+      ++pos;
+      skipSpaces(desc, pos);
+    } else if (name.empty()) {
+      throw std::invalid_argument("missing a pass in the pipeline");
+    } else if (getPasses().find(name) == getPasses().end()) {
+      throw std::invalid_argument("unknown pass: " + name);
+    } else {
+      node.pass = name;
+    }
+    res.emplace_back(std::move(node));
+
+    if (pos == desc.size() || desc[pos] != ',')
+      return res;
+    ++pos;
+  }
+}
+
+std::vector<std::string> Pipeline::getPassNames() {
+  std::vector<std::string> res;
+  for (auto &kv : getPasses())
+    res.emplace_back(kv.first);
+  return res;
+}
+
+bool Pipeline::run(ir::Module &module) const {
+  return runList(module, nodes);
+}
+
+bool Pipeline::runList(ir::Module &module, const std::vector<Node> &nodes) {
+  auto res = false;
+  for (auto &node : nodes) {
+    if (!node.pass.empty()) {
+      res |= getPasses().at(node.pass)(module);
+      continue;
+    }
+    for (std::size_t i = 0; i < MaxIterations; ++i) {
+      if (!runList(module, node.group))
+        break;
+      res = true;
+    }
+  }
+  return res;
+}
+
+const std::string &getLoweringPipeline() {
+  // The instruction selection requires the SSA form rebuilt from the
+  // destructed one, as at the end of -O3, where each phi-function is isolated
+  // by the copies SSADestruction leaves behind. Those copies only exist if the
+  // IR was in the SSA form, hence the SSAConstruction first, which does
+  // nothing to the IR already in the SSA form.
+  static const std::string res =
+      "SSAConstruction,SSADestruction,RemoveUnreachableBlocks,"
+      "SSAConstruction,"
+      "fixpoint(SimplifyPhiFunctions,MergeBlocks,RemoveUnreachableBlocks,"
+      "DeadCodeElimination,RemoveUnreachableBlocks)";
+  return res;
+}
+
+std::string getCustomPipeline(const std::string &passes) {
+  // The frontend leaves unreachable blocks behind, which some passes can not
+  // handle.
+  static const std::string Head = "RemoveUnreachableBlocks";
+  static const std::string Tail = getLoweringPipeline() + ",CodegenPreparation";
+  // Report the errors of [passes] without the head and the tail.
+  auto pipeline = Pipeline::parse(passes);
+  if (pipeline.endsWith("CodegenPreparation"))
+    throw std::invalid_argument("CodegenPreparation always ends the pipeline "
+                                "and can not be given in --passes");
+  if (pipeline.empty())
+    return getPresetPipeline(0);
+  return Head + "," + passes + "," + Tail;
+}
+
+const std::string &getPresetPipeline(int level) {
+  auto &Lowering = getLoweringPipeline();
+  // Only what the instruction selection requires, which is what every pipeline
+  // ends with.
+  static const std::string O0 =
+      "RemoveUnreachableBlocks," + Lowering + ",CodegenPreparation";
+  // A single sweep of the cheap passes.
+  static const std::string O1 =
+      "RemoveUnreachableBlocks,SSAConstruction,CopyPropagation,"
+      "SparseSimpleConstantPropagation,DeadCodeElimination,RewriteBranches,"
+      "RemoveUnreachableBlocks,MergeBlocks," +
+      Lowering + ",CodegenPreparation";
+  // The fixed-point cleanup of -O3 without inlining and the loop passes.
+  static const std::string O2 =
+      "SparseSimpleConstantPropagation,GlobalConstantInline,"
+      "RemoveUnreachableBlocks,PromoteGlobalVariables,RewriteBranches,"
+      "SimplifyPhiFunctions,MergeBlocks,RemoveUnreachableBlocks,"
+      "SSAConstruction,DeadCodeElimination,"
+      "fixpoint(RewriteBranches,SimplifyPhiFunctions,MergeBlocks,"
+      "RemoveUnreachableBlocks,GlobalValueNumbering,LocalValueNumbering,"
+      "CopyPropagation,SparseSimpleConstantPropagation,CopyPropagation,"
+      "SimplifyPhiFunctions,RemoveUnreachableBlocks,RewriteBranches,"
+      "SimplifyPhiFunctions,MergeBlocks,SimplifyPhiFunctions,"
+      "RemoveUnreachableBlocks,RemoveTrivialBlocks,SimplifyPhiFunctions,"
+      "MergeBlocks,RemoveUnreachableBlocks,DeadCodeElimination,"
+      "RemoveUnreachableBlocks)," +
+      Lowering + ",CodegenPreparation";
+  switch (level) {
+  case 0:
+    return O0;
+  case 1:
+    return O1;
+  case 2:
+    return O2;
+  default:
+    throw std::invalid_argument("no preset pipeline for -O" +
+                                std::to_string(level));
+  }
+}
+
+} // namespace mocker
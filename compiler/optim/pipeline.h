@@ -0,0 +1,74 @@
+#ifndef MOCKER_PIPELINE_H
+#define MOCKER_PIPELINE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ir/module.h"
+
+namespace mocker {
+
+// A sequence of passes described by a string like
+//   SSAConstruction,fixpoint(CopyPropagation,DeadCodeElimination)
+// where a pass is named after its class and a fixpoint group is rerun until
+// none of its passes changes anything, at most MaxIterations times. The
+// passes taking a FuncAttr get an up-to-date one right before they run. The
+// pipeline starts from the IR built by the frontend, which is not in the SSA
+// form.
+class Pipeline {
+public:
+  static constexpr std::size_t MaxIterations = 100;
+
+  // Throw std::invalid_argument if [desc] is malformed, names an unknown
+  // pass, runs FunctionInline on the SSA form or has CodegenPreparation
+  // anywhere but at the end. An empty [desc] gives an empty pipeline.
+  static Pipeline parse(const std::string &desc);
+
+  static std::vector<std::string> getPassNames();
+
+  // Return whether any pass has changed anything.
+  bool run(ir::Module &module) const;
+
+  bool empty() const { return nodes.empty(); }
+
+  // Whether the last pass run at the top level is [pass]
+  bool endsWith(const std::string &pass) const {
+    return !nodes.empty() && nodes.back().pass == pass;
+  }
+
+private:
+  struct Node {
+    std::string pass; // empty for a fixpoint group
+    std::vector<Node> group;
+  };
+
+  static std::vector<Node> parseList(const std::string &desc,
+                                     std::size_t &pos);
+
+  static bool runList(ir::Module &module, const std::vector<Node> &nodes);
+
+  // [ssa]: whether the IR is in the SSA form before and after [nodes]
+  static void checkList(const std::vector<Node> &nodes, bool &ssa,
+                        bool isTopLevel);
+
+  std::vector<Node> nodes;
+};
+
+// The passes turning any valid IR into the form required by the instruction
+// selection.
+const std::string &getLoweringPipeline();
+
+// The pipelines of -O0, -O1 and -O2, each ending with the lowering and
+// CodegenPreparation. The default -O3 is the hand-tuned one of the driver.
+const std::string &getPresetPipeline(int level);
+
+// [passes] given by the user, preceded by RemoveUnreachableBlocks and followed
+// by the lowering and CodegenPreparation, so that any of them can be handed to
+// the codegen. An empty [passes] gives -O0. Throw std::invalid_argument as
+// Pipeline::parse does, or if [passes] has CodegenPreparation.
+std::string getCustomPipeline(const std::string &passes);
+
+} // namespace mocker
+
+#endif // MOCKER_PIPELINE_H
@@ -0,0 +1,15 @@
+#include "profile_use.h"
+
+namespace mocker {
+
+const ir::Profile *&installedProfile() {
+  static const ir::Profile *res = nullptr;
+  return res;
+}
+
+const ir::FuncProfile *findProfile(const ir::FunctionModule &func) {
+  auto profile = installedProfile();
+  return profile ? profile->findFunc(func) : nullptr;
+}
+
+} // namespace mocker
@@ -0,0 +1,18 @@
+#ifndef MOCKER_PROFILE_USE_H
+#define MOCKER_PROFILE_USE_H
+
+#include "ir/module.h"
+#include "ir/profile.h"
+
+namespace mocker {
+
+// The profile installed by the driver to guide the optimizations, or nullptr.
+// The passes fall back to their static heuristics without it.
+const ir::Profile *&installedProfile();
+
+// Return nullptr if no profile is installed or it does not apply to [func].
+const ir::FuncProfile *findProfile(const ir::FunctionModule &func);
+
+} // namespace mocker
+
+#endif // MOCKER_PROFILE_USE_H
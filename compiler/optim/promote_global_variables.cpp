@@ -35,22 +35,23 @@ void PromoteGlobalVariables::promoteGlobalVariables(ir::FunctionModule &func) {
 
   // Rename the load & store
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
 
-      if (auto p = ir::dyc<ir::Store>(inst)) {
+      if (auto p = ir::dyc<ir::Store>(*iter)) {
         auto reg = ir::dycGlobalReg(p->getAddr());
         if (!reg)
           continue;
         reg = aliasReg.at(reg->getIdentifier());
-        inst = std::make_shared<ir::Store>(reg, p->getVal());
+        iter = insts.replace(iter, func.makeInst<ir::Store>(reg, p->getVal()));
         continue;
       }
-      if (auto p = ir::dyc<ir::Load>(inst)) {
+      if (auto p = ir::dyc<ir::Load>(*iter)) {
         auto reg = ir::dycGlobalReg(p->getAddr());
         if (!reg)
           continue;
         reg = aliasReg.at(reg->getIdentifier());
-        inst = std::make_shared<ir::Load>(p->getDest(), reg);
+        iter = insts.replace(iter, func.makeInst<ir::Load>(p->getDest(), reg));
         continue;
       }
     }
@@ -59,14 +60,14 @@ void PromoteGlobalVariables::promoteGlobalVariables(ir::FunctionModule &func) {
   // Insert Alloca's
   auto &firstBB = *func.getFirstBB();
   for (auto &nameReg : aliasReg) {
-    std::list<std::shared_ptr<ir::IRInst>> toBeInserted;
-    auto gReg = std::make_shared<ir::Reg>(nameReg.first);
-    toBeInserted.emplace_back(std::make_shared<ir::Alloca>(nameReg.second));
+    ir::InstList toBeInserted;
+    auto gReg = func.makeReg(nameReg.first);
+    toBeInserted.push_back(func.makeInst<ir::Alloca>(nameReg.second));
     auto tmp = func.makeTempLocalReg();
-    toBeInserted.emplace_back(std::make_shared<ir::Load>(tmp, gReg));
-    toBeInserted.emplace_back(std::make_shared<ir::Store>(nameReg.second, tmp));
+    toBeInserted.push_back(func.makeInst<ir::Load>(tmp, gReg));
+    toBeInserted.push_back(func.makeInst<ir::Store>(nameReg.second, tmp));
     firstBB.getMutableInsts().splice(firstBB.getMutableInsts().begin(),
-                                     std::move(toBeInserted));
+                                     toBeInserted);
   }
 
   // Insert Loads & Stores before Calls and Rets
@@ -77,23 +78,23 @@ void PromoteGlobalVariables::promoteGlobalVariables(ir::FunctionModule &func) {
                                               const std::string &name) {
       if (name == "@null")
         return;
-      auto gReg = std::make_shared<ir::Reg>(name);
+      auto gReg = func.makeReg(name);
       auto alias = aliasReg.at(name);
       auto tmp = func.makeTempLocalReg();
-      insts.insert(iter, std::make_shared<ir::Load>(tmp, alias));
-      insts.insert(iter, std::make_shared<ir::Store>(gReg, tmp));
+      insts.insert(iter, func.makeInst<ir::Load>(tmp, alias));
+      insts.insert(iter, func.makeInst<ir::Store>(gReg, tmp));
     };
 
     auto reLoad = [&insts, &func, &aliasReg](ir::InstListIter iter,
                                              const std::string &name) {
       if (name == "@null")
         return;
-      auto gReg = std::make_shared<ir::Reg>(name);
+      auto gReg = func.makeReg(name);
       auto alias = aliasReg.at(name);
       ++iter;
       auto tmp = func.makeTempLocalReg();
-      insts.insert(iter, std::make_shared<ir::Load>(tmp, gReg));
-      insts.insert(iter, std::make_shared<ir::Store>(alias, tmp));
+      insts.insert(iter, func.makeInst<ir::Load>(tmp, gReg));
+      insts.insert(iter, func.makeInst<ir::Store>(alias, tmp));
     };
 
     for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
@@ -10,7 +10,7 @@
 namespace mocker {
 
 void detail::ReassociationImpl::findRoots() {
-  for (auto &inst : bb.getInsts()) {
+  for (auto inst : bb.getInsts()) {
     auto dest = ir::getDest(inst);
     if (!dest)
       continue;
@@ -229,7 +229,9 @@ void detail::ReassociationImpl::rankNodes(
     const std::shared_ptr<ir::Reg> &root) {
   if (isIn(rankedNodes, root))
     return;
-  auto &res = rankedNodes[root];
+  // Filled before being put into [rankedNodes], which the recursive calls may
+  // grow.
+  std::priority_queue<RankedNode> res;
 
   int rank = 0;
   auto &nodes = flattenedNodes.at(root);
@@ -256,6 +258,7 @@ void detail::ReassociationImpl::rankNodes(
   }
 
   rootRank[root] = rank;
+  rankedNodes[root] = std::move(res);
 }
 
 void detail::ReassociationImpl::rebuild(const std::shared_ptr<ir::Reg> &root) {
@@ -272,12 +275,12 @@ void detail::ReassociationImpl::rebuild(const std::shared_ptr<ir::Reg> &root) {
   }
   assert(pos != bb.getMutableInsts().end());
   rebuild(rankedNodes.at(root), pos);
-  *pos = std::make_shared<ir::Deleted>();
+  bb.getMutableInsts().replace(pos, func.makeInst<ir::Deleted>());
 }
 
 void detail::ReassociationImpl::rebuild(
     std::priority_queue<detail::ReassociationImpl::RankedNode> &q,
-    std::list<std::shared_ptr<ir::IRInst>>::iterator pos) {
+    ir::InstListIter pos) {
   auto &insts = bb.getMutableInsts();
   auto dest = ir::getDest(*pos);
 
@@ -286,9 +289,9 @@ void detail::ReassociationImpl::rebuild(
   if (q.size() == 1) {
     auto val = q.top();
     if (val.positive)
-      insts.insert(pos, std::make_shared<ir::Assign>(dest, val.value));
+      insts.insert(pos, func.makeInst<ir::Assign>(dest, val.value));
     else
-      insts.insert(pos, std::make_shared<ir::ArithUnaryInst>(
+      insts.insert(pos, func.makeInst<ir::ArithUnaryInst>(
                             dest, ir::ArithUnaryInst::Neg, val.value));
     return;
   }
@@ -314,11 +317,11 @@ void detail::ReassociationImpl::rebuild(
     auto lhsVal = lhs.value;
     if (!lhs.positive) {
       lhsVal = func.makeTempLocalReg();
-      auto newInst = std::make_shared<ir::ArithUnaryInst>(
+      auto newInst = func.makeInst<ir::ArithUnaryInst>(
           ir::dycLocalReg(lhsVal), ir::ArithUnaryInst::Neg, lhs.value);
       insts.insert(pos, newInst);
     }
-    auto newInst = std::make_shared<ir::ArithBinaryInst>(
+    auto newInst = func.makeInst<ir::ArithBinaryInst>(
         dest,
         rhs.positive ? ir::ArithBinaryInst::Add : ir::ArithBinaryInst::Sub,
         lhsVal, rhs.value);
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <queue>
 
+#include "analysis/analysis_manager.h"
 #include "analysis/defuse.h"
 #include "opt_pass.h"
 #include "set_operation.h"
@@ -70,8 +71,7 @@ private:
 
   void rebuild(const std::shared_ptr<ir::Reg> &root);
 
-  void rebuild(std::priority_queue<RankedNode> &q,
-               std::list<std::shared_ptr<ir::IRInst>>::iterator pos);
+  void rebuild(std::priority_queue<RankedNode> &q, ir::InstListIter pos);
 
 private:
   ir::BasicBlock &bb;
@@ -100,14 +100,14 @@ class Reassociation : public FuncPass {
 public:
   explicit Reassociation(ir::FunctionModule &func) : FuncPass(func) {}
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override {
-    DefUseChain defUse;
-    UseDefChain useDef;
-    defUse.init(func);
-    useDef.init(func);
+    auto defUse = getAnalysisManager().getDefUseChain(func);
+    auto useDef = getAnalysisManager().getUseDefChain(func);
 
     for (auto &bb : func.getMutableBBs()) {
-      detail::ReassociationImpl(bb, func, defUse, useDef)();
+      detail::ReassociationImpl(bb, func, *defUse, *useDef)();
     }
 
     return false;
@@ -5,7 +5,6 @@
 #include <functional>
 #include <iostream>
 #include <queue>
-#include <unordered_set>
 
 #include "helper.h"
 
@@ -16,14 +15,16 @@ namespace {
 std::vector<std::size_t> topoSort(const std::vector<std::size_t> &nodes,
                                   const ir::FunctionModule &func) {
   // label -> predcessors
-  std::unordered_map<std::size_t, std::unordered_set<std::size_t>> subGraph;
+  ir::LabelMap<ir::LabelSet> subGraph;
   {
-    std::unordered_set<std::size_t> nodesUsed{nodes.begin(), nodes.end()};
+    ir::LabelSet nodesUsed;
+    for (auto node : nodes)
+      nodesUsed.emplace(node);
     auto predGraph = buildBlockPredecessors(func);
     for (auto node : nodesUsed) {
       auto &preds = subGraph[node];
       for (auto pred : predGraph.at(node))
-        if (nodesUsed.find(pred) != nodesUsed.end())
+        if (nodesUsed.count(pred))
           preds.emplace(pred);
     }
   }
@@ -50,12 +51,12 @@ std::vector<std::size_t> topoSort(const std::vector<std::size_t> &nodes,
 
     for (auto node : nodesWithNoPred) {
       res.emplace_back(node);
-      subGraph.erase(subGraph.find(node));
+      subGraph.erase(node);
       for (auto succ : func.getBasicBlock(node).getSuccessors()) {
         auto iter = subGraph.find(succ);
         if (iter == subGraph.end())
           continue;
-        iter->second.erase(iter->second.find(node));
+        iter->second.erase(node);
       }
     }
 
@@ -76,12 +77,14 @@ std::vector<std::size_t> topoSort(const std::vector<std::size_t> &nodes,
 
 namespace mocker {
 
-void deletePhiOptionInBB(ir::BasicBlock &bb, std::size_t toBeDeleted) {
-  for (auto &inst : bb.getMutableInsts()) {
-    auto phi = ir::dyc<ir::Phi>(inst);
+void deletePhiOptionInBB(ir::FunctionModule &func, ir::BasicBlock &bb,
+                         std::size_t toBeDeleted) {
+  auto &insts = bb.getMutableInsts();
+  for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+    auto phi = ir::dyc<ir::Phi>(*iter);
     if (!phi)
       break;
-    inst = deletePhiOption(phi, toBeDeleted);
+    iter = insts.replace(iter, deletePhiOption(func, phi, toBeDeleted));
   }
 }
 
@@ -89,8 +92,9 @@ RewriteBranches::RewriteBranches(ir::FunctionModule &func) : FuncPass(func) {}
 
 bool RewriteBranches::operator()() {
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      auto br = ir::dyc<ir::Branch>(inst);
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      auto br = ir::dyc<ir::Branch>(*iter);
       if (!br)
         continue;
       auto condition = ir::dyc<ir::IntLiteral>(br->getCondition());
@@ -98,9 +102,9 @@ bool RewriteBranches::operator()() {
         continue;
       ++cnt;
       auto target = condition->getVal() ? br->getThen() : br->getElse();
-      inst = std::make_shared<ir::Jump>(target);
+      iter = insts.replace(iter, func.makeInst<ir::Jump>(target));
       auto notTarget = condition->getVal() ? br->getElse() : br->getThen();
-      deletePhiOptionInBB(func.getMutableBasicBlock(notTarget->getID()),
+      deletePhiOptionInBB(func, func.getMutableBasicBlock(notTarget->getID()),
                           bb.getLabelID());
     }
   }
@@ -112,12 +116,11 @@ RemoveUnreachableBlocks::RemoveUnreachableBlocks(ir::FunctionModule &func)
     : FuncPass(func) {}
 
 bool RemoveUnreachableBlocks::operator()() {
-  std::unordered_set<std::size_t> reachable;
+  ir::LabelSet reachable;
   std::function<void(std::size_t cur)> visit = [&visit, &reachable,
                                                 this](std::size_t cur) {
-    if (reachable.find(cur) != reachable.end())
+    if (!reachable.emplace(cur).second)
       return;
-    reachable.emplace(cur);
     for (auto suc : func.getBasicBlock(cur).getSuccessors())
       visit(suc);
   };
@@ -127,12 +130,13 @@ bool RemoveUnreachableBlocks::operator()() {
     if (reachable.find(bb.getLabelID()) != reachable.end())
       continue;
     for (auto &succ : bb.getSuccessors()) {
-      deletePhiOptionInBB(func.getMutableBasicBlock(succ), bb.getLabelID());
+      deletePhiOptionInBB(func, func.getMutableBasicBlock(succ),
+                          bb.getLabelID());
     }
   }
 
   cnt = func.getBBs().size() - reachable.size();
-  func.getMutableBBs().remove_if([&reachable](const ir::BasicBlock &bb) {
+  func.removeBBIf([&reachable](const ir::BasicBlock &bb) {
     return reachable.find(bb.getLabelID()) == reachable.end();
   });
   return cnt != 0;
@@ -159,11 +163,12 @@ bool MergeBlocks::operator()() {
     auto &bb = func.getMutableBasicBlock(bbLabel);
     for (auto succ : bb.getSuccessors()) {
       auto &succBB = func.getMutableBasicBlock(succ);
-      for (auto &inst : succBB.getMutableInsts()) {
-        auto phi = ir::dyc<ir::Phi>(inst);
+      auto &insts = succBB.getMutableInsts();
+      for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+        auto phi = ir::dyc<ir::Phi>(*iter);
         if (!phi)
           break;
-        inst = replacePhiOption(phi, bbLabel, pred);
+        iter = insts.replace(iter, replacePhiOption(func, phi, bbLabel, pred));
       }
     }
     predBB.getMutableInsts().pop_back();
@@ -175,7 +180,7 @@ bool MergeBlocks::operator()() {
     merge(preds.at(u).at(0), u);
   }
 
-  func.getMutableBBs().remove_if(
+  func.removeBBIf(
       [](const ir::BasicBlock &bb) { return bb.getInsts().empty(); });
 
   //  std::cerr << "MergeBlocks: Merged " << mergeable.size() << " BBs in "
@@ -196,7 +201,7 @@ bool RemoveTrivialBlocks::operator()() {
       if (!jump)
         continue;
       bool ok = true;
-      for (auto &inst :
+      for (auto inst :
            func.getBasicBlock(jump->getLabel()->getID()).getInsts()) {
         auto phi = ir::dyc<ir::Phi>(inst);
         if (!phi)
@@ -231,11 +236,13 @@ bool RemoveTrivialBlocks::operator()() {
 
     for (auto predLabel : preds) {
       auto &pred = func.getMutableBasicBlock(predLabel);
-      auto &terminator = pred.getMutableInsts().back();
-      terminator = replaceTerminatorLabel(terminator, curLabel, targetLabel);
+      auto &insts = pred.getMutableInsts();
+      auto newTerminator =
+          replaceTerminatorLabel(func, insts.back(), curLabel, targetLabel);
+      insts.replace(--insts.end(), newTerminator);
     }
 
-    auto newPhi = [&preds, curLabel](const std::shared_ptr<ir::Phi> &old) {
+    auto newPhi = [this, &preds, curLabel](const ir::Phi *old) {
       auto dest = old->getDest();
       auto oldOptions = old->getOptions();
       std::vector<ir::Phi::Option> options;
@@ -252,22 +259,24 @@ bool RemoveTrivialBlocks::operator()() {
       for (auto pred : preds)
         options.emplace_back(
             std::make_pair(val, std::make_shared<ir::Label>(pred)));
-      return std::make_shared<ir::Phi>(std::move(dest), std::move(options));
+      return func.makeInst<ir::Phi>(std::move(dest), std::move(options));
     };
 
     auto &succ = func.getMutableBasicBlock(targetLabel);
-    for (auto &inst : succ.getMutableInsts()) {
-      auto phi = ir::dyc<ir::Phi>(inst);
+    auto &insts = succ.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      auto phi = ir::dyc<ir::Phi>(*iter);
       if (!phi)
         break;
-      inst = newPhi(phi);
+      iter = insts.replace(iter, newPhi(phi));
     }
   }
 
-  std::unordered_set<std::size_t> removable{toBeRemoved.begin(),
-                                            toBeRemoved.end()};
-  func.getMutableBBs().remove_if([&removable](const ir::BasicBlock &bb) {
-    return removable.find(bb.getLabelID()) != removable.end();
+  ir::LabelSet removable;
+  for (auto label : toBeRemoved)
+    removable.emplace(label);
+  func.removeBBIf([&removable](const ir::BasicBlock &bb) {
+    return removable.count(bb.getLabelID());
   });
 
   //  std::cerr << "RemoveTrivialBlocks: removed " << toBeRemoved.size()
@@ -15,7 +15,7 @@ namespace mocker {
 SSAConstruction::SSAConstruction(ir::FunctionModule &func) : FuncPass(func) {}
 
 bool SSAConstruction::operator()() {
-  dominatorTree.init(func);
+  dominatorTree = getAnalysisManager().getDominatorTree(func);
   insertPhiFunctions();
   renameVariables();
   return false;
@@ -24,7 +24,7 @@ bool SSAConstruction::operator()() {
 void SSAConstruction::insertPhiFunctions() {
   // collect varNames
   const auto &firstBB = *func.getFirstBB();
-  for (const auto &inst : firstBB.getInsts()) {
+  for (auto inst : firstBB.getInsts()) {
     if (auto p = ir::dyc<ir::Alloca>(inst)) {
       auto reg = ir::dycLocalReg(p->getDest());
       assert(reg);
@@ -37,7 +37,7 @@ void SSAConstruction::insertPhiFunctions() {
 }
 
 void SSAConstruction::insertPhiFunctions(const std::string &varName) {
-  LabelSet originalDefs, added;
+  ir::LabelSet originalDefs, added;
   std::queue<Definition> remaining;
   auto defs = collectAndReplaceDefs(varName);
   for (const auto &def : defs) {
@@ -48,14 +48,13 @@ void SSAConstruction::insertPhiFunctions(const std::string &varName) {
   while (!remaining.empty()) {
     auto def = remaining.front();
     remaining.pop();
-    const auto &frontier = dominatorTree.getDominanceFrontier(def.blockLabel);
-    for (const auto &frontierBB : frontier) {
+    const auto &frontier = dominatorTree->getDominanceFrontier(def.blockLabel);
+    for (auto frontierBB : frontier) {
       if (isIn(added, frontierBB))
         continue;
 
       auto dest = func.makeTempLocalReg(varName);
-      auto phi =
-          std::make_shared<ir::Phi>(dest, std::vector<ir::Phi::Option>());
+      auto phi = func.makeInst<ir::Phi>(dest, std::vector<ir::Phi::Option>());
       varDefined[phi->getID()] = varName;
       bbDefined[dest->getIdentifier()] = frontierBB;
       auto &bbInst = func.getMutableBasicBlock(frontierBB);
@@ -72,11 +71,12 @@ std::vector<SSAConstruction::Definition>
 SSAConstruction::collectAndReplaceDefs(const std::string &name) {
   std::vector<Definition> res;
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      if (inst->getInstType() != ir::IRInst::Store)
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      if ((*iter)->getInstType() != ir::IRInst::Store)
         continue;
 
-      auto p = std::static_pointer_cast<ir::Store>(inst);
+      auto p = static_cast<ir::Store *>(*iter);
       auto reg = ir::dycLocalReg(p->getAddr());
       if (!reg)
         continue;
@@ -84,8 +84,8 @@ SSAConstruction::collectAndReplaceDefs(const std::string &name) {
         continue;
       auto dest = func.makeTempLocalReg(name);
       res.emplace_back(bb.getLabelID(), reg);
-      auto assign = std::make_shared<ir::Assign>(dest, p->getVal());
-      inst = assign;
+      auto assign = func.makeInst<ir::Assign>(dest, p->getVal());
+      iter = insts.replace(iter, assign);
       varDefined[assign->getID()] = reg->getIdentifier();
       bbDefined[dest->getIdentifier()] = bb.getLabelID();
     }
@@ -104,7 +104,9 @@ void SSAConstruction::renameVariables() {
 void SSAConstruction::renameVariablesImpl(std::size_t curNode) {
   auto &bb = func.getMutableBasicBlock(curNode);
 
-  for (auto &inst : bb.getMutableInsts()) {
+  auto &insts = bb.getMutableInsts();
+  for (auto instIter = insts.begin(); instIter != insts.end(); ++instIter) {
+    auto inst = *instIter;
     if (auto p = ir::dyc<ir::Phi>(inst)) {
       auto iter = varDefined.find(p->getID());
       if (iter == varDefined.end())
@@ -125,9 +127,9 @@ void SSAConstruction::renameVariablesImpl(std::size_t curNode) {
         continue;
       // I think that the corresponding line in the SSA book is wrong.
       updateReachingDef(var->getIdentifier(), bb.getLabelID());
-      inst = std::make_shared<ir::Assign>(
-          p->getDest(),
-          std::make_shared<ir::Reg>(reachingDef.at(var->getIdentifier())));
+      auto reachingReg = func.makeReg(reachingDef.at(var->getIdentifier()));
+      instIter = insts.replace(
+          instIter, func.makeInst<ir::Assign>(p->getDest(), reachingReg));
       continue;
     }
     if (auto p = ir::dyc<ir::Assign>(inst)) {
@@ -146,8 +148,10 @@ void SSAConstruction::renameVariablesImpl(std::size_t curNode) {
   // Update the option lists of the phi-functions in the successors
   for (const auto &sucLabel : bb.getSuccessors()) {
     auto &sucBB = func.getMutableBasicBlock(sucLabel);
-    for (auto &inst : sucBB.getMutableInsts()) {
-      auto phi = ir::dyc<ir::Phi>(inst);
+    auto &sucInsts = sucBB.getMutableInsts();
+    for (auto instIter = sucInsts.begin(); instIter != sucInsts.end();
+         ++instIter) {
+      auto phi = ir::dyc<ir::Phi>(*instIter);
       if (!phi)
         break;
 
@@ -161,14 +165,15 @@ void SSAConstruction::renameVariablesImpl(std::size_t curNode) {
       auto varName = iter->second;
       updateReachingDef(varName, bb.getLabelID());
       auto reachingDefOfV = reachingDef.at(varName);
-      options.emplace_back(std::make_shared<ir::Reg>(reachingDefOfV),
+      options.emplace_back(func.makeReg(reachingDefOfV),
                            std::make_shared<ir::Label>(bb.getLabelID()));
-      inst = std::make_shared<ir::Phi>(phi->getDest(), std::move(options));
-      varDefined[inst->getID()] = varName;
+      instIter = sucInsts.replace(
+          instIter, func.makeInst<ir::Phi>(phi->getDest(), std::move(options)));
+      varDefined[(*instIter)->getID()] = varName;
     }
   }
 
-  for (const auto &child : dominatorTree.getChildren(curNode))
+  for (const auto &child : dominatorTree->getChildren(curNode))
     renameVariablesImpl(child);
 }
 
@@ -178,7 +183,7 @@ void SSAConstruction::updateReachingDef(const std::string &varName,
     return;
 
   auto r = reachingDef.at(varName);
-  while (!dominatorTree.isDominating(bbDefined.at(r), label))
+  while (!dominatorTree->isDominating(bbDefined.at(r), label))
     r = reachingDef.at(r);
   reachingDef.at(varName) = r;
 }
@@ -198,21 +203,22 @@ bool SimplifyPhiFunctions::operator()() {
     while (ir::dyc<ir::Phi>(*insertionPoint))
       ++insertionPoint;
 
-    for (auto &inst : bb.getMutableInsts()) {
-      auto phi = ir::dyc<ir::Phi>(inst);
-      if (!phi)
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insertionPoint;) {
+      auto phi = ir::dyc<ir::Phi>(*iter);
+      if (!phi) // the Assign's inserted
         break;
-
-      if (phi->getOptions().size() == 1) {
-        ++cnt;
-        auto assign = std::make_shared<ir::Assign>(phi->getDest(),
-                                                   phi->getOptions()[0].first);
-        inst = std::make_shared<ir::Deleted>();
-        bb.getMutableInsts().emplace(insertionPoint, std::move(assign));
+      if (phi->getOptions().size() != 1) {
+        ++iter;
+        continue;
       }
+      ++cnt;
+      auto assign = func.makeInst<ir::Assign>(phi->getDest(),
+                                              phi->getOptions()[0].first);
+      iter = insts.erase(iter);
+      insts.insert(insertionPoint, assign);
     }
   }
-  removeDeletedInsts(func);
   return cnt != 0;
 }
 } // namespace mocker
@@ -234,7 +240,7 @@ void SSADestruction::insertAllocas() {
   std::vector<std::string> varNames;
 
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto phi = ir::dyc<ir::Phi>(inst);
       if (!phi)
         break;
@@ -245,7 +251,7 @@ void SSADestruction::insertAllocas() {
   for (auto &varName : varNames) {
     auto addr = func.makeTempLocalReg();
     addresses[varName] = addr;
-    func.getFirstBB()->appendInstFront(std::make_shared<ir::Alloca>(addr));
+    func.getFirstBB()->appendInstFront(func.makeInst<ir::Alloca>(addr));
   }
 }
 
@@ -269,18 +275,24 @@ void SSADestruction::splitCriticalEdges() {
 
       // split this critical edge
       auto &newBB = *func.pushBackBB();
-      newBB.appendInst(std::make_shared<ir::Jump>(
+      newBB.appendInst(func.makeInst<ir::Jump>(
           std::make_shared<ir::Label>(bb.getLabelID())));
       // rewrite the phi-functions in [bb]
-      for (auto &inst : bb.getMutableInsts()) {
-        auto phi = ir::dyc<ir::Phi>(inst);
+      auto &insts = bb.getMutableInsts();
+      for (auto instIter = insts.begin(); instIter != insts.end(); ++instIter) {
+        auto phi = ir::dyc<ir::Phi>(*instIter);
         if (!phi)
           break;
-        inst = replacePhiOption(phi, bb.getLabelID(), newBB.getLabelID());
+        instIter = insts.replace(
+            instIter, replacePhiOption(func, phi, bb.getLabelID(),
+                                       newBB.getLabelID()));
       }
 
-      pred.getMutableInsts().back() = replaceTerminatorLabel(
-          pred.getInsts().back(), bb.getLabelID(), newBB.getLabelID());
+      auto &predInsts = pred.getMutableInsts();
+      predInsts.replace(--predInsts.end(),
+                        replaceTerminatorLabel(func, predInsts.back(),
+                                               bb.getLabelID(),
+                                               newBB.getLabelID()));
     }
   }
 }
@@ -289,8 +301,9 @@ void SSADestruction::replacePhisWithParallelCopies() {
   auto preds = buildBlockPredecessors(func);
 
   for (auto &bb : func.getMutableBBs()) {
-    for (auto &inst : bb.getMutableInsts()) {
-      auto phi = ir::dyc<ir::Phi>(inst);
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      auto phi = ir::dyc<ir::Phi>(*iter);
       if (!phi)
         break;
 
@@ -298,8 +311,8 @@ void SSADestruction::replacePhisWithParallelCopies() {
       for (auto &option : phi->getOptions())
         parallelCopies[option.second->getID()].emplace_back(
             ir::dycLocalReg(dest), option.first);
-      inst =
-          std::make_shared<ir::Load>(dest, addresses.at(dest->getIdentifier()));
+      auto addr = addresses.at(dest->getIdentifier());
+      iter = insts.replace(iter, func.makeInst<ir::Load>(dest, addr));
     }
   }
 }
@@ -318,14 +331,14 @@ void SSADestruction::sequentializeParallelCopies() {
       auto oldVal = regHoldingOldValue[pcopy.dest->getIdentifier()] =
           func.makeTempLocalReg();
       auto addr = addresses.at(pcopy.dest->getIdentifier());
-      bb.appendInstBeforeTerminator(std::make_shared<ir::Load>(oldVal, addr));
+      bb.appendInstBeforeTerminator(func.makeInst<ir::Load>(oldVal, addr));
       std::shared_ptr<ir::Addr> newVal = pcopy.val;
       if (auto p = ir::dycLocalReg(pcopy.val)) {
         auto iter = regHoldingOldValue.find(p->getIdentifier());
         if (iter != regHoldingOldValue.end())
           newVal = iter->second;
       }
-      bb.appendInstBeforeTerminator(std::make_shared<ir::Store>(addr, newVal));
+      bb.appendInstBeforeTerminator(func.makeInst<ir::Store>(addr, newVal));
     }
   }
 }
@@ -8,7 +8,7 @@
 #include <utility>
 #include <vector>
 
-#include "analysis/dominance.h"
+#include "analysis/analysis_manager.h"
 #include "opt_pass.h"
 
 namespace mocker {
@@ -19,6 +19,8 @@ class SSAConstruction : public FuncPass {
 public:
   explicit SSAConstruction(ir::FunctionModule &func);
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 
 private:
@@ -29,8 +31,6 @@ private:
     std::size_t blockLabel;
     std::shared_ptr<ir::Addr> val;
   };
-  using LabelSet = std::unordered_set<std::size_t>;
-  template <class V> using LabelMap = std::unordered_map<std::size_t, V>;
   template <class V> using IRMap = std::unordered_map<ir::InstID, V>;
 
 private:
@@ -52,7 +52,7 @@ private:
 
 private:
   std::unordered_set<std::string> varNames;
-  DominatorTree dominatorTree;
+  std::shared_ptr<const DominatorTree> dominatorTree;
   IRMap<std::string> varDefined;
   std::unordered_map<std::string, std::string> reachingDef;
   std::unordered_map<std::string, std::size_t> bbDefined;
@@ -67,6 +67,8 @@ class SimplifyPhiFunctions : public FuncPass {
 public:
   explicit SimplifyPhiFunctions(ir::FunctionModule &func);
 
+  static constexpr unsigned Preserved = CFGAnalyses;
+
   bool operator()() override;
 };
 
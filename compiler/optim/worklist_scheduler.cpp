@@ -0,0 +1,99 @@
+#include "worklist_scheduler.h"
+
+#include <memory>
+
+namespace mocker {
+
+constexpr std::size_t WorklistScheduler::DefaultMaxRounds;
+
+WorklistScheduler::Stats &
+WorklistScheduler::Stats::operator+=(const Stats &rhs) {
+  rounds += rhs.rounds;
+  runs += rhs.runs;
+  productiveRuns += rhs.productiveRuns;
+  skippedRuns += rhs.skippedRuns;
+  exhausted += rhs.exhausted;
+  return *this;
+}
+
+bool WorklistScheduler::run(ir::Module &module) {
+  // The functions are neither added nor removed by a function pass.
+  std::vector<ir::FunctionModule *> funcs;
+  for (auto &func : module.getFuncs()) {
+    if (!func.second.isExternalFunc())
+      funcs.emplace_back(&func.second);
+  }
+
+  // pending[s][i]: whether steps[s] has been enabled on funcs[i] since it
+  // last visited it
+  std::vector<std::vector<char>> pending(steps.size(),
+                                         std::vector<char>(funcs.size(), 1));
+  auto enable = [this, &pending](std::size_t i, bool cfgModified) {
+    for (std::size_t s = 0; s < steps.size(); ++s) {
+      if (cfgModified || !(steps[s].flags & CFGOnly))
+        pending[s][i] = 1;
+    }
+  };
+  // The FuncAttr given to the passes last time
+  std::shared_ptr<const FuncAttr> funcAttr;
+
+  auto res = false;
+  auto changed = true;
+  std::size_t round = 0;
+  for (; changed && round < maxRounds; ++round) {
+    ++stats.rounds;
+    changed = false;
+    for (std::size_t s = 0; s < steps.size(); ++s) {
+      auto &step = steps[s];
+      if (round >= step.rounds)
+        continue;
+
+      if (step.takesFuncAttr) {
+        auto cur = getAnalysisManager().getFuncAttr(module);
+        if (funcAttr && cur != funcAttr && *cur != *funcAttr) {
+          for (std::size_t t = 0; t < steps.size(); ++t) {
+            if (steps[t].takesFuncAttr)
+              pending[t].assign(funcs.size(), 1);
+          }
+        }
+        funcAttr = cur;
+      }
+
+      std::vector<ir::FunctionModule *> todo;
+      std::vector<std::size_t> indices;
+      for (std::size_t i = 0; i < funcs.size(); ++i) {
+        if (!pending[s][i]) {
+          ++stats.skippedRuns;
+          continue;
+        }
+        pending[s][i] = 0;
+        todo.emplace_back(funcs[i]);
+        indices.emplace_back(i);
+      }
+      if (todo.empty())
+        continue;
+
+      auto outcomes = step.runner(module, todo);
+      for (std::size_t k = 0; k < todo.size(); ++k) {
+        auto &outcome = outcomes[k];
+        ++(outcome.skipped ? stats.skippedRuns : stats.runs);
+        if (outcome.changed && !(step.flags & Uncounted))
+          changed = true;
+        if (outcome.modified) {
+          ++stats.productiveRuns;
+          enable(indices[k], !step.preservesCFG);
+        } else if (outcome.changed) {
+          pending[s][indices[k]] = 1;
+        }
+      }
+    }
+    res |= changed;
+  }
+  if (changed)
+    ++stats.exhausted;
+
+  verifyModifiedFuncs(module);
+  return res;
+}
+
+} // namespace mocker
@@ -0,0 +1,111 @@
+#ifndef MOCKER_WORKLIST_SCHEDULER_H
+#define MOCKER_WORKLIST_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "analysis/analysis_manager.h"
+#include "analysis/func_attr.h"
+#include "ir/module.h"
+#include "optimizer.h"
+
+namespace mocker {
+
+// Runs a group of function passes and basic block passes in rounds until none
+// of them reports a change, as
+//   while (changed) { changed = false; changed |= runOptPasses<A>(module); ...}
+// would, but a pass only visits a function if the function has been modified
+// since the pass last visited it in a way that may enable the pass. Namely, a
+// pass looking at nothing but the CFG is not enabled by the modifications of a
+// pass preserving the CFG analyses, and a pass taking a FuncAttr is also
+// enabled by a change of the FuncAttr. The functions are verified once at the
+// end rather than after each pass.
+class WorklistScheduler {
+public:
+  static constexpr std::size_t DefaultMaxRounds = 100;
+
+  enum Flags : unsigned {
+    // The changes of the pass alone do not call for another round.
+    Uncounted = 1u << 0,
+    // The pass depends only on the CFG of the function.
+    CFGOnly = 1u << 1,
+  };
+
+  struct Stats {
+    std::size_t rounds = 0;
+    std::size_t runs = 0;           // of a pass on a function
+    std::size_t productiveRuns = 0; // which modified the function
+    std::size_t skippedRuns = 0;    // which would have changed nothing
+    std::size_t exhausted = 0;      // the times the budget has run out
+
+    Stats &operator+=(const Stats &rhs);
+  };
+
+  explicit WorklistScheduler(std::size_t maxRounds = DefaultMaxRounds)
+      : maxRounds(maxRounds) {}
+
+  // Append [Pass] to each round, or only to the first [rounds] ones. A
+  // function pass constructed with a FuncAttr gets the one of the module.
+  template <class Pass>
+  WorklistScheduler &add(unsigned flags = 0,
+                         std::size_t rounds = (std::size_t)-1);
+
+  // Return whether any pass has reported a change.
+  bool run(ir::Module &module);
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  using Runner = std::function<std::vector<PassOutcome>(
+      ir::Module &, const std::vector<ir::FunctionModule *> &)>;
+
+  struct Step {
+    Runner runner;
+    unsigned flags;
+    std::size_t rounds;
+    bool preservesCFG;
+    bool takesFuncAttr;
+  };
+
+  template <class Pass>
+  static std::vector<PassOutcome>
+  runStep(ir::Module &module, const std::vector<ir::FunctionModule *> &funcs,
+          std::true_type /* takes a FuncAttr */) {
+    return runOptPassesOn<Pass>(module, funcs,
+                                *getAnalysisManager().getFuncAttr(module));
+  }
+
+  template <class Pass>
+  static std::vector<PassOutcome>
+  runStep(ir::Module &module, const std::vector<ir::FunctionModule *> &funcs,
+          std::false_type) {
+    return runOptPassesOn<Pass>(module, funcs);
+  }
+
+  std::size_t maxRounds;
+  std::vector<Step> steps;
+  Stats stats;
+};
+
+template <class Pass>
+WorklistScheduler &WorklistScheduler::add(unsigned flags, std::size_t rounds) {
+  using TakesFuncAttr =
+      std::is_constructible<Pass, ir::FunctionModule &, const FuncAttr &>;
+  Step step;
+  step.runner = [](ir::Module &module,
+                   const std::vector<ir::FunctionModule *> &funcs) {
+    return runStep<Pass>(module, funcs, TakesFuncAttr());
+  };
+  step.flags = flags;
+  step.rounds = rounds;
+  step.preservesCFG = (Pass::Preserved & CFGAnalyses) == CFGAnalyses;
+  step.takesFuncAttr = TakesFuncAttr::value;
+  steps.emplace_back(std::move(step));
+  return *this;
+}
+
+} // namespace mocker
+
+#endif // MOCKER_WORKLIST_SCHEDULER_H
@@ -0,0 +1,294 @@
+#include "bytecode.h"
+
+#include <cassert>
+#include <unordered_set>
+
+#include "ir/helper.h"
+#include "ir/profile.h"
+
+namespace mocker {
+namespace ir {
+namespace bytecode {
+
+Lowering::Lowering(std::size_t numArgs, std::size_t numRegs,
+                   std::function<std::int64_t(const std::string &)> global)
+    : global(std::move(global)) {
+  assert(numArgs <= numRegs);
+  res.numArgs = numArgs;
+  res.numRegs = numRegs;
+}
+
+void Lowering::beginBlock(std::size_t label) {
+  endBlock();
+  res.labels.emplace_back(label);
+  res.blockInsts.emplace_back();
+  res.blockInsts.back().bbs = 1;
+  curBlock = (std::uint32_t)blocks.size();
+  auto offset = (std::uint32_t)res.insts.size();
+  auto success = blocks.emplace(label, std::make_pair(curBlock, offset)).second;
+  assert(success);
+  (void)success;
+}
+
+void Lowering::append(const IRInst &inst) {
+  assert(curBlock != NoSlot);
+  auto ptr = &inst;
+  if (dyc<Comment>(ptr) || dyc<AttachedComment>(ptr) || dyc<Deleted>(ptr))
+    return;
+  ++res.blockInsts.back().insts[inst.getInstType()];
+
+  if (auto p = dyc<Assign>(ptr)) {
+    emit(Opcode::Assign, dest(p->getDest()), slot(p->getOperand()));
+    return;
+  }
+  if (auto p = dyc<ArithUnaryInst>(ptr)) {
+    auto op = p->getOp() == ArithUnaryInst::Neg ? Opcode::Neg : Opcode::BitNot;
+    emit(op, dest(p->getDest()), slot(p->getOperand()));
+    return;
+  }
+  if (auto p = dyc<ArithBinaryInst>(ptr)) {
+    static const Opcode Ops[] = {
+        Opcode::BitOr, Opcode::BitAnd, Opcode::Xor, Opcode::Shl,
+        Opcode::Shr,   Opcode::Add,    Opcode::Sub, Opcode::Mul,
+        Opcode::Div,   Opcode::Mod};
+    assert((std::size_t)p->getOp() < sizeof(Ops) / sizeof(Ops[0]));
+    emit(Ops[p->getOp()], dest(p->getDest()), slot(p->getLhs()),
+         slot(p->getRhs()));
+    return;
+  }
+  if (auto p = dyc<RelationInst>(ptr)) {
+    Opcode op;
+    switch (p->getOp()) {
+    case RelationInst::Eq:
+      op = Opcode::Eq;
+      break;
+    case RelationInst::Ne:
+      op = Opcode::Ne;
+      break;
+    case RelationInst::Lt:
+      op = Opcode::Lt;
+      break;
+    case RelationInst::Le:
+      op = Opcode::Le;
+      break;
+    case RelationInst::Gt:
+      op = Opcode::Gt;
+      break;
+    case RelationInst::Ge:
+      op = Opcode::Ge;
+      break;
+    default:
+      assert(false);
+    }
+    emit(op, dest(p->getDest()), slot(p->getLhs()), slot(p->getRhs()));
+    return;
+  }
+  if (auto p = dyc<Load>(ptr)) {
+    auto op = p->getWidth() == 1 ? Opcode::LoadByte : Opcode::Load;
+    emit(op, dest(p->getDest()), slot(p->getAddr()));
+    return;
+  }
+  if (auto p = dyc<Store>(ptr)) {
+    auto op = p->getWidth() == 1 ? Opcode::StoreByte : Opcode::Store;
+    emit(op, NoSlot, slot(p->getAddr()), slot(p->getVal()));
+    return;
+  }
+  if (auto p = dyc<Alloca>(ptr)) {
+    emit(Opcode::Alloca, dest(p->getDest()));
+    return;
+  }
+  if (auto p = dyc<Malloc>(ptr)) {
+    emit(Opcode::Malloc, dest(p->getDest()), slot(p->getSize()));
+    return;
+  }
+  // The labels are replaced by the offsets and the indices in finish().
+  if (auto p = dyc<Branch>(ptr)) {
+    auto then = p->getThen()->getID(), otherwise = p->getElse()->getID();
+    curSuccs = {then, otherwise};
+    auto edge = (std::uint32_t)res.edges.size();
+    res.edges.emplace_back(curBlock, (std::uint32_t)then);
+    res.edges.emplace_back(curBlock, (std::uint32_t)otherwise);
+    emit(Opcode::Br, edge, slot(p->getCondition()), (std::uint32_t)then,
+         (std::uint32_t)otherwise);
+    return;
+  }
+  if (auto p = dyc<Jump>(ptr)) {
+    auto label = p->getLabel()->getID();
+    curSuccs = {label};
+    auto edge = (std::uint32_t)res.edges.size();
+    res.edges.emplace_back(curBlock, (std::uint32_t)label);
+    emit(Opcode::Jump, edge, (std::uint32_t)label);
+    return;
+  }
+  if (auto p = dyc<Ret>(ptr)) {
+    if (p->getVal())
+      emit(Opcode::Ret, NoSlot, slot(p->getVal()));
+    else
+      emit(Opcode::RetVoid, NoSlot);
+    return;
+  }
+  if (auto p = dyc<Call>(ptr)) {
+    auto first = (std::uint32_t)res.callArgs.size();
+    for (auto &arg : p->getArgs())
+      res.callArgs.emplace_back(slot(arg));
+    auto callee = (std::uint32_t)res.callees.size();
+    res.callees.emplace_back(p->getFuncName());
+    res.targets.emplace_back(NoSlot);
+    auto resSlot = p->getDest() ? dest(p->getDest()) : NoSlot;
+    auto numArgs = (std::uint32_t)p->getArgs().size();
+    emit(Opcode::Call, resSlot, callee, first, numArgs);
+    return;
+  }
+  if (auto p = dyc<ir::Phi>(ptr)) {
+    // Lowered into the copies on the incoming edges in finish()
+    Phi phi;
+    phi.block = curBlock;
+    phi.dest = dest(p->getDest());
+    for (auto &option : p->getOptions())
+      phi.options.emplace_back(option.second->getID(), slot(option.first));
+    phis.emplace_back(std::move(phi));
+    return;
+  }
+  assert(false);
+}
+
+Function Lowering::finish() {
+  endBlock();
+  for (auto &inst : res.insts) {
+    if (inst.op == Opcode::Br) {
+      inst.b = blocks.at(inst.b).second;
+      inst.c = blocks.at(inst.c).second;
+    } else if (inst.op == Opcode::Jump) {
+      inst.a = blocks.at(inst.a).second;
+    }
+  }
+  for (auto &edge : res.edges)
+    edge.second = blocks.at(edge.second).first;
+
+  std::vector<std::vector<std::size_t>> blockPhis(blocks.size());
+  for (std::size_t i = 0; i < phis.size(); ++i)
+    blockPhis[phis[i].block].emplace_back(i);
+  for (auto &edge : res.edges) {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> parallel;
+    auto pred = res.labels[edge.first];
+    for (auto idx : blockPhis[edge.second]) {
+      auto &phi = phis[idx];
+      for (auto &option : phi.options) {
+        if (option.first == pred && option.second != phi.dest) {
+          parallel.emplace_back(phi.dest, option.second);
+          break;
+        }
+      }
+    }
+    auto begin = (std::uint32_t)res.copies.size();
+    sequentialize(parallel);
+    res.edgeCopies.emplace_back(begin, (std::uint32_t)res.copies.size());
+  }
+  return std::move(res);
+}
+
+// Boissinot et al., Revisiting Out-of-SSA Translation for Correctness, Code
+// Quality, and Efficiency, Algorithm 1
+void Lowering::sequentialize(
+    const std::vector<std::pair<std::uint32_t, std::uint32_t>> &parallel) {
+  // loc[a]: where the original value of a is now
+  // pred[b]: the source of b
+  std::unordered_map<std::uint32_t, std::uint32_t> loc, pred;
+  std::unordered_set<std::uint32_t> written;
+  std::vector<std::uint32_t> ready, todo;
+  for (auto &copy : parallel) {
+    loc[copy.second] = copy.second;
+    pred[copy.first] = copy.second;
+    todo.emplace_back(copy.first);
+  }
+  // The dests which are not needed as sources can be written at once.
+  for (auto &copy : parallel) {
+    if (loc.find(copy.first) == loc.end())
+      ready.emplace_back(copy.first);
+  }
+
+  while (!todo.empty()) {
+    while (!ready.empty()) {
+      auto b = ready.back();
+      ready.pop_back();
+      auto a = pred.at(b), c = loc.at(a);
+      res.copies.emplace_back(b, c);
+      written.emplace(b);
+      loc[a] = b;
+      if (a == c && pred.find(a) != pred.end())
+        ready.emplace_back(a);
+    }
+    auto b = todo.back();
+    todo.pop_back();
+    if (written.find(b) != written.end())
+      continue;
+    // [b] is in a cycle, and none of the copies from [b] has been made. Break
+    // the cycle by saving the value of [b].
+    if (scratch == NoSlot) {
+      // An extra constant, which is reset on each call
+      scratch = (std::uint32_t)(res.numRegs + res.consts.size());
+      res.consts.emplace_back(0);
+    }
+    res.copies.emplace_back(scratch, b);
+    loc[b] = scratch;
+    ready.emplace_back(b);
+  }
+}
+
+void Lowering::endBlock() {
+  if (curBlock == NoSlot)
+    return;
+  res.checksum += hashBlock(res.labels.back(), curSuccs);
+  curSuccs.clear();
+}
+
+std::uint32_t Lowering::slot(const std::shared_ptr<Addr> &addr) {
+  if (auto p = dyc<IntLiteral>(addr))
+    return constSlot(p->getVal());
+  auto reg = dyc<Reg>(addr);
+  assert(reg);
+  auto &ident = reg->getIdentifier();
+  // A phi-function reads .phi_nan if no value is available.
+  if (ident == ".phi_nan")
+    return constSlot(-123);
+  if (ident[0] == '@')
+    return constSlot(global(ident));
+  assert(reg->getID() < res.numRegs);
+  return (std::uint32_t)reg->getID();
+}
+
+std::uint32_t Lowering::constSlot(std::int64_t val) {
+  auto iter = constSlots.find(val);
+  if (iter != constSlots.end())
+    return iter->second;
+  auto id = (std::uint32_t)(res.numRegs + res.consts.size());
+  res.consts.emplace_back(val);
+  constSlots.emplace(val, id);
+  return id;
+}
+
+std::uint32_t Lowering::dest(const std::shared_ptr<Addr> &addr) {
+  auto reg = dyc<Reg>(addr);
+  assert(reg && reg->getIdentifier()[0] != '@');
+  assert(reg->getID() < res.numRegs);
+  return (std::uint32_t)reg->getID();
+}
+
+void Lowering::emit(Opcode op, std::uint32_t dest, std::uint32_t a,
+                    std::uint32_t b, std::uint32_t c) {
+  res.insts.push_back({op, dest, a, b, c, curBlock});
+}
+
+void instrument(Function &func) {
+  for (auto &inst : func.insts) {
+    if (inst.op == Opcode::Br)
+      inst.op = Opcode::CountedBr;
+    else if (inst.op == Opcode::Jump)
+      inst.op = Opcode::CountedJump;
+  }
+  func.edgeCounts.assign(func.edges.size(), 0);
+}
+
+} // namespace bytecode
+} // namespace ir
+} // namespace mocker
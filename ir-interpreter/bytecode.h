@@ -0,0 +1,166 @@
+// The interpreter does not execute the IR directly. Each function is lowered
+// into a flat array of fixed-size instructions whose operands are decoded in
+// advance:
+//
+// - The frame of a function consists of its registers, at the slots given by
+//   their IDs, followed by its constants, which are copied in on each call.
+//   Every operand, whether a register, a literal or the address of a global
+//   variable, is therefore a slot of the frame.
+// - The targets of the branches are the offsets of the first instructions of
+//   the blocks.
+// - The phi-functions are not executed in the blocks. They become the copies
+//   made on the edges into the blocks, which the branches make right away.
+
+#ifndef MOCKER_BYTECODE_H
+#define MOCKER_BYTECODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir/ir_inst.h"
+#include "ir/stats.h"
+
+namespace mocker {
+namespace ir {
+namespace bytecode {
+
+// clang-format off
+#define MOCKER_BYTECODE_OPCODES(X)                                             \
+  X(Assign) X(Neg) X(BitNot)                                                   \
+  X(BitOr) X(BitAnd) X(Xor) X(Shl) X(Shr)                                      \
+  X(Add) X(Sub) X(Mul) X(Div) X(Mod)                                           \
+  X(Eq) X(Ne) X(Lt) X(Le) X(Gt) X(Ge)                                          \
+  X(Load) X(LoadByte) X(Store) X(StoreByte) X(Alloca) X(Malloc)                \
+  X(Br) X(Jump) X(Ret) X(RetVoid) X(Call) X(CallBuiltin)                      \
+  X(CountedBr) X(CountedJump)
+// clang-format on
+
+enum class Opcode : std::uint32_t {
+#define MOCKER_BYTECODE_ENUM(name) name,
+  MOCKER_BYTECODE_OPCODES(MOCKER_BYTECODE_ENUM)
+#undef MOCKER_BYTECODE_ENUM
+      NumOpcodes
+};
+
+constexpr std::uint32_t NoSlot = (std::uint32_t)-1;
+
+// The meaning of the fields depends on the opcode:
+//
+//   unary, binary    dest = a op b
+//   Load(Byte)       dest = *a
+//   Store(Byte)      *a = b
+//   Alloca           dest = an 8-byte buffer
+//   Malloc           dest = an a-byte buffer
+//   Br               to b through the edge dest if a is nonzero, otherwise to
+//                    c through the edge dest + 1
+//   Jump             to a through the edge dest
+//   CountedBr        Br, counting the edge dest or dest + 1 taken
+//   CountedJump      Jump, counting the edge dest
+//   Ret              return a
+//   Call             dest (or NoSlot) = callees[a](callArgs[b, b + c))
+//   CallBuiltin      Call, of a builtin
+//
+// [block] is the index of the enclosing block.
+struct Inst {
+  Opcode op;
+  std::uint32_t dest;
+  std::uint32_t a, b, c;
+  std::uint32_t block;
+};
+
+struct Function {
+  std::size_t numArgs = 0;
+  std::size_t numRegs = 0;
+  std::vector<Inst> insts;
+  std::vector<std::int64_t> consts;
+  std::vector<std::uint32_t> callArgs;
+  std::vector<std::string> callees;
+  // The indices of the callees in the table of the functions or in that of
+  // the builtins, filled in by the interpreter once all of them are known
+  std::vector<std::uint32_t> targets;
+
+  // The edges named by the dest fields of the Br and the Jump instructions,
+  // as (from, to) by the indices of the blocks
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+  // The copies made on the edge i are copies[edgeCopies[i].first, .second),
+  // in order. The phi-functions are copied in parallel, hence the copies are
+  // sequentialized through a scratch slot if they form a cycle.
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> copies; // (dest, src)
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edgeCopies;
+
+  // For profiling. The blocks are described by their indices.
+  std::uint64_t checksum = 0;
+  std::vector<std::size_t> labels;
+  std::vector<Histogram> blockInsts; // the IR instructions of the blocks
+
+  // The counters, which are only updated by the counted instructions and by
+  // the interpreter in the profiling mode
+  std::uint64_t calls = 0;
+  std::vector<std::uint64_t> edgeCounts;
+
+  std::size_t getFrameSize() const { return numRegs + consts.size(); }
+};
+
+// Make the branches of [func] count the edges taken.
+void instrument(Function &func);
+
+// Lower a function block by block. The first block is the entry.
+class Lowering {
+public:
+  // The registers are numbered in [0, numRegs). [global] returns the value of
+  // the global register with the given identifier.
+  Lowering(std::size_t numArgs, std::size_t numRegs,
+           std::function<std::int64_t(const std::string &)> global);
+
+  void beginBlock(std::size_t label);
+
+  void append(const IRInst &inst);
+
+  Function finish();
+
+private:
+  std::uint32_t slot(const std::shared_ptr<Addr> &addr);
+
+  std::uint32_t constSlot(std::int64_t val);
+
+  std::uint32_t dest(const std::shared_ptr<Addr> &addr);
+
+  void emit(Opcode op, std::uint32_t dest, std::uint32_t a = 0,
+            std::uint32_t b = 0, std::uint32_t c = 0);
+
+  void endBlock();
+
+  // Append [parallel], a set of (dest, src) copies with distinct dests, to the
+  // copies of the function in an order which preserves its semantics.
+  void sequentialize(
+      const std::vector<std::pair<std::uint32_t, std::uint32_t>> &parallel);
+
+  struct Phi {
+    std::uint32_t block;
+    std::uint32_t dest;
+    // (the label of the predecessor, the slot of the value)
+    std::vector<std::pair<std::size_t, std::uint32_t>> options;
+  };
+
+  Function res;
+  std::function<std::int64_t(const std::string &)> global;
+  std::unordered_map<std::int64_t, std::uint32_t> constSlots;
+  // label -> (index, offset)
+  std::unordered_map<std::size_t, std::pair<std::uint32_t, std::uint32_t>>
+      blocks;
+  std::uint32_t curBlock = NoSlot;
+  std::vector<std::size_t> curSuccs;
+  std::vector<Phi> phis;
+  std::uint32_t scratch = NoSlot;
+};
+
+} // namespace bytecode
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_BYTECODE_H
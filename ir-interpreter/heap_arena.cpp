@@ -0,0 +1,36 @@
+#include "heap_arena.h"
+
+#include <algorithm>
+
+namespace mocker {
+namespace ir {
+
+void HeapArena::release() {
+  chunks.clear();
+  cur = chunkEnd = nullptr;
+  nextChunkSize = MinChunkSize;
+  bytesReserved = 0;
+}
+
+void *HeapArena::allocateSlow(std::size_t size) {
+  bytesAllocated += size;
+  if (size > nextChunkSize / 4)
+    return newChunk(size);
+
+  cur = newChunk(nextChunkSize);
+  chunkEnd = cur + nextChunkSize;
+  nextChunkSize = std::min(nextChunkSize * 2, MaxChunkSize);
+  auto res = cur;
+  cur += size;
+  return res;
+}
+
+char *HeapArena::newChunk(std::size_t size) {
+  chunks.emplace_back(new char[size]());
+  bytesReserved += size;
+  peakBytesReserved = std::max(peakBytesReserved, bytesReserved);
+  return chunks.back().get();
+}
+
+} // namespace ir
+} // namespace mocker
@@ -0,0 +1,65 @@
+// The heap of the interpreted program. Memory is bumped out of chunks which
+// grow geometrically, and is never freed individually but in bulk when the
+// arena is released or destroyed. An allocation too large for the current
+// chunk gets a chunk of its own, so that the rest of the current one is not
+// wasted.
+
+#ifndef MOCKER_HEAP_ARENA_H
+#define MOCKER_HEAP_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mocker {
+namespace ir {
+
+class HeapArena {
+public:
+  HeapArena() = default;
+  HeapArena(const HeapArena &) = delete;
+  HeapArena &operator=(const HeapArena &) = delete;
+
+  // The result is aligned to 8 bytes. The chunks are zeroed when allocated, so
+  // that programs reading memory they never wrote behave deterministically.
+  void *allocate(std::size_t size) {
+    size = (size + Align - 1) & ~(Align - 1);
+    if (size <= std::size_t(chunkEnd - cur)) {
+      auto res = cur;
+      cur += size;
+      bytesAllocated += size;
+      return res;
+    }
+    return allocateSlow(size);
+  }
+
+  // Free everything at once.
+  void release();
+
+  // The number of the bytes handed out since construction
+  std::size_t getBytesAllocated() const { return bytesAllocated; }
+
+  // The most bytes held in chunks at any time
+  std::size_t getPeakBytesReserved() const { return peakBytesReserved; }
+
+private:
+  void *allocateSlow(std::size_t size);
+
+  char *newChunk(std::size_t size);
+
+private:
+  static constexpr std::size_t Align = 8;
+  static constexpr std::size_t MinChunkSize = 64 * 1024;
+  static constexpr std::size_t MaxChunkSize = 64 * 1024 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks;
+  char *cur = nullptr, *chunkEnd = nullptr;
+  std::size_t nextChunkSize = MinChunkSize;
+  std::size_t bytesAllocated = 0;
+  std::size_t bytesReserved = 0, peakBytesReserved = 0;
+};
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_HEAP_ARENA_H
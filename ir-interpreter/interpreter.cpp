@@ -1,5 +1,6 @@
 #include "interpreter.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -17,29 +18,116 @@
 
 namespace mocker {
 namespace ir {
+namespace {
+
+// The entry is entered on each call, and the other blocks through the edges.
+std::vector<std::uint64_t> countBlocks(const bytecode::Function &func) {
+  std::vector<std::uint64_t> res(func.labels.size(), 0);
+  if (!res.empty())
+    res[0] = func.calls;
+  for (std::size_t i = 0; i < func.edgeCounts.size(); ++i)
+    res[func.edges[i].second] += func.edgeCounts[i];
+  return res;
+}
+
+} // namespace
 
 Interpreter::Interpreter(std::string source) {
-  initExternalFuncs();
   parse(deleteComments(std::move(source)));
+  lower();
+}
+
+Interpreter::Interpreter(const SerializedModule &module) {
+  load(module);
+  lower();
 }
 
-Interpreter::~Interpreter() {
-  for (const auto &ptr : malloced)
-    std::free(ptr);
+Interpreter::Interpreter(const Module &module) {
+  for (auto &var : module.getGlobalVars())
+    globalVars.emplace_back(var);
+  lower();
+  for (auto &kv : module.getFuncs()) {
+    if (!kv.second.isExternalFunc())
+      lowerFunc(kv.second);
+  }
+  link();
 }
 
 std::int64_t Interpreter::run() {
-  for (auto &var : globalVars) {
-    auto &ident = var.getLabel();
-    auto &data = var.getData();
-    auto res = fastMalloc(data.size());
+  for (std::size_t i = 0; i < globalVars.size(); ++i) {
+    auto &data = globalVars[i].getData();
+    auto res = heap.allocate(data.size());
     std::memcpy(res, data.c_str(), data.size());
-    globalReg[ident] = (std::int64_t)(data.c_str());
   }
 
   return executeFunc("main", {});
 }
 
+std::int64_t Interpreter::run(const std::string &funcName,
+                              const std::vector<std::int64_t> &args) {
+  return executeFunc(funcName, args);
+}
+
+void Interpreter::overwriteFunc(const FunctionModule &func) {
+  lowerFunc(func);
+  link();
+}
+
+void Interpreter::enableProfiling() {
+  profiling = true;
+  for (auto &func : funcs)
+    bytecode::instrument(func);
+}
+
+Profile Interpreter::getProfile() const {
+  Profile res;
+  for (auto &kv : funcIndices) {
+    auto &func = funcs[kv.second];
+    auto &profile = res.getFunc(kv.first);
+    profile.checksum = func.checksum;
+    profile.calls = func.calls;
+
+    auto blockCounts = countBlocks(func);
+    for (std::size_t i = 0; i < func.edges.size(); ++i) {
+      auto &edge = func.edges[i];
+      auto count = func.edgeCounts.empty() ? 0 : func.edgeCounts[i];
+      if (count != 0)
+        profile.edges[{func.labels[edge.first], func.labels[edge.second]}] +=
+            count;
+    }
+    for (std::size_t i = 0; i < blockCounts.size(); ++i) {
+      profile.blocks[func.labels[i]] = blockCounts[i];
+      profile.insts += blockCounts[i] * func.blockInsts[i].countInsts();
+    }
+
+    std::size_t lastBlock = bytecode::NoSlot, idx = 0;
+    for (auto &inst : func.insts) {
+      if (inst.op != bytecode::Opcode::Call &&
+          inst.op != bytecode::Opcode::CallBuiltin)
+        continue;
+      idx = inst.block == lastBlock ? idx + 1 : 0;
+      lastBlock = inst.block;
+      profile.callSites.push_back({func.labels[inst.block], idx,
+                                   func.callees[inst.a],
+                                   blockCounts[inst.block]});
+    }
+  }
+  return res;
+}
+
+Histogram Interpreter::getDynamicHistogram() const {
+  Histogram res;
+  for (auto &func : funcs) {
+    auto blockCounts = countBlocks(func);
+    for (std::size_t i = 0; i < blockCounts.size(); ++i) {
+      res.bbs += blockCounts[i];
+      for (std::size_t type = 0; type < NumInstTypes; ++type)
+        res.insts[type] += blockCounts[i] * func.blockInsts[i].insts[type];
+    }
+  }
+  return res;
+}
+
 std::string Interpreter::deleteComments(std::string source) const {
   std::string res;
 
@@ -123,12 +211,14 @@ void Interpreter::parse(const std::string &source) {
       continue;
     assert(buffer == "{");
     parseFuncBody(ss, func);
-    funcs.emplace(std::move(funcName), std::move(func));
+    parsedFuncs.emplace(std::move(funcName), std::move(func));
   }
 }
 
 void Interpreter::parseFuncBody(std::istream &in, FuncModule &func) {
-  bool firstBBInitialized = false;
+  parsingRegs = &func.regTable;
+  for (std::size_t i = 0; i < func.args.size(); ++i)
+    func.regTable.get(std::to_string(i));
   std::string line;
   while (true) {
     std::getline(in, line);
@@ -139,18 +229,14 @@ void Interpreter::parseFuncBody(std::istream &in, FuncModule &func) {
       continue;
     if (line[0] == '<') {
       std::size_t label = std::strtoul(&line[0] + 1, nullptr, 10);
-      if (!firstBBInitialized) {
-        func.firstBB = label;
-        firstBBInitialized = true;
-      }
-      func.label2idx.emplace(label, func.insts.size());
+      func.bbs.emplace_back(label, func.insts.size());
       continue;
     }
     func.insts.emplace_back(parseInst(line));
   }
 }
 
-std::shared_ptr<IRInst> Interpreter::parseInst(const std::string &line) const {
+std::shared_ptr<IRInst> Interpreter::parseInst(const std::string &line) {
   std::stringstream lineSS(line);
   std::string buffer;
   lineSS >> buffer;
@@ -165,10 +251,15 @@ std::shared_ptr<IRInst> Interpreter::parseInst(const std::string &line) const {
   }
   if (buffer == "store") {
     lineSS >> buffer;
+    std::size_t width = 8;
+    if (buffer == "byte") {
+      width = 1;
+      lineSS >> buffer;
+    }
     auto dest = parseAddr(buffer);
     lineSS >> buffer;
     auto operand = parseAddr(buffer);
-    return std::make_shared<Store>(dest, operand);
+    return std::make_shared<Store>(dest, operand, width);
   }
   if (buffer == "jump") {
     lineSS >> buffer;
@@ -210,8 +301,13 @@ std::shared_ptr<IRInst> Interpreter::parseInst(const std::string &line) const {
   }
   if (buffer == "load") {
     lineSS >> buffer;
+    std::size_t width = 8;
+    if (buffer == "byte") {
+      width = 1;
+      lineSS >> buffer;
+    }
     auto addr = parseAddr(buffer);
-    return std::make_shared<Load>(dest, addr);
+    return std::make_shared<Load>(dest, addr, width);
   }
   if (buffer == "call") {
     return parseCallRHS(std::move(dest));
@@ -274,12 +370,12 @@ std::shared_ptr<IRInst> Interpreter::parseInst(const std::string &line) const {
   assert(false);
 }
 
-std::shared_ptr<Addr> Interpreter::parseAddr(const std::string &str) const {
+std::shared_ptr<Addr> Interpreter::parseAddr(const std::string &str) {
   assert(!str.empty());
   if (str[0] == '@')
-    return std::make_shared<Reg>(str);
+    return parsingRegs->get(str);
   if (str[0] == '%')
-    return std::make_shared<Reg>(std::string(str.begin() + 1, str.end()));
+    return parsingRegs->get(std::string(str.begin() + 1, str.end()));
   if (str[0] == '<')
     return std::make_shared<Label>(
         (std::size_t)(std::strtoul(&str[0] + 1, nullptr, 10)));
@@ -287,30 +383,198 @@ std::shared_ptr<Addr> Interpreter::parseAddr(const std::string &str) const {
       (Integer)std::strtoll(&str[0], nullptr, 10));
 }
 
-void Interpreter::initExternalFuncs() {
-  using Args = const std::vector<std::int64_t> &;
+void Interpreter::load(const SerializedModule &module) {
+  for (auto &var : module.getVars())
+    globalVars.emplace_back(module.getStdString(var.label),
+                            module.getStdString(var.data));
+
+  for (auto &rec : module.getFuncs()) {
+    if (rec.flags & binary::FuncRecord::External)
+      continue;
+    FuncModule func;
+    for (auto str : module.getArgs(rec))
+      func.args.emplace_back(module.getStdString(str));
+    std::vector<std::shared_ptr<Reg>> regs;
+    for (auto str : module.getRegs(rec)) {
+      regs.emplace_back(func.regTable.get(module.getStdString(str)));
+      assert(regs.back()->getID() == regs.size() - 1);
+    }
+
+    for (auto &block : module.getBlocks(rec)) {
+      func.bbs.emplace_back(block.label, func.insts.size());
+      for (auto &inst : module.getInsts(block)) {
+        if (inst.type == IRInst::Deleted || inst.type == IRInst::Comment ||
+            inst.type == IRInst::AttachedComment)
+          continue;
+        func.insts.emplace_back(decodeInst(module, inst, regs));
+      }
+    }
+    parsedFuncs.emplace(module.getStdString(rec.identifier), std::move(func));
+  }
+}
 
+std::shared_ptr<IRInst>
+Interpreter::decodeInst(const SerializedModule &module,
+                        const binary::InstRecord &inst,
+                        const std::vector<std::shared_ptr<Reg>> &regs) {
+  using binary::OperandRecord;
+
+  auto operands = module.getOperands(inst);
+  auto addr = [&operands, &regs](std::size_t idx) -> std::shared_ptr<Addr> {
+    auto &operand = operands[idx];
+    switch (operand.kind) {
+    case OperandRecord::Register:
+      return regs.at(operand.id);
+    case OperandRecord::IntLiteral:
+      return std::make_shared<IntLiteral>((Integer)operand.val);
+    case OperandRecord::Label:
+      return std::make_shared<Label>((std::size_t)operand.id);
+    default:
+      return nullptr;
+    }
+  };
+  auto reg = [&addr](std::size_t idx) {
+    return std::static_pointer_cast<Reg>(addr(idx));
+  };
+  auto label = [&addr](std::size_t idx) {
+    return std::static_pointer_cast<Label>(addr(idx));
+  };
+
+  switch (inst.type) {
+  case IRInst::Assign:
+    return std::make_shared<Assign>(reg(0), addr(1));
+  case IRInst::ArithUnaryInst:
+    return std::make_shared<ArithUnaryInst>(
+        reg(0), (ArithUnaryInst::OpType)inst.op, addr(1));
+  case IRInst::ArithBinaryInst:
+    return std::make_shared<ArithBinaryInst>(
+        reg(0), (ArithBinaryInst::OpType)inst.op, addr(1), addr(2));
+  case IRInst::RelationInst:
+    return std::make_shared<RelationInst>(
+        reg(0), (RelationInst::OpType)inst.op, addr(1), addr(2));
+  case IRInst::Store:
+    return std::make_shared<Store>(addr(0), addr(1), inst.op);
+  case IRInst::Load:
+    return std::make_shared<Load>(reg(0), addr(1), inst.op);
+  case IRInst::Alloca:
+    return std::make_shared<Alloca>(reg(0));
+  case IRInst::Malloc:
+    return std::make_shared<Malloc>(reg(0), addr(1));
+  case IRInst::Branch:
+    return std::make_shared<Branch>(addr(0), label(1), label(2));
+  case IRInst::Jump:
+    return std::make_shared<Jump>(label(0));
+  case IRInst::Ret:
+    return std::make_shared<Ret>(operands.empty() ? nullptr : addr(0));
+  case IRInst::Call: {
+    std::vector<std::shared_ptr<Addr>> args;
+    for (std::size_t i = 1; i < operands.size(); ++i)
+      args.emplace_back(addr(i));
+    return std::make_shared<Call>(reg(0), module.getStdString(inst.str),
+                                  std::move(args));
+  }
+  case IRInst::Phi: {
+    std::vector<Phi::Option> options;
+    for (std::size_t i = 1; i + 1 < operands.size(); i += 2)
+      options.emplace_back(addr(i), label(i + 1));
+    return std::make_shared<Phi>(reg(0), std::move(options));
+  }
+  default:
+    assert(false);
+  }
+}
+
+void Interpreter::lower() {
+  for (auto &var : globalVars)
+    globalAddrs.emplace(var.getLabel(), (Integer)var.getData().c_str());
+
+  for (auto &kv : parsedFuncs) {
+    auto &func = kv.second;
+    auto lowering = makeLowering(func.args.size(), func.regTable.size());
+    for (std::size_t i = 0; i < func.bbs.size(); ++i) {
+      lowering.beginBlock(func.bbs[i].first);
+      auto end =
+          i + 1 == func.bbs.size() ? func.insts.size() : func.bbs[i + 1].second;
+      for (auto idx = func.bbs[i].second; idx < end; ++idx)
+        lowering.append(*func.insts[idx]);
+    }
+    auto success = funcIndices.emplace(kv.first, funcs.size()).second;
+    assert(success);
+    (void)success;
+    funcs.emplace_back(lowering.finish());
+  }
+  parsedFuncs.clear();
+  link();
+}
+
+bytecode::Lowering Interpreter::makeLowering(std::size_t numArgs,
+                                             std::size_t numRegs) const {
+  return bytecode::Lowering(
+      numArgs, numRegs,
+      [this](const std::string &ident) { return globalAddrs.at(ident); });
+}
+
+void Interpreter::lowerFunc(const FunctionModule &func) {
+  assert(!func.isExternalFunc());
+  auto lowering =
+      makeLowering(func.getArgs().size(), func.getRegTable().size());
+  for (auto &bb : func.getBBs()) {
+    lowering.beginBlock(bb.getLabelID());
+    for (auto inst : bb.getInsts())
+      lowering.append(*inst);
+  }
+  auto iter = funcIndices.emplace(func.getIdentifier(), funcs.size()).first;
+  if (iter->second == funcs.size())
+    funcs.emplace_back();
+  auto &res = funcs[iter->second] = lowering.finish();
+  if (profiling)
+    bytecode::instrument(res);
+}
+
+void Interpreter::link() {
+  for (auto &func : funcs) {
+    for (auto &inst : func.insts) {
+      if (inst.op != bytecode::Opcode::Call &&
+          inst.op != bytecode::Opcode::CallBuiltin)
+        continue;
+      auto &callee = func.callees[inst.a];
+      auto builtin = findBuiltin(callee);
+      if (builtin != -1) {
+        assert(getBuiltins()[builtin].arity == inst.c);
+        inst.op = bytecode::Opcode::CallBuiltin;
+        func.targets[inst.a] = (std::uint32_t)builtin;
+        continue;
+      }
+      auto idx = funcIndices.at(callee);
+      assert(funcs[idx].numArgs == inst.c);
+      inst.op = bytecode::Opcode::Call;
+      func.targets[inst.a] = (std::uint32_t)idx;
+    }
+  }
+}
+
+// The builtins call each other directly rather than through the table.
+struct Interpreter::Builtins {
   // #_array_#_ctor_ ( this arraySize elementSize )
-  externalFuncs.emplace("#_array_#_ctor_",
-                        [this](Args args) -> std::int64_t { assert(false); });
+  static Integer arrayCtor(Interpreter &, const Integer *) { assert(false); }
+
   // #_array_#size ( this )
-  externalFuncs.emplace("#_array_#size", [](Args args) {
-    auto res = *((std::int64_t *)(args[0]) - 1);
-    return res;
-  });
+  static Integer arraySize(Interpreter &, const Integer *args) {
+    return *((std::int64_t *)(args[0]) - 1);
+  }
 
   // #string#length ( this )
-  externalFuncs.emplace("#string#length", [](Args args) {
-    auto res = *((std::int64_t *)(args[0]) - 1);
-    return res;
-  });
+  static Integer stringLength(Interpreter &, const Integer *args) {
+    return *((std::int64_t *)(args[0]) - 1);
+  }
+
   // #string#add ( lhs rhs )
-  externalFuncs.emplace("#string#add", [this](Args args) {
-    auto lhsLen = externalFuncs["#string#length"]({args[0]});
-    auto rhsLen = externalFuncs["#string#length"]({args[1]});
+  static Integer stringAdd(Interpreter &interp, const Integer *args) {
+    auto lhsLen = stringLength(interp, args);
+    auto rhsLen = stringLength(interp, args + 1);
     std::int64_t length = lhsLen + rhsLen;
 
-    char *resInstPtr = (char *)fastMalloc(length + 8);
+    char *resInstPtr = (char *)interp.heap.allocate(length + 8);
     *(std::int64_t *)resInstPtr = length;
     resInstPtr += 8;
 
@@ -318,337 +582,321 @@ void Interpreter::initExternalFuncs() {
     std::memcpy((char *)resInstPtr + lhsLen, (void *)args[1],
                 (std::size_t)rhsLen);
     return (std::int64_t)resInstPtr;
-  });
+  }
+
   // #string#substring ( this left right )
-  externalFuncs.emplace("#string#substring", [this](Args args) {
+  static Integer stringSubstring(Interpreter &interp, const Integer *args) {
     auto len = args[2] - args[1];
-    char *resInstPtr = (char *)fastMalloc(len + 8);
+    char *resInstPtr = (char *)interp.heap.allocate(len + 8);
     *(std::int64_t *)(resInstPtr) = len;
     resInstPtr += 8;
 
     auto srcContentPtr = (char *)args[0] + args[1];
     std::memcpy(resInstPtr, srcContentPtr, (std::size_t)len);
     return (std::int64_t)resInstPtr;
-  });
+  }
+
   // #string#ord ( this pos )
-  externalFuncs.emplace("#string#ord", [](Args args) {
+  static Integer stringOrd(Interpreter &, const Integer *args) {
     return (std::int64_t) * ((char *)args[0] + args[1]);
-  });
+  }
+
   // #string#parseInt ( this )
-  externalFuncs.emplace("#string#parseInt", [](Args args) {
+  static Integer stringParseInt(Interpreter &, const Integer *args) {
     auto len = *((std::int64_t *)args[0] - 1);
     std::string str{(char *)args[0], (char *)args[0] + len};
     return std::stoll(str);
-  });
+  }
+
   // #string#_ctor_ ( this )
-  externalFuncs.emplace("#string#_ctor_",
-                        [](Args args) -> std::int64_t { assert(false); });
+  static Integer stringCtor(Interpreter &, const Integer *) { assert(false); }
 
   // getInt (  )
-  externalFuncs.emplace("getInt", [](Args args) {
+  static Integer getInt(Interpreter &interp, const Integer *) {
     std::int64_t res;
-    std::cin >> res;
+    *interp.in >> res;
     return res;
-  });
+  }
+
   // print ( str )
-  externalFuncs.emplace("print", [this](Args args) {
-    auto len = externalFuncs["#string#length"]({args[0]});
+  static Integer print(Interpreter &interp, const Integer *args) {
+    auto len = stringLength(interp, args);
     auto str = std::string{(char *)args[0], (char *)args[0] + len};
-    std::cout << str;
+    *interp.out << str;
     return 0;
-  });
+  }
+
   // println ( str )
-  externalFuncs.emplace("println", [this](Args args) {
-    externalFuncs["print"]({args[0]});
-    std::cout << std::endl;
+  static Integer println(Interpreter &interp, const Integer *args) {
+    print(interp, args);
+    *interp.out << std::endl;
     return 0;
-  });
+  }
+
   // _printInt ( x )
-  externalFuncs.emplace("_printInt", [this](Args args) {
-    std::cout << args[0];
+  static Integer printInt(Interpreter &interp, const Integer *args) {
+    *interp.out << args[0];
     return 0;
-  });
-  externalFuncs.emplace("_printlnInt", [this](Args args) {
-    std::cout << args[0] << std::endl;
+  }
+
+  // _printlnInt ( x )
+  static Integer printlnInt(Interpreter &interp, const Integer *args) {
+    *interp.out << args[0] << std::endl;
     return 0;
-  });
+  }
+
   // getString (  )
-  externalFuncs.emplace("getString", [this](Args args) {
+  static Integer getString(Interpreter &interp, const Integer *) {
     std::string str;
-    std::cin >> str;
+    *interp.in >> str;
 
-    auto resInstPtr = (char *)fastMalloc(8 + str.length());
+    auto resInstPtr = (char *)interp.heap.allocate(8 + str.length());
     *(std::int64_t *)resInstPtr = (std::int64_t)str.length();
     resInstPtr += 8;
     std::memcpy(resInstPtr, str.c_str(), str.length());
     return (std::int64_t)resInstPtr;
-  });
+  }
+
   // toString ( i )
-  externalFuncs.emplace("toString", [this](Args args) {
+  static Integer toString(Interpreter &interp, const Integer *args) {
     auto str = std::to_string(args[0]);
 
-    auto resInstPtr = (char *)fastMalloc(8 + str.length());
+    auto resInstPtr = (char *)interp.heap.allocate(8 + str.length());
     *(std::int64_t *)resInstPtr = (std::int64_t)str.length();
     resInstPtr += 8;
     std::memcpy(resInstPtr, str.c_str(), str.length());
     return (std::int64_t)resInstPtr;
-  });
+  }
 
   // memcpy ( dest src count )
-  externalFuncs.emplace("memcpy", [](Args args) {
+  static Integer memcpy(Interpreter &, const Integer *args) {
     std::memcpy((void *)args[0], (void *)args[1], (std::size_t)args[2]);
     return 0;
-  });
-}
-
-std::int64_t Interpreter::executeFunc(const FuncModule &func,
-                                      const std::vector<std::int64_t> &args) {
-  ActivationRecord ar{func};
-  assert(func.args.size() == args.size());
-  for (std::size_t i = 0; i < args.size(); ++i) {
-    ar.localReg[std::to_string(i)] = args[i];
   }
-
-  ars.emplace(std::move(ar));
-
-  std::size_t idx = func.firstBB;
-  while (idx != func.insts.size()) {
-    idx = executeInst(idx);
-  }
-  auto res = ars.top().retVal;
-  ars.pop();
+};
+
+const std::vector<Interpreter::Builtin> &Interpreter::getBuiltins() {
+  static const std::vector<Builtin> res = {
+      {"#_array_#_ctor_", 3, &Builtins::arrayCtor},
+      {"#_array_#size", 1, &Builtins::arraySize},
+      {"#string#length", 1, &Builtins::stringLength},
+      {"#string#add", 2, &Builtins::stringAdd},
+      {"#string#substring", 3, &Builtins::stringSubstring},
+      {"#string#ord", 2, &Builtins::stringOrd},
+      {"#string#parseInt", 1, &Builtins::stringParseInt},
+      {"#string#_ctor_", 1, &Builtins::stringCtor},
+      {"getInt", 0, &Builtins::getInt},
+      {"print", 1, &Builtins::print},
+      {"println", 1, &Builtins::println},
+      {"_printInt", 1, &Builtins::printInt},
+      {"_printlnInt", 1, &Builtins::printlnInt},
+      {"getString", 0, &Builtins::getString},
+      {"toString", 1, &Builtins::toString},
+      {"memcpy", 3, &Builtins::memcpy}};
   return res;
 }
 
-void Interpreter::executePhis(const std::vector<std::shared_ptr<Phi>> &phis) {
-  struct Change {
-    Change(std::shared_ptr<Addr> reg, int64_t val)
-        : reg(std::move(reg)), val(val) {}
-    std::shared_ptr<Addr> reg;
-    std::int64_t val;
-  };
-  std::vector<Change> changes;
-  auto &ar = ars.top();
-
-  for (const auto &p : phis) {
-    bool found = false;
-    for (auto &option : p->getOptions()) {
-      if (option.second->getID() == ar.lastBB) {
-        auto val = readVal(option.first);
-        changes.emplace_back(p->getDest(), (std::int64_t)val);
-        found = true;
-        break;
-      }
-    }
-    assert(found);
-  }
-
-  for (const auto &change : changes) {
-    writeReg(change.reg, change.val);
+std::int64_t Interpreter::findBuiltin(const std::string &name) {
+  auto &builtins = getBuiltins();
+  for (std::size_t i = 0; i < builtins.size(); ++i) {
+    if (name == builtins[i].name)
+      return (std::int64_t)i;
   }
+  return -1;
 }
 
 std::int64_t Interpreter::executeFunc(const std::string &funcName,
                                       const std::vector<std::int64_t> &args) {
-  // external
-  auto iter = externalFuncs.find(funcName);
-  if (iter != externalFuncs.end())
-    return iter->second(args);
-  return executeFunc(funcs.at(funcName), args);
+  auto builtin = findBuiltin(funcName);
+  if (builtin != -1) {
+    assert(getBuiltins()[builtin].arity == args.size());
+    return getBuiltins()[builtin].func(*this, args.data());
+  }
+
+  auto &func = funcs.at(funcIndices.at(funcName));
+  assert(func.numArgs == args.size());
+  auto mark = stack.mark();
+  auto frame = pushFrame(func);
+  std::copy(args.begin(), args.end(), frame);
+  auto res = execute(func, frame);
+  stack.release(mark);
+  return res;
 }
 
-std::size_t Interpreter::executeInst(std::size_t idx) {
-  auto &ar = ars.top();
-  auto inst = ar.curFunc.get().insts.at(idx);
-#ifdef PRINT_LOG
-  std::cerr << fmtInst(inst) << std::endl;
-#endif
-  auto &func = ar.curFunc;
-  if (auto p = dyc<Assign>(inst)) {
-    auto operand = readVal(p->getOperand());
-    writeReg(p->getDest(), operand);
-    return idx + 1;
-  }
-  if (auto p = dyc<ArithUnaryInst>(inst)) {
-    auto operand = readVal(p->getOperand());
-    writeReg(p->getDest(),
-             p->getOp() == ArithUnaryInst::OpType::Neg ? -operand : ~operand);
-    return idx + 1;
-  }
-  if (auto p = dyc<ArithBinaryInst>(inst)) {
-    auto lhs = readVal(p->getLhs()), rhs = readVal(p->getRhs());
-    switch (p->getOp()) {
-    case ArithBinaryInst::BitOr:
-      writeReg(p->getDest(), lhs | rhs);
-      break;
-    case ArithBinaryInst::BitAnd:
-      writeReg(p->getDest(), lhs & rhs);
-      break;
-    case ArithBinaryInst::Xor:
-      writeReg(p->getDest(), lhs ^ rhs);
-      break;
-    case ArithBinaryInst::Shl:
-      writeReg(p->getDest(), lhs << rhs);
-      break;
-    case ArithBinaryInst::Shr:
-      writeReg(p->getDest(), lhs >> rhs);
-      break;
-    case ArithBinaryInst::Add:
-      writeReg(p->getDest(), lhs + rhs);
-      break;
-    case ArithBinaryInst::Sub:
-      writeReg(p->getDest(), lhs - rhs);
-      break;
-    case ArithBinaryInst::Mul:
-      writeReg(p->getDest(), lhs * rhs);
-      break;
-    case ArithBinaryInst::Div:
-      writeReg(p->getDest(), lhs / rhs);
-      break;
-    case ArithBinaryInst::Mod:
-      writeReg(p->getDest(), lhs % rhs);
-      break;
-    default:
-      assert(false);
-    }
-    return idx + 1;
-  }
-  if (auto p = dyc<RelationInst>(inst)) {
-    auto lhs = readVal(p->getLhs()), rhs = readVal(p->getRhs());
-    std::int64_t res;
-    switch (p->getOp()) {
-    case RelationInst::Eq:
-      res = lhs == rhs;
-      break;
-    case RelationInst::Ne:
-      res = lhs != rhs;
-      break;
-    case RelationInst::Lt:
-      res = lhs < rhs;
-      break;
-    case RelationInst::Gt:
-      res = lhs > rhs;
-      break;
-    case RelationInst::Le:
-      res = lhs <= rhs;
-      break;
-    case RelationInst::Ge:
-      res = lhs >= rhs;
-      break;
-    default:
-      assert(false);
-    }
-    writeReg(p->getDest(), res);
-    return idx + 1;
-  }
-  if (auto p = dyc<Load>(inst)) {
-    auto addr = reinterpret_cast<std::int64_t *>(readVal(p->getAddr()));
-    auto val = *addr;
-    writeReg(p->getDest(), val);
-    return idx + 1;
-  }
-  if (auto p = dyc<Store>(inst)) {
-    std::int64_t val = readVal(p->getVal());
-    auto addr = reinterpret_cast<std::int64_t *>(readVal(p->getAddr()));
-    *addr = val;
-    printLog((std::int64_t)addr, val);
-    return idx + 1;
-  }
-  if (auto p = dyc<Alloca>(inst)) {
-    auto res = fastMalloc(8);
-    writeReg(p->getDest(), res);
-    return idx + 1;
-  }
-  if (auto p = dyc<Malloc>(inst)) {
-    auto sz = (std::size_t)readVal(p->getSize());
-    auto res = fastMalloc(sz);
-    writeReg(p->getDest(), res);
-    return idx + 1;
-  }
-  if (auto p = dyc<Branch>(inst)) {
-    auto condition = readVal(p->getCondition());
-    auto nxtLabel = condition ? p->getThen() : p->getElse();
-    ar.lastBB = ar.curBB;
-    ar.curBB = nxtLabel->getID();
-    return func.get().label2idx.at(nxtLabel->getID());
-  }
-  if (auto p = dyc<Jump>(inst)) {
-    ar.lastBB = ar.curBB;
-    ar.curBB = p->getLabel()->getID();
-    return func.get().label2idx.at(p->getLabel()->getID());
-  }
-  if (auto p = dyc<Ret>(inst)) {
-    if (p->getVal())
-      ars.top().retVal = readVal(p->getVal());
-    return func.get().insts.size();
-  }
-  if (auto p = dyc<Call>(inst)) {
-    std::vector<std::int64_t> args;
-    for (auto &argReg : p->getArgs())
-      args.emplace_back(readVal(argReg));
-    auto val = executeFunc(p->getFuncName(), args);
-    if (p->getDest())
-      writeReg(p->getDest(), val);
-    return idx + 1;
-  }
-  if (auto p = dyc<Phi>(inst)) {
-    std::vector<std::shared_ptr<Phi>> phis;
-    while (true) {
-      auto phi = dyc<Phi>(ar.curFunc.get().insts.at(idx));
-      if (!phi) {
-        executePhis(phis);
-        return idx;
-      }
-      phis.emplace_back(std::move(phi));
-      ++idx;
-    }
-  }
-  assert(false);
+Interpreter::Integer *Interpreter::pushFrame(bytecode::Function &func) {
+  if (profiling)
+    ++func.calls;
+  auto frame = stack.allocate(func.getFrameSize());
+  std::copy(func.consts.begin(), func.consts.end(), frame + func.numRegs);
+  return frame;
 }
 
-std::int64_t Interpreter::readVal(const std::shared_ptr<Addr> &reg) const {
-  if (auto p = dycLocalReg(reg)) {
-    if (p->getIdentifier() == ".phi_nan")
-      return -123;
-    return ars.top().localReg.at(p->getIdentifier());
-  }
-  if (auto p = dycGlobalReg(reg)) {
-    return globalReg.at(p->getIdentifier());
-  }
-  if (auto p = dyc<IntLiteral>(reg)) {
-    return p->getVal();
-  }
-  assert(false);
-}
+// The handlers are reached through a table of label addresses where GCC's
+// computed goto is available, so that each of them ends with its own indirect
+// jump. Otherwise, they are the cases of a switch.
+#if defined(__GNUC__)
+#define MOCKER_DISPATCH() goto *Handlers[(std::size_t)pc->op]
+#define MOCKER_HANDLER(NAME) Handle##NAME:
+#else
+#define MOCKER_DISPATCH() continue
+#define MOCKER_HANDLER(NAME) case bytecode::Opcode::NAME:
+#endif
 
-void *Interpreter::fastMalloc(std::size_t sz) {
-  if (curSize + sz <= Capacity && sz <= 128) {
-    auto res = (void *)(fastMem + curSize);
-    curSize += sz;
-    return res;
-  }
+std::int64_t Interpreter::execute(bytecode::Function &func,
+                                  Integer *frame) {
+  auto insts = func.insts.data();
+  auto pc = insts;
+  auto copies = func.copies.data();
+  auto edgeCopies = func.edgeCopies.data();
+  // Make the copies of the phi-functions on the edge taken.
+  auto copy = [frame, copies, edgeCopies](std::uint32_t edge) {
+    for (auto i = edgeCopies[edge].first; i < edgeCopies[edge].second; ++i)
+      frame[copies[i].first] = frame[copies[i].second];
+  };
 
-  auto res = std::malloc(sz);
-  malloced.emplace_back(res);
-  return res;
-}
+#define MOCKER_UNARY(NAME, OP)                                                 \
+  MOCKER_HANDLER(NAME) {                                                       \
+    frame[pc->dest] = OP frame[pc->a];                                         \
+    ++pc;                                                                      \
+    MOCKER_DISPATCH();                                                         \
+  }
+#define MOCKER_BINARY(NAME, OP)                                                \
+  MOCKER_HANDLER(NAME) {                                                       \
+    frame[pc->dest] = (Integer)(frame[pc->a] OP frame[pc->b]);                 \
+    ++pc;                                                                      \
+    MOCKER_DISPATCH();                                                         \
+  }
+
+#if defined(__GNUC__)
+#define MOCKER_HANDLER_ADDR(NAME) &&Handle##NAME,
+  static void *const Handlers[] = {
+      MOCKER_BYTECODE_OPCODES(MOCKER_HANDLER_ADDR)};
+#undef MOCKER_HANDLER_ADDR
+  MOCKER_DISPATCH();
+#else
+  while (true) {
+    switch (pc->op) {
+#endif
 
-void Interpreter::printLog(const std::shared_ptr<Addr> &addr,
-                           std::int64_t val) {
-#ifdef PRINT_LOG
-  if (auto p = dyc<Reg>(addr)) {
-    std::cerr << p->getIdentifier() << " <- " << val << std::endl;
-    return;
+  MOCKER_UNARY(Assign, )
+  MOCKER_UNARY(Neg, -)
+  MOCKER_UNARY(BitNot, ~)
+  MOCKER_BINARY(BitOr, |)
+  MOCKER_BINARY(BitAnd, &)
+  MOCKER_BINARY(Xor, ^)
+  MOCKER_BINARY(Shl, <<)
+  MOCKER_BINARY(Shr, >>)
+  MOCKER_BINARY(Add, +)
+  MOCKER_BINARY(Sub, -)
+  MOCKER_BINARY(Mul, *)
+  MOCKER_BINARY(Div, /)
+  MOCKER_BINARY(Mod, %)
+  MOCKER_BINARY(Eq, ==)
+  MOCKER_BINARY(Ne, !=)
+  MOCKER_BINARY(Lt, <)
+  MOCKER_BINARY(Le, <=)
+  MOCKER_BINARY(Gt, >)
+  MOCKER_BINARY(Ge, >=)
+
+  MOCKER_HANDLER(Load) {
+    frame[pc->dest] = *reinterpret_cast<std::int64_t *>(frame[pc->a]);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(LoadByte) {
+    frame[pc->dest] = *reinterpret_cast<std::uint8_t *>(frame[pc->a]);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Store) {
+    *reinterpret_cast<std::int64_t *>(frame[pc->a]) = frame[pc->b];
+    printLog(frame[pc->a], frame[pc->b]);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(StoreByte) {
+    auto val = (std::uint8_t)frame[pc->b];
+    *reinterpret_cast<std::uint8_t *>(frame[pc->a]) = val;
+    printLog(frame[pc->a], frame[pc->b]);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Alloca) {
+    frame[pc->dest] = (Integer)heap.allocate(8);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Malloc) {
+    frame[pc->dest] = (Integer)heap.allocate((std::size_t)frame[pc->a]);
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Br) {
+    auto taken = frame[pc->a] != 0;
+    copy(taken ? pc->dest : pc->dest + 1);
+    pc = insts + (taken ? pc->b : pc->c);
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Jump) {
+    copy(pc->dest);
+    pc = insts + pc->a;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(CountedBr) {
+    auto edge = frame[pc->a] != 0 ? pc->dest : pc->dest + 1;
+    ++func.edgeCounts[edge];
+    copy(edge);
+    pc = insts + (edge == pc->dest ? pc->b : pc->c);
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(CountedJump) {
+    ++func.edgeCounts[pc->dest];
+    copy(pc->dest);
+    pc = insts + pc->a;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(Ret) { return frame[pc->a]; }
+  MOCKER_HANDLER(RetVoid) { return 0; }
+  MOCKER_HANDLER(Call) {
+    auto &callee = funcs[func.targets[pc->a]];
+    auto args = func.callArgs.data() + pc->b;
+    auto mark = stack.mark();
+    auto calleeFrame = pushFrame(callee);
+    for (std::size_t i = 0; i < pc->c; ++i)
+      calleeFrame[i] = frame[args[i]];
+    auto val = execute(callee, calleeFrame);
+    stack.release(mark);
+    if (pc->dest != bytecode::NoSlot)
+      frame[pc->dest] = val;
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+  MOCKER_HANDLER(CallBuiltin) {
+    auto args = func.callArgs.data() + pc->b;
+    Integer vals[MaxBuiltinArity];
+    for (std::size_t i = 0; i < pc->c; ++i)
+      vals[i] = frame[args[i]];
+    auto val = getBuiltins()[func.targets[pc->a]].func(*this, vals);
+    if (pc->dest != bytecode::NoSlot)
+      frame[pc->dest] = val;
+    ++pc;
+    MOCKER_DISPATCH();
+  }
+
+#if !defined(__GNUC__)
+    default:
+      assert(false);
+    }
   }
 #endif
-}
 
-void Interpreter::printLog(const std::string &identifier, std::int64_t val) {
-#ifdef PRINT_LOG
-  std::cerr << identifier << " <- " << val << std::endl;
-#endif
+#undef MOCKER_UNARY
+#undef MOCKER_BINARY
 }
 
+#undef MOCKER_DISPATCH
+#undef MOCKER_HANDLER
+
 void Interpreter::printLog(std::int64_t addr, std::int64_t val) {
 #ifdef PRINT_LOG
   std::cerr << (std::int64_t)addr << " <- " << val << std::endl;
@@ -1,20 +1,29 @@
 #ifndef MOCKER_INTERPRETER_H
 #define MOCKER_INTERPRETER_H
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iostream>
 #include <memory>
-#include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "bytecode.h"
+#include "heap_arena.h"
 #include "ir/helper.h"
 #include "ir/ir_inst.h"
+#include "ir/profile.h"
+#include "ir/reg_table.h"
+#include "ir/serialize.h"
 
 namespace mocker {
 namespace ir {
 
+// An interpreter shares no mutable state with the others, so that each thread
+// may run its own.
 class Interpreter {
 private:
   using Iter = std::string::const_iterator;
@@ -23,13 +32,46 @@ private:
 public:
   explicit Interpreter(std::string source);
 
-  ~Interpreter();
+  explicit Interpreter(const SerializedModule &module);
+
+  // Execute a module in memory without printing it. The functions are lowered
+  // into bytecode right away, hence [module] need not outlive this.
+  explicit Interpreter(const Module &module);
+
+  // Add [func], or replace the function with the same identifier, so that a
+  // function can be run against the callees of another module. The global
+  // variables and the callees must already be there.
+  void overwriteFunc(const FunctionModule &func);
+
+  // The builtins read from [in] and write to [out], which are std::cin and
+  // std::cout by default.
+  void redirect(std::istream &in, std::ostream &out) {
+    this->in = &in;
+    this->out = &out;
+  }
 
   std::int64_t run();
 
+  // Call an arbitrary function instead of main.
+  std::int64_t run(const std::string &funcName,
+                   const std::vector<std::int64_t> &args);
+
+  // Count the calls of the functions and the edges taken from now on, at the
+  // cost of a little overhead on each branch.
+  void enableProfiling();
+
+  // The block, call-site and instruction counts are derived from the counts
+  // of the calls and the edges.
+  Profile getProfile() const;
+
+  // The numbers of the blocks entered and of the IR instructions of each type
+  // executed since the profiling was enabled
+  Histogram getDynamicHistogram() const;
+
+  const HeapArena &getHeap() const { return heap; }
+
 private:
   struct FuncModule;
-  struct ActivationRecord;
 
   std::string deleteComments(std::string source) const;
 
@@ -42,80 +84,123 @@ private:
 
   void parseFuncBody(std::istream &in, FuncModule &func);
 
-  std::shared_ptr<IRInst> parseInst(const std::string &line) const;
+  // The registers are created in [parsingRegs].
 
-  std::shared_ptr<Addr> parseAddr(const std::string &str) const;
+  std::shared_ptr<IRInst> parseInst(const std::string &line);
 
-private:
-  void initExternalFuncs();
+  std::shared_ptr<Addr> parseAddr(const std::string &str);
 
-  std::int64_t executeFunc(const std::string &funcName,
-                           const std::vector<std::int64_t> &args);
+  // Read the records of a serialized module in place.
+  void load(const SerializedModule &module);
 
-  std::int64_t executeFunc(const FuncModule &func,
-                           const std::vector<std::int64_t> &args);
+  std::shared_ptr<IRInst>
+  decodeInst(const SerializedModule &module, const binary::InstRecord &inst,
+             const std::vector<std::shared_ptr<Reg>> &regs);
 
-  void executePhis(const std::vector<std::shared_ptr<Phi>> &phis);
+  // Lower the parsed functions into bytecode. The addresses of the global
+  // variables are fixed from now on.
+  void lower();
 
-  std::size_t executeInst(std::size_t idx);
+  bytecode::Lowering makeLowering(std::size_t numArgs,
+                                  std::size_t numRegs) const;
 
-  std::int64_t readVal(const std::shared_ptr<Addr> &reg) const;
+  void lowerFunc(const FunctionModule &func);
 
-  template <class T> void writeReg(const std::shared_ptr<Addr> &reg, T val_) {
-    auto val = reinterpret_cast<std::int64_t>(val_);
-    printLog(reg, val);
-    if (auto p = dycLocalReg(reg)) {
-      ars.top().localReg[p->getIdentifier()] = val;
-      return;
-    }
-    if (auto p = dycGlobalReg(reg)) {
-      assert(false);
-      globalReg[p->getIdentifier()] = val;
-      return;
-    }
-    assert(false);
-  }
+  // Resolve the callees of all the call sites. A call of a builtin becomes a
+  // CallBuiltin. Throw std::out_of_range if a callee is undefined.
+  void link();
+
+private:
+  struct Builtins;
 
-  // Just for fun...
-  void *fastMalloc(std::size_t sz);
+  // The arguments of a builtin are passed in an array of [arity] values.
+  struct Builtin {
+    const char *name;
+    std::size_t arity;
+    Integer (*func)(Interpreter &interp, const Integer *args);
+  };
 
-  void printLog(const std::shared_ptr<Addr> &addr, std::int64_t val);
+  static constexpr std::size_t MaxBuiltinArity = 3;
 
-  void printLog(std::int64_t addr, std::int64_t val);
+  static const std::vector<Builtin> &getBuiltins();
+
+  // Return -1 if there is no builtin named so.
+  static std::int64_t findBuiltin(const std::string &name);
 
-  void printLog(const std::string &identfier, std::int64_t val);
+  std::int64_t executeFunc(const std::string &funcName,
+                           const std::vector<std::int64_t> &args);
+
+  // Allocate the frame of [func] and copy the constants in. The arguments are
+  // left to the caller.
+  Integer *pushFrame(bytecode::Function &func);
+
+  // Run [func] in [frame], whose arguments and constants are in place.
+  std::int64_t execute(bytecode::Function &func, Integer *frame);
+
+  void printLog(std::int64_t addr, std::int64_t val);
 
 private:
+  // The registers of a parsed function are numbered by its own RegTable. The
+  // n-th argument is the register named n, whose ID is also n.
   struct FuncModule {
     std::vector<std::shared_ptr<IRInst>> insts;
     std::vector<std::string> args;
-    std::unordered_map<std::size_t, std::size_t> label2idx;
-    std::size_t firstBB = 0;
-  };
-  struct ActivationRecord {
-    explicit ActivationRecord(const FuncModule &curFunc) : curFunc(curFunc) {}
-    ActivationRecord(ActivationRecord &&) = default;
-
-    std::reference_wrapper<const FuncModule> curFunc;
-    std::unordered_map<std::string, Integer> localReg;
-    std::size_t lastBB = 0, curBB = 0;
-    std::int64_t retVal = 0;
+    // (label, the index of the first instruction) in order
+    std::vector<std::pair<std::size_t, std::size_t>> bbs;
+    RegTable regTable;
   };
 
-  using ExternalFuncType =
-      std::function<std::int64_t(const std::vector<std::int64_t> &)>;
+  // The frames are carved out of chunks, so that a frame never moves while
+  // the callees push theirs.
+  class FrameStack {
+  public:
+    struct Mark {
+      std::size_t chunk, top;
+    };
+
+    Mark mark() const { return {cur, top}; }
+
+    void release(Mark mark) {
+      cur = mark.chunk;
+      top = mark.top;
+    }
+
+    Integer *allocate(std::size_t sz) {
+      while (cur < chunks.size() && top + sz > chunks[cur].second) {
+        ++cur;
+        top = 0;
+      }
+      if (cur == chunks.size()) {
+        auto chunkSz = chunks.empty() ? MinChunkSize : chunks.back().second * 2;
+        chunkSz = std::max(chunkSz, sz);
+        chunks.emplace_back(std::unique_ptr<Integer[]>(new Integer[chunkSz]),
+                            chunkSz);
+      }
+      auto res = chunks[cur].first.get() + top;
+      top += sz;
+      return res;
+    }
+
+  private:
+    static constexpr std::size_t MinChunkSize = 4096;
+
+    std::vector<std::pair<std::unique_ptr<Integer[]>, std::size_t>> chunks;
+    std::size_t cur = 0, top = 0;
+  };
 
+  RegTable *parsingRegs = nullptr;
   std::vector<GlobalVar> globalVars;
-  std::unordered_map<std::string, FuncModule> funcs;
-  std::unordered_map<std::string, ExternalFuncType> externalFuncs;
-  std::unordered_map<std::string, Integer> globalReg;
-  std::stack<ActivationRecord> ars;
-  std::vector<void *> malloced;
-
-  // fastMalloc
-  static constexpr std::size_t Capacity = 32 * 1024;
-  std::size_t curSize = 0;
-  std::int8_t fastMem[Capacity];
+  std::unordered_map<std::string, Integer> globalAddrs;
+  // Dropped once lowered
+  std::unordered_map<std::string, FuncModule> parsedFuncs;
+  // The calls refer to the functions by their indices.
+  std::vector<bytecode::Function> funcs;
+  std::unordered_map<std::string, std::size_t> funcIndices;
+  FrameStack stack;
+  bool profiling = false;
+  HeapArena heap;
+  std::istream *in = &std::cin;
+  std::ostream *out = &std::cout;
 };
 
 } // namespace ir
@@ -1,21 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "interpreter.h"
+#include "thread_pool.h"
 
 //#define PRINT_EXITCODE
 
-int main(int argc, char **argv) {
-  std::string path = argv[1];
+namespace {
+
+std::string readFile(const std::string &path) {
   std::ifstream fin(path);
+  if (!fin)
+    throw std::runtime_error("can not open " + path);
   std::stringstream sstr;
   sstr << fin.rdbuf();
-  std::string src = sstr.str();
+  return sstr.str();
+}
+
+std::unique_ptr<mocker::ir::Interpreter> load(const std::string &path) {
+  if (mocker::ir::isSerializedModule(path)) {
+    mocker::ir::SerializedModule module(path);
+    return std::make_unique<mocker::ir::Interpreter>(module);
+  }
+  return std::make_unique<mocker::ir::Interpreter>(readFile(path));
+}
+
+std::int64_t run(mocker::ir::Interpreter &interpreter,
+                 const std::string &profilePath, bool heapStats) {
+  if (!profilePath.empty())
+    interpreter.enableProfiling();
+  auto res = interpreter.run();
+  if (!profilePath.empty()) {
+    std::ofstream dumpProfile(profilePath);
+    mocker::ir::printProfile(interpreter.getProfile(), dumpProfile);
+  }
+  if (heapStats) {
+    auto &heap = interpreter.getHeap();
+    std::cerr << "heap: " << heap.getBytesAllocated() << " bytes allocated, "
+              << heap.getPeakBytesReserved() << " bytes reserved at peak"
+              << std::endl;
+  }
+  return res;
+}
+
+// A line of a batch lists the IR, the input and the expected output, where
+// the last two may be omitted or be "-".
+struct Case {
+  std::string irPath, inputPath = "-", outputPath = "-";
+};
+
+struct Result {
+  bool passed = false;
+  std::string message;
+};
+
+Result runCase(const Case &c) {
+  Result res;
+  try {
+    auto interpreter = load(c.irPath);
+    std::istringstream in(c.inputPath == "-" ? "" : readFile(c.inputPath));
+    std::ostringstream out;
+    interpreter->redirect(in, out);
+    auto exitcode = interpreter->run();
+    res.passed = c.outputPath == "-" || out.str() == readFile(c.outputPath);
+    res.message = "exit " + std::to_string(exitcode);
+    if (!res.passed)
+      res.message += ", unexpected output";
+  } catch (std::exception &e) {
+    res.message = e.what();
+  }
+  return res;
+}
+
+// Run the cases on [jobs] threads, each of which takes the next case not
+// taken yet. The results are reported in the order of the cases.
+int runBatch(const std::string &batchPath, std::size_t jobs) {
+  std::vector<Case> cases;
+  std::istringstream batch(readFile(batchPath));
+  std::string line;
+  while (std::getline(batch, line)) {
+    std::istringstream ss(line);
+    Case c;
+    if (!(ss >> c.irPath) || c.irPath[0] == '#')
+      continue;
+    ss >> c.inputPath >> c.outputPath;
+    cases.emplace_back(std::move(c));
+  }
+
+  std::vector<Result> results(cases.size());
+  std::atomic<std::size_t> next{0};
+  auto work = [&cases, &results, &next] {
+    for (auto i = next++; i < cases.size(); i = next++)
+      results[i] = runCase(cases[i]);
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < jobs; ++i)
+    workers.emplace_back(work);
+  work();
+  for (auto &worker : workers)
+    worker.join();
+
+  std::size_t failed = 0;
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    failed += !results[i].passed;
+    std::cout << (results[i].passed ? "PASS " : "FAIL ") << cases[i].irPath
+              << " (" << results[i].message << ")\n";
+  }
+  std::cout << cases.size() - failed << " passed, " << failed << " failed"
+            << std::endl;
+  return failed == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string path = argv[1];
+  std::string profilePath, batchPath;
+  bool heapStats = false;
+  std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 10, "--profile=") == 0)
+      profilePath = arg.substr(10);
+    if (arg == "--heap-stats")
+      heapStats = true;
+    if (arg.compare(0, 8, "--batch=") == 0)
+      batchPath = arg.substr(8);
+    if (arg.compare(0, 2, "-j") == 0 &&
+        !mocker::parseNumThreads(arg.substr(2), jobs)) {
+      std::cerr << "invalid number of threads: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  if (!batchPath.empty())
+    return runBatch(batchPath, jobs);
 
-  mocker::ir::Interpreter interpreter(src);
-  auto exitcode = interpreter.run();
+  std::unique_ptr<mocker::ir::Interpreter> interpreter;
+  try {
+    interpreter = load(path);
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  auto exitcode = run(*interpreter, profilePath, heapStats);
 
 #ifdef PRINT_EXITCODE
   std::cout << "=============================\nexit: " << exitcode << std::endl;
@@ -9,21 +9,43 @@
 #include <vector>
 
 #define MOCKER_IR_DYC(TYPE)                                                    \
-  template <class V> std::shared_ptr<TYPE> dyc_impl(V &&v, TYPE *) {           \
+  template <class V>                                                           \
+  std::shared_ptr<TYPE> dyc_impl(const std::shared_ptr<V> &v, TYPE *) {        \
     if (v->getInstType() == IRInst::TYPE)                                      \
       return std::static_pointer_cast<TYPE>(v);                                \
     return nullptr;                                                            \
+  }                                                                            \
+  inline TYPE *dyc_impl(IRInst *v, TYPE *) {                                   \
+    if (v && v->getInstType() == IRInst::TYPE)                                 \
+      return static_cast<TYPE *>(v);                                           \
+    return nullptr;                                                            \
+  }                                                                            \
+  inline const TYPE *dyc_impl(const IRInst *v, TYPE *) {                       \
+    if (v && v->getInstType() == IRInst::TYPE)                                 \
+      return static_cast<const TYPE *>(v);                                     \
+    return nullptr;                                                            \
   }
 
 // fast dynamic cast
+// Works on both shared pointers and raw pointers. The result is of the same
+// kind as the argument.
 namespace mocker {
 namespace ir {
 namespace detail {
 
-template <class T, class V> std::shared_ptr<T> dyc_impl(V &&v, T *) {
+template <class T, class V>
+std::shared_ptr<T> dyc_impl(const std::shared_ptr<V> &v, T *) {
   return std::dynamic_pointer_cast<T>(v);
 }
 
+template <class T, class V> T *dyc_impl(V *v, T *) {
+  return dynamic_cast<T *>(v);
+}
+
+template <class T, class V> const T *dyc_impl(const V *v, T *) {
+  return dynamic_cast<const T *>(v);
+}
+
 MOCKER_IR_DYC(Deleted)
 MOCKER_IR_DYC(Comment)
 MOCKER_IR_DYC(AttachedComment)
@@ -43,7 +65,7 @@ MOCKER_IR_DYC(Phi)
 
 } // namespace detail
 
-template <class T, class V> std::shared_ptr<T> dyc(V &&v) {
+template <class T, class V> auto dyc(V &&v) {
   return detail::dyc_impl(std::forward<V>(v), (T *)(nullptr));
 }
 
@@ -57,18 +79,17 @@ std::shared_ptr<Reg> dycGlobalReg(const std::shared_ptr<Addr> &addr);
 namespace mocker {
 namespace ir {
 
-std::shared_ptr<Reg> getDest(const std::shared_ptr<IRInst> &inst);
+std::shared_ptr<Reg> getDest(const IRInst *inst);
 
-std::vector<std::shared_ptr<Addr>>
-getOperandsUsed(const std::shared_ptr<IRInst> &inst);
+std::vector<std::shared_ptr<Addr>> getOperandsUsed(const IRInst *inst);
 
-std::shared_ptr<IRInst> copyWithReplacedOperands(
-    const std::shared_ptr<ir::IRInst> &inst,
-    const std::vector<std::shared_ptr<ir::Addr>> &operands);
+// The copy is owned by [func].
+IRInst *
+copyWithReplacedOperands(FunctionModule &func, const IRInst *inst,
+                         const std::vector<std::shared_ptr<Addr>> &operands);
 
-std::shared_ptr<IRInst>
-copyWithReplacedDest(const std::shared_ptr<ir::IRInst> &inst,
-                     const std::shared_ptr<ir::Reg> &newDest);
+IRInst *copyWithReplacedDest(FunctionModule &func, const IRInst *inst,
+                             const std::shared_ptr<ir::Reg> &newDest);
 
 // terminate if an error occurs
 void verifyFuncModule(const ir::FunctionModule &func);
@@ -0,0 +1,60 @@
+// A bump allocator owning the instructions of a function. Instructions are
+// constructed in place inside large chunks and are destroyed only when the
+// arena itself is destroyed, so removing an instruction from a basic block
+// never frees it.
+
+#ifndef MOCKER_INST_ARENA_H
+#define MOCKER_INST_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ir_inst.h"
+
+namespace mocker {
+namespace ir {
+
+class InstArena {
+public:
+  InstArena() = default;
+  InstArena(const InstArena &) = delete;
+  InstArena(InstArena &&other) noexcept;
+  InstArena &operator=(const InstArena &) = delete;
+  InstArena &operator=(InstArena &&other) noexcept;
+  ~InstArena();
+
+  template <class T, class... Args> T *make(Args &&... args) {
+    static_assert(std::is_base_of<IRInst, T>::value,
+                  "Only instructions can be allocated in an InstArena");
+    auto res = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    insts.emplace_back(res);
+    return res;
+  }
+
+  std::size_t getInstsNum() const { return insts.size(); }
+
+  std::size_t getBytesReserved() const { return chunks.size() * ChunkSize; }
+
+private:
+  void *allocate(std::size_t size, std::size_t align);
+
+  void destroyAll();
+
+private:
+  static constexpr std::size_t ChunkSize = 16 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks;
+  char *cur = nullptr, *chunkEnd = nullptr;
+  // every instruction ever constructed, in order of construction
+  std::vector<IRInst *> insts;
+};
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_INST_ARENA_H
@@ -0,0 +1,156 @@
+// An intrusive doubly linked list of instructions. The links are stored in the
+// instructions themselves, hence an instruction can be in at most one list at
+// a time. The list does not own the instructions; they are owned by the
+// InstArena of the enclosing function.
+//
+// The interface mimics std::list<IRInst *>, except that dereferencing an
+// iterator yields the pointer by value. Use replace() to substitute an
+// instruction in place.
+//
+// The list of a basic block notifies the block whenever it is modified, so
+// that the block can keep its successors and the epoch of its function up to
+// date. It also reports the instructions linked and unlinked to the function,
+// which records the uses of the registers.
+
+#ifndef MOCKER_INST_LIST_H
+#define MOCKER_INST_LIST_H
+
+#include <cstddef>
+#include <iterator>
+
+#include "ir_inst.h"
+
+namespace mocker {
+namespace ir {
+
+class BasicBlock;
+class FunctionModule;
+
+class InstList {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = IRInst *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = IRInst *;
+
+    iterator() = default;
+
+    IRInst *operator*() const { return cur; }
+
+    iterator &operator++() {
+      cur = cur->next;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto res = *this;
+      ++*this;
+      return res;
+    }
+
+    iterator &operator--() {
+      cur = cur ? cur->prev : list->tail;
+      return *this;
+    }
+
+    iterator operator--(int) {
+      auto res = *this;
+      --*this;
+      return res;
+    }
+
+    bool operator==(const iterator &rhs) const { return cur == rhs.cur; }
+
+    bool operator!=(const iterator &rhs) const { return cur != rhs.cur; }
+
+  private:
+    friend class InstList;
+
+    iterator(const InstList *list, IRInst *cur) : list(list), cur(cur) {}
+
+    const InstList *list = nullptr;
+    IRInst *cur = nullptr;
+  };
+
+  using const_iterator = iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = reverse_iterator;
+
+  InstList() = default;
+  InstList(const InstList &) = delete;
+  // The moves do not transfer the parent.
+  InstList(InstList &&other) noexcept;
+  InstList &operator=(const InstList &) = delete;
+  InstList &operator=(InstList &&other) noexcept;
+
+  iterator begin() const { return {this, head}; }
+
+  iterator end() const { return {this, nullptr}; }
+
+  reverse_iterator rbegin() const { return reverse_iterator(end()); }
+
+  reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+  // Return the iterator pointing to [inst], which must be in this list.
+  iterator iteratorTo(IRInst *inst) const { return {this, inst}; }
+
+  bool empty() const { return sz == 0; }
+
+  std::size_t size() const { return sz; }
+
+  IRInst *front() const { return head; }
+
+  IRInst *back() const { return tail; }
+
+  // Insert [inst] before [pos] and return the iterator pointing to it.
+  iterator insert(iterator pos, IRInst *inst);
+
+  void push_back(IRInst *inst) { insert(end(), inst); }
+
+  void push_front(IRInst *inst) { insert(begin(), inst); }
+
+  // Unlink the instruction at [pos] and return the iterator following it.
+  iterator erase(iterator pos);
+
+  iterator erase(iterator first, iterator last);
+
+  void pop_back() { erase(--end()); }
+
+  void pop_front() { erase(begin()); }
+
+  // Substitute [inst] for the instruction at [pos] and return the iterator
+  // pointing to [inst].
+  iterator replace(iterator pos, IRInst *inst);
+
+  // Move all instructions of [other] before [pos].
+  void splice(iterator pos, InstList &other);
+
+  // Move [first, last) of [other] before [pos].
+  void splice(iterator pos, InstList &other, iterator first, iterator last);
+
+  void clear();
+
+private:
+  friend class BasicBlock;
+
+  // Tell the parent that this list has been modified.
+  void notifyParent(const IRInst *oldBack);
+
+  // The function whose uses are to be kept up to date, if any.
+  FunctionModule *getFunc() const;
+
+  // Remove the uses of all the instructions from the function.
+  void clearUses();
+
+  IRInst *head = nullptr, *tail = nullptr;
+  std::size_t sz = 0;
+  BasicBlock *parent = nullptr;
+};
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_INST_LIST_H
@@ -1,9 +1,11 @@
 #ifndef MOCKER_IR_INST_H
 #define MOCKER_IR_INST_H
 
+#include <cassert>
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,35 +31,24 @@ private:
   std::int64_t val;
 };
 
+// Registers are created by a RegTable, which assigns each of them an ID that
+// is dense within the table. See reg_table.h.
 class Reg : public Addr {
 public:
-  explicit Reg(std::string identifier) : identifier(std::move(identifier)) {}
+  std::size_t getID() const { return id; }
 
   const std::string &getIdentifier() const { return identifier; }
 
 private:
-  std::string identifier;
-};
+  friend class RegTable;
 
-struct RegPtrHash {
-  std::size_t operator()(const std::shared_ptr<ir::Reg> &reg) const {
-    return std::hash<std::string>{}(reg->getIdentifier());
-  }
-};
+  Reg(std::size_t id, std::string identifier)
+      : id(id), identifier(std::move(identifier)) {}
 
-struct RegPtrEqual {
-  bool operator()(const std::shared_ptr<ir::Reg> &lhs,
-                  const std::shared_ptr<ir::Reg> &rhs) const {
-    return lhs->getIdentifier() == rhs->getIdentifier();
-  }
+  std::size_t id;
+  std::string identifier;
 };
 
-template <class T>
-using RegMap =
-    std::unordered_map<std::shared_ptr<ir::Reg>, T, RegPtrHash, RegPtrEqual>;
-using RegSet =
-    std::unordered_set<std::shared_ptr<ir::Reg>, RegPtrHash, RegPtrEqual>;
-
 class Label : public Addr {
 public:
   explicit Label(size_t id) : id(id) {}
@@ -97,6 +88,9 @@ public:
   };
 
   explicit IRInst(InstType type) : type(type) {}
+  // A copy is not linked into any list.
+  IRInst(const IRInst &other) : type(other.type) {}
+  IRInst &operator=(const IRInst &) = delete;
 
   virtual ~IRInst() = default;
 
@@ -104,8 +98,36 @@ public:
 
   InstType getInstType() const { return type; }
 
+  // The operands are the addresses used, in the order of getOperandsUsed().
+  // Neither the destination nor the labels are operands. They can be modified
+  // in place with FunctionModule::setOperand.
+  virtual std::size_t getNumOperands() const { return 0; }
+
+  const std::shared_ptr<Addr> &getOperand(std::size_t idx) const {
+    assert(idx < getNumOperands());
+    return const_cast<IRInst *>(this)->operandAt(idx);
+  }
+
 private:
+  friend class InstList;
+  friend class FunctionModule;
+
+  virtual std::shared_ptr<Addr> &operandAt(std::size_t) {
+    throw std::out_of_range("IRInst::operandAt");
+  }
+
+  // The labels referred to, which are the targets of a terminator or the
+  // incoming blocks of a phi-function.
+  virtual std::size_t getNumLabels() const { return 0; }
+
+  virtual std::shared_ptr<Label> &labelAt(std::size_t) {
+    throw std::out_of_range("IRInst::labelAt");
+  }
+
   InstType type;
+  IRInst *prev = nullptr, *next = nullptr;
+  // Whether the uses of the operands are recorded by a function.
+  bool usesRecorded = false;
 };
 
 class Terminator {
@@ -122,6 +144,8 @@ public:
   const std::shared_ptr<Reg> &getDest() const { return dest; }
 
 protected:
+  friend class FunctionModule;
+
   std::shared_ptr<Reg> dest;
 };
 
@@ -165,7 +189,11 @@ public:
 
   const std::shared_ptr<Addr> &getOperand() const { return operand; }
 
+  std::size_t getNumOperands() const override { return 1; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return operand; }
+
   std::shared_ptr<Addr> operand;
 };
 
@@ -182,7 +210,11 @@ public:
 
   const std::shared_ptr<Addr> &getOperand() const { return operand; }
 
+  std::size_t getNumOperands() const override { return 1; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return operand; }
+
   OpType op;
   std::shared_ptr<Addr> operand;
 };
@@ -209,7 +241,13 @@ public:
 
   const std::shared_ptr<Addr> &getRhs() const { return rhs; }
 
+  std::size_t getNumOperands() const override { return 2; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t idx) override {
+    return idx == 0 ? lhs : rhs;
+  }
+
   OpType op;
   std::shared_ptr<Addr> lhs, rhs;
 };
@@ -229,35 +267,66 @@ public:
 
   const std::shared_ptr<Addr> &getRhs() const { return rhs; }
 
+  std::size_t getNumOperands() const override { return 2; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t idx) override {
+    return idx == 0 ? lhs : rhs;
+  }
+
   OpType op;
   std::shared_ptr<Addr> lhs, rhs;
 };
 
+// [width] is the number of bytes accessed, which is either 1 or 8. A single
+// byte is zero-extended when loaded and truncated when stored.
 class Store : public IRInst {
 public:
-  Store(std::shared_ptr<Addr> addr, std::shared_ptr<Addr> val)
-      : IRInst(InstType::Store), addr(std::move(addr)), val(std::move(val)) {}
+  Store(std::shared_ptr<Addr> addr, std::shared_ptr<Addr> val,
+        std::size_t width = 8)
+      : IRInst(InstType::Store), addr(std::move(addr)), val(std::move(val)),
+        width(width) {
+    assert(width == 1 || width == 8);
+  }
 
   const std::shared_ptr<Addr> &getAddr() const { return addr; }
 
   const std::shared_ptr<Addr> &getVal() const { return val; }
 
+  std::size_t getWidth() const { return width; }
+
+  std::size_t getNumOperands() const override { return 2; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t idx) override {
+    return idx == 0 ? addr : val;
+  }
+
   std::shared_ptr<Addr> addr;
   std::shared_ptr<Addr> val;
+  std::size_t width;
 };
 
 class Load : public IRInst, public Definition {
 public:
-  Load(std::shared_ptr<Reg> dest, std::shared_ptr<Addr> addr)
+  Load(std::shared_ptr<Reg> dest, std::shared_ptr<Addr> addr,
+       std::size_t width = 8)
       : IRInst(InstType::Load), Definition(std::move(dest)),
-        addr(std::move(addr)) {}
+        addr(std::move(addr)), width(width) {
+    assert(width == 1 || width == 8);
+  }
 
   const std::shared_ptr<Addr> &getAddr() const { return addr; }
 
+  std::size_t getWidth() const { return width; }
+
+  std::size_t getNumOperands() const override { return 1; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return addr; }
+
   std::shared_ptr<Addr> addr;
+  std::size_t width;
 };
 
 class Alloca : public IRInst, public Definition {
@@ -274,7 +343,11 @@ public:
 
   const std::shared_ptr<Addr> &getSize() const { return size; }
 
+  std::size_t getNumOperands() const override { return 1; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return size; }
+
   std::shared_ptr<Addr> size;
 };
 
@@ -291,7 +364,17 @@ public:
 
   const std::shared_ptr<Label> &getElse() const { return else_; }
 
+  std::size_t getNumOperands() const override { return 1; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return condition; }
+
+  std::size_t getNumLabels() const override { return 2; }
+
+  std::shared_ptr<Label> &labelAt(std::size_t idx) override {
+    return idx == 0 ? then : else_;
+  }
+
   std::shared_ptr<Addr> condition;
   std::shared_ptr<Label> then, else_;
 };
@@ -304,6 +387,10 @@ public:
   const std::shared_ptr<Label> &getLabel() const { return label; }
 
 private:
+  std::size_t getNumLabels() const override { return 1; }
+
+  std::shared_ptr<Label> &labelAt(std::size_t) override { return label; }
+
   std::shared_ptr<Label> label;
 };
 
@@ -314,7 +401,11 @@ public:
 
   const std::shared_ptr<Addr> &getVal() const { return val; }
 
+  std::size_t getNumOperands() const override { return val ? 1 : 0; }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t) override { return val; }
+
   std::shared_ptr<Addr> val;
 };
 
@@ -339,7 +430,13 @@ public:
 
   const std::vector<std::shared_ptr<Addr>> &getArgs() const { return args; }
 
+  std::size_t getNumOperands() const override { return args.size(); }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t idx) override {
+    return args[idx];
+  }
+
   std::string funcName;
   std::vector<std::shared_ptr<Addr>> args;
 };
@@ -354,7 +451,19 @@ public:
 
   const std::vector<Option> &getOptions() const { return options; }
 
+  std::size_t getNumOperands() const override { return options.size(); }
+
 private:
+  std::shared_ptr<Addr> &operandAt(std::size_t idx) override {
+    return options[idx].first;
+  }
+
+  std::size_t getNumLabels() const override { return options.size(); }
+
+  std::shared_ptr<Label> &labelAt(std::size_t idx) override {
+    return options[idx].second;
+  }
+
   std::vector<std::pair<std::shared_ptr<Addr>, std::shared_ptr<Label>>> options;
 };
 
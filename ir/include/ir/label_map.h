@@ -0,0 +1,306 @@
+// The basic blocks of a function are numbered densely (see
+// FunctionModule::renumberBasicBlocks), hence the containers keyed by labels
+// are flat: LabelSet is a bitset and LabelMap is a vector indexed by the label.
+// Both iterate in ascending order of the labels.
+
+#ifndef MOCKER_LABEL_MAP_H
+#define MOCKER_LABEL_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mocker {
+namespace ir {
+
+class LabelSet {
+public:
+  using key_type = std::size_t;
+  using value_type = std::size_t;
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::size_t;
+
+    iterator() = default;
+
+    std::size_t operator*() const { return cur; }
+
+    iterator &operator++() {
+      cur = set->next(cur + 1);
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto res = *this;
+      ++*this;
+      return res;
+    }
+
+    bool operator==(const iterator &rhs) const { return cur == rhs.cur; }
+
+    bool operator!=(const iterator &rhs) const { return cur != rhs.cur; }
+
+  private:
+    friend class LabelSet;
+
+    iterator(const LabelSet *set, std::size_t cur) : set(set), cur(cur) {}
+
+    const LabelSet *set = nullptr;
+    std::size_t cur = 0;
+  };
+
+  using const_iterator = iterator;
+
+  LabelSet() = default;
+
+  LabelSet(std::initializer_list<std::size_t> labels) {
+    for (auto label : labels)
+      emplace(label);
+  }
+
+  iterator begin() const { return {this, next(0)}; }
+
+  iterator end() const { return {this, bound()}; }
+
+  bool empty() const { return sz == 0; }
+
+  std::size_t size() const { return sz; }
+
+  iterator find(std::size_t label) const {
+    return count(label) ? iterator(this, label) : end();
+  }
+
+  std::size_t count(std::size_t label) const {
+    auto w = label / WordBits;
+    return w < words.size() && (words[w] >> (label % WordBits) & 1);
+  }
+
+  std::pair<iterator, bool> emplace(std::size_t label) {
+    auto w = label / WordBits;
+    if (w >= words.size())
+      words.resize(w + 1);
+    auto mask = Word(1) << (label % WordBits);
+    bool inserted = !(words[w] & mask);
+    if (inserted) {
+      words[w] |= mask;
+      ++sz;
+    }
+    return {{this, label}, inserted};
+  }
+
+  std::size_t erase(std::size_t label) {
+    if (!count(label))
+      return 0;
+    words[label / WordBits] &= ~(Word(1) << (label % WordBits));
+    --sz;
+    return 1;
+  }
+
+  iterator erase(iterator pos) {
+    auto res = std::next(pos);
+    erase(*pos);
+    return res;
+  }
+
+  void clear() {
+    words.clear();
+    sz = 0;
+  }
+
+  // The following ones work a word at a time. Each of them returns whether
+  // this set has changed.
+  bool unionWith(const LabelSet &other);
+
+  bool intersectWith(const LabelSet &other);
+
+  bool subtract(const LabelSet &other);
+
+  friend bool operator==(const LabelSet &lhs, const LabelSet &rhs);
+
+  friend bool operator!=(const LabelSet &lhs, const LabelSet &rhs) {
+    return !(lhs == rhs);
+  }
+
+private:
+  using Word = std::uint64_t;
+  static constexpr std::size_t WordBits = 64;
+
+  std::size_t bound() const { return words.size() * WordBits; }
+
+  // Return the smallest label in this set that is not less than [from], or
+  // bound() if there is no such one.
+  std::size_t next(std::size_t from) const;
+
+  void recount();
+
+  std::vector<Word> words;
+  std::size_t sz = 0;
+};
+
+template <class T> class LabelMap {
+public:
+  using key_type = std::size_t;
+  using mapped_type = T;
+  using value_type = std::pair<const std::size_t, T>;
+
+private:
+  template <class V> class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::remove_const<V>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V *;
+    using reference = V &;
+
+    Iterator() = default;
+
+    // iterator -> const_iterator
+    template <class OtherV,
+              class = typename std::enable_if<
+                  std::is_convertible<OtherV *, V *>::value>::type>
+    Iterator(const Iterator<OtherV> &other) : map(other.map), cur(other.cur) {}
+
+    V &operator*() const { return map->slots[*cur]; }
+
+    V *operator->() const { return &map->slots[*cur]; }
+
+    Iterator &operator++() {
+      ++cur;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto res = *this;
+      ++*this;
+      return res;
+    }
+
+    friend bool operator==(const Iterator &lhs, const Iterator &rhs) {
+      return lhs.cur == rhs.cur;
+    }
+
+    friend bool operator!=(const Iterator &lhs, const Iterator &rhs) {
+      return lhs.cur != rhs.cur;
+    }
+
+  private:
+    friend class LabelMap;
+    template <class> friend class Iterator;
+
+    using Map = typename std::conditional<std::is_const<V>::value,
+                                          const LabelMap, LabelMap>::type;
+
+    Iterator(Map *map, LabelSet::iterator cur) : map(map), cur(cur) {}
+
+    Map *map = nullptr;
+    LabelSet::iterator cur;
+  };
+
+public:
+  using iterator = Iterator<value_type>;
+  using const_iterator = Iterator<const value_type>;
+
+  LabelMap() = default;
+  LabelMap(const LabelMap &) = default;
+  LabelMap(LabelMap &&) noexcept = default;
+  LabelMap &operator=(LabelMap &&) noexcept = default;
+
+  // The keys of the slots are const, so they can not be assigned in place.
+  LabelMap &operator=(const LabelMap &other) {
+    if (this != &other)
+      *this = LabelMap(other);
+    return *this;
+  }
+
+  iterator begin() { return {this, keys.begin()}; }
+  iterator end() { return {this, keys.end()}; }
+  const_iterator begin() const { return {this, keys.begin()}; }
+  const_iterator end() const { return {this, keys.end()}; }
+
+  bool empty() const { return keys.empty(); }
+
+  std::size_t size() const { return keys.size(); }
+
+  // The labels mapped.
+  const LabelSet &getKeys() const { return keys; }
+
+  iterator find(std::size_t label) { return {this, keys.find(label)}; }
+
+  const_iterator find(std::size_t label) const {
+    return {this, keys.find(label)};
+  }
+
+  std::size_t count(std::size_t label) const { return keys.count(label); }
+
+  T &at(std::size_t label) {
+    if (!keys.count(label))
+      throw std::out_of_range("LabelMap::at");
+    return slots[label].second;
+  }
+
+  const T &at(std::size_t label) const {
+    if (!keys.count(label))
+      throw std::out_of_range("LabelMap::at");
+    return slots[label].second;
+  }
+
+  // As with std::vector, growing the map invalidates the references.
+  T &operator[](std::size_t label) {
+    grow(label);
+    keys.emplace(label);
+    return slots[label].second;
+  }
+
+  template <class V>
+  std::pair<iterator, bool> emplace(std::size_t label, V &&val) {
+    grow(label);
+    bool inserted = keys.emplace(label).second;
+    if (inserted)
+      slots[label].second = std::forward<V>(val);
+    return {find(label), inserted};
+  }
+
+  std::size_t erase(std::size_t label) {
+    if (!keys.erase(label))
+      return 0;
+    slots[label].second = T();
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    auto label = pos->first;
+    auto res = std::next(find(label));
+    erase(label);
+    return res;
+  }
+
+  void clear() {
+    keys.clear();
+    slots.clear();
+  }
+
+private:
+  void grow(std::size_t label) {
+    slots.reserve(label + 1);
+    while (slots.size() <= label)
+      slots.emplace_back(slots.size(), T());
+  }
+
+  LabelSet keys;
+  std::vector<value_type> slots;
+};
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_LABEL_MAP_H
@@ -1,6 +1,8 @@
 #ifndef MOCKER_MODULE_H
 #define MOCKER_MODULE_H
 
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <stdexcept>
 #include <string>
@@ -8,39 +10,41 @@
 #include <unordered_set>
 #include <vector>
 
+#include "inst_arena.h"
+#include "inst_list.h"
 #include "ir_inst.h"
+#include "label_map.h"
+#include "reg_table.h"
 
 namespace mocker {
 namespace ir {
 
-using InstList = std::list<std::shared_ptr<IRInst>>;
-using InstListIter = typename InstList::const_iterator;
-template <class T> using LabelMap = std::unordered_map<std::size_t, T>;
-using LabelSet = std::unordered_set<std::size_t>;
+using InstListIter = InstList::iterator;
 
 class FunctionModule;
 
+// A block keeps its successors up to date as its terminator changes, and
+// reports the modifications to the enclosing function, which maintains the
+// predecessors and the epoch.
 class BasicBlock {
 public:
-  explicit BasicBlock(size_t labelID);
-  BasicBlock(const BasicBlock &) = default;
-  BasicBlock(BasicBlock &&) = default;
-  BasicBlock &operator=(const BasicBlock &) = default;
-  BasicBlock &operator=(BasicBlock &&) = default;
+  BasicBlock(size_t labelID, FunctionModule *func);
+  BasicBlock(const BasicBlock &) = delete;
+  BasicBlock(BasicBlock &&other) noexcept;
+  BasicBlock &operator=(const BasicBlock &) = delete;
+  BasicBlock &operator=(BasicBlock &&other) noexcept;
 
   std::size_t getLabelID() const { return labelID; }
 
-  void setLabelID(std::size_t label) { labelID = label; }
-
   const InstList &getInsts() const { return insts; }
 
   InstList &getMutableInsts() { return insts; }
 
-  void appendInst(std::shared_ptr<IRInst> inst);
+  void appendInst(IRInst *inst);
 
-  void appendInstFront(std::shared_ptr<IRInst> inst);
+  void appendInstFront(IRInst *inst);
 
-  void appendInstBeforeTerminator(std::shared_ptr<IRInst> inst);
+  void appendInstBeforeTerminator(IRInst *inst);
 
   // check whether the last instruction is a terminator
   bool isCompleted() const;
@@ -48,8 +52,24 @@ public:
   std::vector<std::size_t> getSuccessors() const;
 
 private:
+  friend class FunctionModule;
+  friend class InstList;
+
+  // Called by [insts] whenever it is modified.
+  void instsModified(bool backChanged);
+
+  void updateSuccessors();
+
   std::size_t labelID;
   InstList insts;
+  std::vector<std::size_t> succs;
+  FunctionModule *func = nullptr;
+};
+
+// The [idx]-th operand of [user].
+struct Use {
+  IRInst *user;
+  std::size_t idx;
 };
 
 using BasicBlockList = std::list<BasicBlock>;
@@ -59,17 +79,43 @@ class FunctionModule {
 public:
   FunctionModule(std::string identifier, std::vector<std::string> args,
                  bool isExternal = false);
-  FunctionModule(const FunctionModule &) = default;
-  FunctionModule(FunctionModule &&) = default;
-  FunctionModule &operator=(const FunctionModule &) = default;
-  FunctionModule &operator=(FunctionModule &&) = default;
-
+  // The instructions are cloned into the arena of the new function.
+  FunctionModule(const FunctionModule &other);
+  FunctionModule(FunctionModule &&other) noexcept;
+  FunctionModule &operator=(const FunctionModule &other);
+  FunctionModule &operator=(FunctionModule &&other) noexcept;
+
+  // The blocks must be created, removed and reordered through the following
+  // functions, so that the context stays up to date. The instructions can be
+  // modified freely.
   BBLIter pushBackBB();
 
   BBLIter insertBBAfter(BBLIter iter);
 
+  BBLIter eraseBB(BBLIter iter);
+
+  void removeBBIf(const std::function<bool(const BasicBlock &)> &condition);
+
+  // Move the block at [iter] before [pos].
+  void moveBB(BBLIter pos, BBLIter iter);
+
   void sortBasicBlocks();
 
+  // Relabel the blocks with 0, 1, ..., N-1 in the order of the list and update
+  // the labels used by the instructions accordingly.
+  void renumberBasicBlocks();
+
+  // Every label of this function is less than this.
+  std::size_t getLabelBound() const { return bbsSz; }
+
+  // The epoch is renewed whenever the instructions or the blocks of this
+  // function are modified. Epochs are unique across all functions, and a copy
+  // of a function gets a new one, since it has its own instructions. Hence,
+  // equal epochs imply the same instructions with identical contents.
+  std::uint64_t getEpoch() const { return epoch; }
+
+  void markModified();
+
   const std::vector<std::string> &getArgs() const { return args; }
 
   const BasicBlockList &getBBs() const { return bbs; }
@@ -82,8 +128,64 @@ public:
 
   std::shared_ptr<Reg> makeTempLocalReg(const std::string &hint = "");
 
+  // A function rebuilt from another one must continue with the counter of the
+  // original, so that the temporary registers do not collide.
+  std::size_t getTempRegCounter() const { return tempRegCounter; }
+
+  void setTempRegCounter(std::size_t counter) { tempRegCounter = counter; }
+
+  // Return the register of this function named [identifier], creating it if
+  // necessary. The n-th argument is the register named n, whose ID is also n.
+  const std::shared_ptr<Reg> &makeReg(const std::string &identifier) {
+    return regTable.get(identifier);
+  }
+
+  const RegTable &getRegTable() const { return regTable; }
+
+  // Construct an instruction owned by this function.
+  template <class T, class... Args> T *makeInst(Args &&... args) {
+    return arena.make<T>(std::forward<Args>(args)...);
+  }
+
+  // Clone [inst] into this function. The clone shares the registers of
+  // [inst]; if [inst] belongs to another function, they must be replaced with
+  // registers of this function before any RegMap or RegSet sees them.
+  IRInst *cloneInst(const IRInst *inst);
+
+  // Clone [inst], which may belong to another function, into this function,
+  // replacing the registers found in [regs] and the labels found in [labels].
+  // A destination must be replaced with a register.
+  IRInst *cloneInst(const IRInst *inst,
+                    const RegMap<std::shared_ptr<Addr>> &regs,
+                    const LabelMap<std::size_t> &labels);
+
+  // Clone the blocks of another function and insert them after [pos] in
+  // order, replacing the registers found in [regs]. Return the map from the
+  // labels of [other] to those of the clones.
+  LabelMap<std::size_t>
+  cloneBBsAfter(BBLIter pos, const FunctionModule &other,
+                const RegMap<std::shared_ptr<Addr>> &regs);
+
+  // The uses of [reg] by the instructions in the blocks of this function, in
+  // no particular order. They are kept up to date as the instructions are
+  // inserted, removed and modified.
+  const std::vector<Use> &getUses(const std::shared_ptr<Reg> &reg) const;
+
+  // Modify the [idx]-th operand of [inst], which is owned by this function, in
+  // place.
+  void setOperand(IRInst *inst, std::size_t idx,
+                  std::shared_ptr<Addr> operand);
+
+  // Make every use of [reg] use [operand] instead. Return the number of the
+  // uses replaced.
+  std::size_t replaceAllUsesWith(const std::shared_ptr<Reg> &reg,
+                                 const std::shared_ptr<Addr> &operand);
+
 public:
-  void buildContext();
+  // The context (the label-to-block map, the successors and predecessors and
+  // the uses) is maintained incrementally. This rebuilds it from scratch and asserts
+  // that the maintained one agrees, hence it is for debugging only.
+  void checkContext() const;
 
   const BasicBlock &getBasicBlock(std::size_t labelID) const;
 
@@ -95,6 +197,36 @@ public:
 
   std::vector<std::size_t> getPredcessors(std::size_t bb) const;
 
+  const LabelMap<std::vector<std::size_t>> &getPredecessorMap() const {
+    return predecessors;
+  }
+
+private:
+  friend class BasicBlock;
+  friend class InstList;
+
+  void attachBB(BasicBlock &bb);
+
+  void detachBB(BasicBlock &bb);
+
+  void updateEdges(std::size_t from, const std::vector<std::size_t> &oldSuccs,
+                   const std::vector<std::size_t> &newSuccs);
+
+  // Return nullptr unless [addr] is a register of this function. The
+  // instructions cloned from another function may temporarily use registers
+  // of that function, whose uses are not tracked.
+  const Reg *asOwnReg(const Addr *addr) const;
+
+  // Called when [inst] is linked into or unlinked from a block of this
+  // function.
+  void addUses(IRInst *inst);
+
+  void removeUses(IRInst *inst);
+
+  void addUse(const std::shared_ptr<Addr> &operand, Use use);
+
+  void removeUse(const std::shared_ptr<Addr> &operand, Use use);
+
 private:
   std::string identifier;
   std::vector<std::string> args;
@@ -102,10 +234,14 @@ private:
   std::size_t bbsSz = 0;
   std::size_t tempRegCounter;
   bool isExternal = false;
+  std::uint64_t epoch;
+  RegTable regTable;
+  InstArena arena;
 
 private: // context
-  std::unordered_map<std::size_t, std::reference_wrapper<BasicBlock>> bbMap;
-  std::unordered_map<std::size_t, std::vector<std::size_t>> predecessors;
+  LabelMap<BasicBlock *> bbMap;
+  LabelMap<std::vector<std::size_t>> predecessors;
+  std::vector<std::vector<Use>> uses; // indexed by the IDs of the registers
 };
 
 class GlobalVar {
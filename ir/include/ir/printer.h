@@ -11,7 +11,7 @@ namespace ir {
 
 std::string fmtAddr(const std::shared_ptr<Addr> &addr);
 
-std::string fmtInst(const std::shared_ptr<IRInst> &inst);
+std::string fmtInst(const IRInst *inst);
 
 void printFunc(const FunctionModule &func, std::ostream &out = std::cout);
 
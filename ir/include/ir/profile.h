@@ -0,0 +1,90 @@
+// An execution profile collected by the interpreter. It is keyed by the
+// identifiers of the functions and the labels of the blocks, hence it only
+// describes the blocks of the IR it was collected on. The checksum of the CFG
+// of a function tells whether a function still has those blocks.
+//
+// The textual format lists the functions in order:
+//
+//   function <identifier> <checksum> <#calls> <#instructions executed>
+//   block <label> <count>
+//   edge <from> <to> <count>
+//   call <label> <index of the call in the block> <callee> <count>
+//   end
+
+#ifndef MOCKER_PROFILE_H
+#define MOCKER_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "module.h"
+
+namespace mocker {
+namespace ir {
+
+struct CallSiteProfile {
+  std::size_t bb;
+  std::size_t idx;
+  std::string callee;
+  std::uint64_t count;
+};
+
+struct FuncProfile {
+  std::uint64_t getBlockCount(std::size_t label) const {
+    auto iter = blocks.find(label);
+    return iter == blocks.end() ? 0 : iter->second;
+  }
+
+  std::uint64_t getEdgeCount(std::size_t from, std::size_t to) const {
+    auto iter = edges.find({from, to});
+    return iter == edges.end() ? 0 : iter->second;
+  }
+
+  std::uint64_t checksum = 0;
+  std::uint64_t calls = 0;
+  std::uint64_t insts = 0;
+  std::map<std::size_t, std::uint64_t> blocks;
+  std::map<std::pair<std::size_t, std::size_t>, std::uint64_t> edges;
+  std::vector<CallSiteProfile> callSites;
+};
+
+class Profile {
+public:
+  FuncProfile &getFunc(const std::string &identifier) {
+    return funcs[identifier];
+  }
+
+  // Return nullptr if there is no profile of [func] or it was collected on a
+  // different CFG.
+  const FuncProfile *findFunc(const FunctionModule &func) const;
+
+  // The number of the calls of [callee] from all the call sites.
+  std::uint64_t countCalls(const std::string &callee) const;
+
+  const std::map<std::string, FuncProfile> &getFuncs() const { return funcs; }
+
+private:
+  std::map<std::string, FuncProfile> funcs;
+};
+
+// The checksum of a CFG is the sum of those of its blocks, so that it does
+// not depend on the order of the blocks.
+std::uint64_t hashBlock(std::size_t label,
+                        const std::vector<std::size_t> &succs);
+
+std::uint64_t computeCfgChecksum(const FunctionModule &func);
+
+void printProfile(const Profile &profile, std::ostream &out);
+
+// Throw std::runtime_error if the input is malformed.
+Profile readProfile(std::istream &in);
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_PROFILE_H
@@ -0,0 +1,400 @@
+// Every register of a function is interned in the RegTable of the function,
+// which gives it an ID in [0, size()). The identifier is kept for printing and
+// for looking registers up by name.
+//
+// RegMap and RegSet are indexed by these IDs instead of hashing identifiers.
+// Hence, the keys of a container must come from the same table.
+
+#ifndef MOCKER_REG_TABLE_H
+#define MOCKER_REG_TABLE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir_inst.h"
+#include "label_map.h"
+
+namespace mocker {
+namespace ir {
+
+class RegTable {
+public:
+  // Return the register named [identifier], creating it if necessary.
+  const std::shared_ptr<Reg> &get(const std::string &identifier);
+
+  // Return nullptr if there is no register named [identifier].
+  std::shared_ptr<Reg> find(const std::string &identifier) const;
+
+  const std::shared_ptr<Reg> &at(std::size_t id) const { return regs.at(id); }
+
+  std::size_t size() const { return regs.size(); }
+
+private:
+  std::unordered_map<std::string, std::size_t> ids;
+  std::vector<std::shared_ptr<Reg>> regs;
+};
+
+namespace detail {
+
+// Iterate over the non-empty slots of a vector of registers.
+template <class SlotIter, class V> class SlotIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename std::remove_const<V>::type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = V *;
+  using reference = V &;
+
+  SlotIterator() = default;
+
+  SlotIterator(SlotIter cur, SlotIter end) : cur(cur), end(end) { skip(); }
+
+  // iterator -> const_iterator
+  template <class OtherIter, class OtherV,
+            class = typename std::enable_if<
+                std::is_convertible<OtherIter, SlotIter>::value>::type>
+  SlotIterator(const SlotIterator<OtherIter, OtherV> &other)
+      : cur(other.cur), end(other.end) {}
+
+  V &operator*() const { return deref(*cur); }
+
+  V *operator->() const { return &deref(*cur); }
+
+  SlotIterator &operator++() {
+    ++cur;
+    skip();
+    return *this;
+  }
+
+  SlotIterator operator++(int) {
+    auto res = *this;
+    ++*this;
+    return res;
+  }
+
+  friend bool operator==(const SlotIterator &lhs, const SlotIterator &rhs) {
+    return lhs.cur == rhs.cur;
+  }
+
+  friend bool operator!=(const SlotIterator &lhs, const SlotIterator &rhs) {
+    return lhs.cur != rhs.cur;
+  }
+
+private:
+  template <class, class> friend class SlotIterator;
+
+  void skip() {
+    while (cur != end && !*cur)
+      ++cur;
+  }
+
+  static V &deref(const std::shared_ptr<Reg> &p) { return p; }
+
+  SlotIter cur, end;
+};
+
+} // namespace detail
+
+template <class T> class RegMap {
+public:
+  using key_type = std::shared_ptr<Reg>;
+  using mapped_type = T;
+  using value_type = std::pair<const std::shared_ptr<Reg>, T>;
+
+private:
+  // The entry of a register is constructed in place in the slot of its ID, and
+  // [keys] tells which slots hold one.
+  using Slot = typename std::aligned_storage<sizeof(value_type),
+                                             alignof(value_type)>::type;
+
+  template <class V> class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::remove_const<V>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = V *;
+    using reference = V &;
+
+    Iterator() = default;
+
+    // iterator -> const_iterator
+    template <class OtherV,
+              class = typename std::enable_if<
+                  std::is_convertible<OtherV *, V *>::value>::type>
+    Iterator(const Iterator<OtherV> &other) : map(other.map), cur(other.cur) {}
+
+    V &operator*() const { return map->getEntry(*cur); }
+
+    V *operator->() const { return &map->getEntry(*cur); }
+
+    Iterator &operator++() {
+      ++cur;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto res = *this;
+      ++*this;
+      return res;
+    }
+
+    friend bool operator==(const Iterator &lhs, const Iterator &rhs) {
+      return lhs.cur == rhs.cur;
+    }
+
+    friend bool operator!=(const Iterator &lhs, const Iterator &rhs) {
+      return lhs.cur != rhs.cur;
+    }
+
+  private:
+    friend class RegMap;
+    template <class> friend class Iterator;
+
+    using Map = typename std::conditional<std::is_const<V>::value,
+                                          const RegMap, RegMap>::type;
+
+    Iterator(Map *map, LabelSet::iterator cur) : map(map), cur(cur) {}
+
+    Map *map = nullptr;
+    LabelSet::iterator cur;
+  };
+
+public:
+  using iterator = Iterator<value_type>;
+  using const_iterator = Iterator<const value_type>;
+
+  RegMap() = default;
+
+  RegMap(const RegMap &other) : slots(other.slots.size()), keys(other.keys) {
+    for (auto id : keys)
+      new (&slots[id]) value_type(other.getEntry(id));
+  }
+
+  RegMap(RegMap &&other) noexcept
+      : slots(std::move(other.slots)), keys(std::move(other.keys)) {
+    other.slots.clear();
+    other.keys.clear();
+  }
+
+  RegMap &operator=(const RegMap &other) {
+    if (this != &other)
+      *this = RegMap(other);
+    return *this;
+  }
+
+  RegMap &operator=(RegMap &&other) noexcept {
+    if (this == &other)
+      return *this;
+    clear();
+    slots = std::move(other.slots);
+    keys = std::move(other.keys);
+    other.slots.clear();
+    other.keys.clear();
+    return *this;
+  }
+
+  ~RegMap() { clear(); }
+
+  iterator begin() { return {this, keys.begin()}; }
+  iterator end() { return {this, keys.end()}; }
+  const_iterator begin() const { return {this, keys.begin()}; }
+  const_iterator end() const { return {this, keys.end()}; }
+
+  bool empty() const { return keys.empty(); }
+
+  std::size_t size() const { return keys.size(); }
+
+  iterator find(const key_type &reg) {
+    return contains(reg) ? iterator(this, keys.find(reg->getID())) : end();
+  }
+
+  const_iterator find(const key_type &reg) const {
+    return contains(reg) ? const_iterator(this, keys.find(reg->getID()))
+                         : end();
+  }
+
+  std::size_t count(const key_type &reg) const { return contains(reg); }
+
+  T &at(const key_type &reg) {
+    if (!contains(reg))
+      throw std::out_of_range("RegMap::at");
+    return getEntry(reg->getID()).second;
+  }
+
+  const T &at(const key_type &reg) const {
+    if (!contains(reg))
+      throw std::out_of_range("RegMap::at");
+    return getEntry(reg->getID()).second;
+  }
+
+  // As with std::vector, growing the map invalidates the references, unless
+  // reserve() has made room for the register.
+  T &operator[](const key_type &reg) {
+    if (!contains(reg))
+      return construct(reg, T()).second;
+    return getEntry(reg->getID()).second;
+  }
+
+  template <class V>
+  std::pair<iterator, bool> emplace(const key_type &reg, V &&val) {
+    bool inserted = !contains(reg);
+    if (inserted)
+      construct(reg, std::forward<V>(val));
+    return {{this, keys.find(reg->getID())}, inserted};
+  }
+
+  std::size_t erase(const key_type &reg) {
+    if (!contains(reg))
+      return 0;
+    getEntry(reg->getID()).~value_type();
+    keys.erase(reg->getID());
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    auto reg = pos->first;
+    auto res = std::next(find(reg));
+    erase(reg);
+    return res;
+  }
+
+  void clear() {
+    for (auto id : keys)
+      getEntry(id).~value_type();
+    keys.clear();
+  }
+
+  // Make room for the registers with IDs less than [n], e.g. the size of the
+  // RegTable.
+  void reserve(std::size_t n) {
+    if (n > slots.size())
+      grow(n);
+  }
+
+private:
+  value_type &getEntry(std::size_t id) {
+    return *reinterpret_cast<value_type *>(&slots[id]);
+  }
+
+  const value_type &getEntry(std::size_t id) const {
+    return *reinterpret_cast<const value_type *>(&slots[id]);
+  }
+
+  bool contains(const key_type &reg) const {
+    auto id = reg->getID();
+    if (!keys.count(id))
+      return false;
+    assert(getEntry(id).first == reg &&
+           "the register comes from another table");
+    return true;
+  }
+
+  template <class V> value_type &construct(const key_type &reg, V &&val) {
+    auto id = reg->getID();
+    if (id >= slots.size())
+      grow(std::max(id + 1, 2 * slots.size()));
+    auto res = new (&slots[id]) value_type(reg, std::forward<V>(val));
+    keys.emplace(id);
+    return *res;
+  }
+
+  // The entries are moved one by one, since they may not be relocated bitwise.
+  void grow(std::size_t n) {
+    std::vector<Slot> newSlots(n);
+    for (auto id : keys) {
+      new (&newSlots[id]) value_type(std::move(getEntry(id)));
+      getEntry(id).~value_type();
+    }
+    slots.swap(newSlots);
+  }
+
+  std::vector<Slot> slots;
+  LabelSet keys;
+};
+
+class RegSet {
+private:
+  using Slots = std::vector<std::shared_ptr<Reg>>;
+
+public:
+  using key_type = std::shared_ptr<Reg>;
+  using value_type = std::shared_ptr<Reg>;
+  using iterator =
+      detail::SlotIterator<typename Slots::const_iterator, const value_type>;
+  using const_iterator = iterator;
+
+  iterator begin() const { return {slots.begin(), slots.end()}; }
+  iterator end() const { return {slots.end(), slots.end()}; }
+
+  bool empty() const { return sz == 0; }
+
+  std::size_t size() const { return sz; }
+
+  iterator find(const key_type &reg) const {
+    if (!contains(reg))
+      return end();
+    return {slots.begin() + reg->getID(), slots.end()};
+  }
+
+  std::size_t count(const key_type &reg) const { return contains(reg); }
+
+  std::pair<iterator, bool> emplace(const key_type &reg) {
+    auto id = reg->getID();
+    if (id >= slots.size())
+      slots.resize(id + 1);
+    bool inserted = !slots[id];
+    if (inserted) {
+      slots[id] = reg;
+      ++sz;
+    }
+    assert(slots[id] == reg && "the register comes from another table");
+    return {{slots.begin() + id, slots.end()}, inserted};
+  }
+
+  std::size_t erase(const key_type &reg) {
+    if (!contains(reg))
+      return 0;
+    slots[reg->getID()].reset();
+    --sz;
+    return 1;
+  }
+
+  iterator erase(iterator pos) {
+    auto res = std::next(pos);
+    auto reg = *pos;
+    erase(reg);
+    return res;
+  }
+
+  void clear() {
+    slots.clear();
+    sz = 0;
+  }
+
+private:
+  bool contains(const key_type &reg) const {
+    auto id = reg->getID();
+    if (id >= slots.size() || !slots[id])
+      return false;
+    assert(slots[id] == reg && "the register comes from another table");
+    return true;
+  }
+
+  Slots slots;
+  std::size_t sz = 0;
+};
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_REG_TABLE_H
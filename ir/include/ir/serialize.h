@@ -0,0 +1,233 @@
+// A versioned binary encoding of a module. Unlike the textual one, it is
+// loaded by mapping the file into memory and reading fixed-size records in
+// place, without tokenizing or allocating anything per token.
+//
+// The file consists of a header and the following sections, each of which is
+// an array of records aligned to 8 bytes:
+//
+//   Strings   the offsets of the strings into Chars, one more than the strings
+//   Chars     the bytes of the strings
+//   Vars      the global variables
+//   Funcs     the functions
+//   Args      the arguments of each function, as strings
+//   Regs      the identifiers of the registers of each function, by ID
+//   Blocks    the basic blocks of each function
+//   Insts     the instructions of each block
+//   Operands  the operands of each instruction
+//
+// Records refer to strings by index, to registers by their IDs in the
+// enclosing function and to consecutive records of another section by ranges.
+// The blocks are labeled with 0, 1, ..., N-1 in the order of the list.
+// Integers are in the byte order of the host.
+
+#ifndef MOCKER_SERIALIZE_H
+#define MOCKER_SERIALIZE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "module.h"
+
+namespace mocker {
+namespace ir {
+namespace binary {
+
+// Bump the version whenever the layout of any record changes.
+constexpr std::uint32_t Version = 2;
+constexpr char Magic[8] = {'M', 'O', 'C', 'K', 'E', 'R', 'I', 'R'};
+
+enum SectionKind {
+  Strings,
+  Chars,
+  Vars,
+  Funcs,
+  Args,
+  Regs,
+  Blocks,
+  Insts,
+  Operands,
+  NumSections
+};
+
+struct Section {
+  std::uint64_t offset; // from the beginning of the file
+  std::uint64_t size;   // the number of records
+};
+
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t numSections;
+  Section sections[NumSections];
+};
+
+struct Range {
+  std::uint32_t first, size;
+};
+
+struct VarRecord {
+  std::uint32_t label, data;
+};
+
+struct FuncRecord {
+  enum Flags : std::uint32_t { External = 1 };
+
+  std::uint32_t identifier;
+  std::uint32_t flags;
+  std::uint64_t tempRegCounter;
+  Range args, regs, blocks;
+};
+
+struct BlockRecord {
+  std::uint32_t label;
+  Range insts;
+};
+
+// [op] is the OpType of an arithmetic or a relation instruction, or the width
+// of a load or a store. [str] is the content of a comment or the name of the
+// callee of a call.
+//
+// An instruction with a destination has it as the first operand, which is
+// absent for a call without a result. The remaining operands are laid out as
+// the getters of the instruction list them, the options of a phi-function
+// being flattened into (value, label) pairs. A void ret has no operand.
+struct InstRecord {
+  std::uint16_t type; // IRInst::InstType
+  std::uint16_t op;
+  std::uint32_t str;
+  Range operands;
+};
+
+struct OperandRecord {
+  enum Kind : std::uint32_t { Absent, Register, IntLiteral, Label };
+
+  std::uint32_t kind;
+  std::uint32_t id; // the ID of the register or of the label
+  std::int64_t val; // the value of the literal
+};
+
+// A read-only view of consecutive records.
+template <class T> class Slice {
+public:
+  Slice(const T *first, std::size_t sz) : first(first), sz(sz) {}
+
+  const T *begin() const { return first; }
+  const T *end() const { return first + sz; }
+
+  std::size_t size() const { return sz; }
+
+  bool empty() const { return sz == 0; }
+
+  const T &operator[](std::size_t idx) const {
+    assert(idx < sz);
+    return first[idx];
+  }
+
+private:
+  const T *first;
+  std::size_t sz;
+};
+
+} // namespace binary
+
+void serializeModule(const Module &module, std::ostream &out);
+
+// Check the magic number at the beginning of the file at [path].
+bool isSerializedModule(const std::string &path);
+
+// A serialized module mapped into memory. The records are only valid while
+// this is alive.
+class SerializedModule {
+public:
+  // Throw std::runtime_error if the file can not be mapped or is not a
+  // serialized module of the current version.
+  explicit SerializedModule(const std::string &path);
+  SerializedModule(const SerializedModule &) = delete;
+  SerializedModule &operator=(const SerializedModule &) = delete;
+  ~SerializedModule();
+
+  std::size_t numStrings() const {
+    return getSection<std::uint32_t>(binary::Strings).size() - 1;
+  }
+
+  // The string is not null-terminated.
+  std::pair<const char *, std::size_t> getString(std::uint32_t id) const;
+
+  std::string getStdString(std::uint32_t id) const {
+    auto str = getString(id);
+    return std::string(str.first, str.second);
+  }
+
+  binary::Slice<binary::VarRecord> getVars() const {
+    return getSection<binary::VarRecord>(binary::Vars);
+  }
+
+  binary::Slice<binary::FuncRecord> getFuncs() const {
+    return getSection<binary::FuncRecord>(binary::Funcs);
+  }
+
+  binary::Slice<std::uint32_t> getArgs(const binary::FuncRecord &func) const {
+    return getRange<std::uint32_t>(binary::Args, func.args);
+  }
+
+  // The n-th string is the identifier of the register whose ID is n.
+  binary::Slice<std::uint32_t> getRegs(const binary::FuncRecord &func) const {
+    return getRange<std::uint32_t>(binary::Regs, func.regs);
+  }
+
+  binary::Slice<binary::BlockRecord>
+  getBlocks(const binary::FuncRecord &func) const {
+    return getRange<binary::BlockRecord>(binary::Blocks, func.blocks);
+  }
+
+  binary::Slice<binary::InstRecord>
+  getInsts(const binary::BlockRecord &block) const {
+    return getRange<binary::InstRecord>(binary::Insts, block.insts);
+  }
+
+  binary::Slice<binary::OperandRecord>
+  getOperands(const binary::InstRecord &inst) const {
+    return getRange<binary::OperandRecord>(binary::Operands, inst.operands);
+  }
+
+private:
+  const binary::Header &getHeader() const {
+    return *reinterpret_cast<const binary::Header *>(data);
+  }
+
+  template <class T>
+  binary::Slice<T> getSection(binary::SectionKind kind) const {
+    auto &section = getHeader().sections[kind];
+    return {reinterpret_cast<const T *>(data + section.offset),
+            (std::size_t)section.size};
+  }
+
+  template <class T>
+  binary::Slice<T> getRange(binary::SectionKind kind,
+                            const binary::Range &range) const {
+    auto section = getSection<T>(kind);
+    assert((std::size_t)range.first + range.size <= section.size());
+    return {section.begin() + range.first, range.size};
+  }
+
+  // Check that the sections lie within the file, that the ranges of the
+  // records lie within the sections and that each instruction has the
+  // operands its type requires, so that reading a corrupted file throws
+  // instead of crashing.
+  void validate() const;
+
+  const char *data = nullptr;
+  std::size_t sz = 0;
+};
+
+// Rebuild the module. The registers keep their IDs.
+Module deserializeModule(const SerializedModule &serialized);
+
+} // namespace ir
+} // namespace mocker
+
+#endif // MOCKER_SERIALIZE_H
@@ -1,7 +1,9 @@
 #ifndef MOCKER_STATS_H
 #define MOCKER_STATS_H
 
+#include <array>
 #include <cstddef>
+#include <iostream>
 #include <type_traits>
 
 #include "module.h"
@@ -9,10 +11,43 @@
 namespace mocker {
 namespace ir {
 
+constexpr std::size_t NumInstTypes = IRInst::Phi + 1;
+
+const char *getInstTypeName(IRInst::InstType type);
+
+// The number of the blocks and of the instructions of each type.
+struct Histogram {
+  std::size_t countInsts() const;
+
+  std::size_t countInsts(IRInst::InstType type) const { return insts[type]; }
+
+  std::size_t countPhis() const { return insts[IRInst::Phi]; }
+
+  std::size_t countMemOps() const {
+    return insts[IRInst::Load] + insts[IRInst::Store];
+  }
+
+  Histogram &operator+=(const Histogram &rhs);
+
+  std::size_t bbs = 0;
+  std::array<std::size_t, NumInstTypes> insts{}; // indexed by InstType
+};
+
+// Both traverse the instructions once.
+Histogram buildHistogram(const FunctionModule &func);
+
+Histogram buildHistogram(const Module &module);
+
+// {"blocks": ..., "insts": ..., "phis": ..., "memOps": ..., "types": {...}},
+// where the types with no instruction are omitted.
+void printHistogramJson(const Histogram &histogram, std::ostream &out);
+
 class Stats {
 public:
   explicit Stats(const Module &module) : module(module) {}
 
+  Histogram getHistogram() const { return buildHistogram(module); }
+
   std::size_t countBBs() const {
     std::size_t res = 0;
     for (auto &f : module.getFuncs())
@@ -29,8 +64,8 @@ public:
   }
 
   template <class Inst> std::size_t countInsts() const {
-    return countInstsIf([&](const std::shared_ptr<ir::IRInst> &inst) {
-      return (bool)std::dynamic_pointer_cast<Inst>(inst);
+    return countInstsIf([&](const ir::IRInst *inst) {
+      return (bool)dynamic_cast<const Inst *>(inst);
     });
   }
 
@@ -45,7 +80,7 @@ private:
                            const FunctionModule &func) const {
     std::size_t res = 0;
     for (const auto &bb : func.getBBs()) {
-      for (const auto &inst : bb.getInsts()) {
+      for (auto inst : bb.getInsts()) {
         if (condition(inst))
           ++res;
       }
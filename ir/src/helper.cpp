@@ -22,113 +22,84 @@ std::shared_ptr<Reg> dycGlobalReg(const std::shared_ptr<Addr> &addr) {
   return reg;
 }
 
-std::shared_ptr<Reg> getDest(const std::shared_ptr<IRInst> &inst) {
+std::shared_ptr<Reg> getDest(const IRInst *inst) {
   auto def = dyc<Definition>(inst);
   if (!def)
     return nullptr;
   return def->getDest();
 }
 
-std::vector<std::shared_ptr<Addr>>
-getOperandsUsed(const std::shared_ptr<IRInst> &inst) {
-  if (auto p = std::dynamic_pointer_cast<Assign>(inst))
-    return {p->getOperand()};
-  if (auto p = std::dynamic_pointer_cast<ArithUnaryInst>(inst))
-    return {p->getOperand()};
-  if (auto p = std::dynamic_pointer_cast<ArithBinaryInst>(inst))
-    return {p->getLhs(), p->getRhs()};
-  if (auto p = std::dynamic_pointer_cast<RelationInst>(inst))
-    return {p->getLhs(), p->getRhs()};
-  if (auto p = std::dynamic_pointer_cast<Store>(inst))
-    return {p->getAddr(), p->getVal()};
-  if (auto p = std::dynamic_pointer_cast<Load>(inst))
-    return {p->getAddr()};
-  if (auto p = std::dynamic_pointer_cast<Malloc>(inst))
-    return {p->getSize()};
-  if (auto p = std::dynamic_pointer_cast<Branch>(inst))
-    return {p->getCondition()};
-  if (auto p = std::dynamic_pointer_cast<Ret>(inst)) {
-    if (auto v = p->getVal())
-      return {v};
-    return {};
-  }
-
-  if (auto p = std::dynamic_pointer_cast<Call>(inst))
-    return p->getArgs();
-  if (auto p = std::dynamic_pointer_cast<Phi>(inst)) {
-    std::vector<std::shared_ptr<Addr>> res;
-    for (auto &option : p->getOptions())
-      res.emplace_back(option.first);
-    return res;
-  }
-  return {};
-}
-
-template <class T, class... Args> std::shared_ptr<T> mkS(Args &&... args) {
-  return std::make_shared<T>(std::forward<Args>(args)...);
+std::vector<std::shared_ptr<Addr>> getOperandsUsed(const IRInst *inst) {
+  std::vector<std::shared_ptr<Addr>> res;
+  res.reserve(inst->getNumOperands());
+  for (std::size_t i = 0; i < inst->getNumOperands(); ++i)
+    res.emplace_back(inst->getOperand(i));
+  return res;
 }
 
 namespace {
-std::shared_ptr<IRInst> copyWithReplacedDestAndOperands(
-    const std::shared_ptr<ir::IRInst> &inst,
+IRInst *copyWithReplacedDestAndOperands(
+    FunctionModule &func, const IRInst *inst,
     const std::shared_ptr<ir::Reg> &dest,
     const std::vector<std::shared_ptr<ir::Addr>> &operands) {
   if (dyc<Deleted>(inst)) {
     assert(operands.empty());
-    return mkS<Deleted>();
+    return func.makeInst<Deleted>();
   }
   if (auto p = dyc<Comment>(inst)) {
     assert(operands.empty());
-    return mkS<Comment>(p->getContent());
+    return func.makeInst<Comment>(p->getContent());
   }
   if (auto p = dyc<AttachedComment>(inst)) {
     assert(operands.empty());
-    return mkS<AttachedComment>(p->getContent());
+    return func.makeInst<AttachedComment>(p->getContent());
   }
   if (auto p = dyc<Alloca>(inst)) {
     assert(operands.empty());
-    return mkS<Alloca>(dest);
+    return func.makeInst<Alloca>(dest);
   }
   if (auto p = dyc<Jump>(inst)) {
     assert(operands.empty());
-    return mkS<Jump>(p->getLabel());
+    return func.makeInst<Jump>(p->getLabel());
   }
 
   if (auto p = dyc<Assign>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Assign>(dest, operands[0]);
+    return func.makeInst<Assign>(dest, operands[0]);
   }
   if (auto p = dyc<ArithUnaryInst>(inst)) {
     assert(operands.size() == 1);
-    return mkS<ArithUnaryInst>(dest, p->getOp(), operands[0]);
+    return func.makeInst<ArithUnaryInst>(dest, p->getOp(), operands[0]);
   }
   if (auto p = dyc<ArithBinaryInst>(inst)) {
     assert(operands.size() == 2);
-    return mkS<ArithBinaryInst>(dest, p->getOp(), operands[0], operands[1]);
+    return func.makeInst<ArithBinaryInst>(dest, p->getOp(), operands[0],
+                                          operands[1]);
   }
   if (auto p = dyc<RelationInst>(inst)) {
     assert(operands.size() == 2);
-    return mkS<RelationInst>(dest, p->getOp(), operands[0], operands[1]);
+    return func.makeInst<RelationInst>(dest, p->getOp(), operands[0],
+                                       operands[1]);
   }
   if (auto p = dyc<Store>(inst)) {
     assert(operands.size() == 2);
-    return mkS<Store>(operands[0], operands[1]);
+    return func.makeInst<Store>(operands[0], operands[1], p->getWidth());
   }
   if (auto p = dyc<Load>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Load>(dest, operands[0]);
+    return func.makeInst<Load>(dest, operands[0], p->getWidth());
   }
   if (auto p = dyc<Malloc>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Malloc>(dest, operands[0]);
+    return func.makeInst<Malloc>(dest, operands[0]);
   }
   if (auto p = dyc<Branch>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Branch>(operands[0], p->getThen(), p->getElse());
+    return func.makeInst<Branch>(operands[0], p->getThen(), p->getElse());
   }
   if (auto p = dyc<Ret>(inst)) {
     assert(operands.size() <= 1);
-    return mkS<Ret>(operands.empty() ? std::shared_ptr<Addr>(nullptr)
+    return func.makeInst<Ret>(operands.empty() ? std::shared_ptr<Addr>(nullptr)
                                      : operands[0]);
   }
   if (auto p = dyc<Call>(inst)) {
@@ -137,7 +108,7 @@ std::shared_ptr<IRInst> copyWithReplacedDestAndOperands(
     args.reserve(operands.size());
     for (auto &arg : operands)
       args.emplace_back(arg);
-    return mkS<Call>(dest, p->getFuncName(), std::move(args));
+    return func.makeInst<Call>(dest, p->getFuncName(), std::move(args));
   }
   if (auto p = dyc<Phi>(inst)) {
     assert(operands.size() == p->getOptions().size());
@@ -147,73 +118,73 @@ std::shared_ptr<IRInst> copyWithReplacedDestAndOperands(
       auto label = dyc<Label>(p->getOptions()[i].second);
       options.emplace_back(std::make_pair(val, label));
     }
-    return mkS<Phi>(dest, std::move(options));
+    return func.makeInst<Phi>(dest, std::move(options));
   }
   assert(false);
 }
 } // namespace
 
-std::shared_ptr<IRInst> copyWithReplacedOperands(
-    const std::shared_ptr<ir::IRInst> &inst,
-    const std::vector<std::shared_ptr<ir::Addr>> &operands) {
+IRInst *
+copyWithReplacedOperands(FunctionModule &func, const IRInst *inst,
+                         const std::vector<std::shared_ptr<Addr>> &operands) {
   if (dyc<Deleted>(inst)) {
     assert(operands.empty());
-    return mkS<Deleted>();
+    return func.makeInst<Deleted>();
   }
   if (auto p = dyc<Comment>(inst)) {
     assert(operands.empty());
-    return mkS<Comment>(p->getContent());
+    return func.makeInst<Comment>(p->getContent());
   }
   if (auto p = dyc<AttachedComment>(inst)) {
     assert(operands.empty());
-    return mkS<AttachedComment>(p->getContent());
+    return func.makeInst<AttachedComment>(p->getContent());
   }
   if (auto p = dyc<Alloca>(inst)) {
     assert(operands.empty());
-    return mkS<Alloca>(p->getDest());
+    return func.makeInst<Alloca>(p->getDest());
   }
   if (auto p = dyc<Jump>(inst)) {
     assert(operands.empty());
-    return mkS<Jump>(p->getLabel());
+    return func.makeInst<Jump>(p->getLabel());
   }
 
   if (auto p = dyc<Assign>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Assign>(p->getDest(), operands[0]);
+    return func.makeInst<Assign>(p->getDest(), operands[0]);
   }
   if (auto p = dyc<ArithUnaryInst>(inst)) {
     assert(operands.size() == 1);
-    return mkS<ArithUnaryInst>(p->getDest(), p->getOp(), operands[0]);
+    return func.makeInst<ArithUnaryInst>(p->getDest(), p->getOp(), operands[0]);
   }
   if (auto p = dyc<ArithBinaryInst>(inst)) {
     assert(operands.size() == 2);
-    return mkS<ArithBinaryInst>(p->getDest(), p->getOp(), operands[0],
+    return func.makeInst<ArithBinaryInst>(p->getDest(), p->getOp(), operands[0],
                                 operands[1]);
   }
   if (auto p = dyc<RelationInst>(inst)) {
     assert(operands.size() == 2);
-    return mkS<RelationInst>(p->getDest(), p->getOp(), operands[0],
+    return func.makeInst<RelationInst>(p->getDest(), p->getOp(), operands[0],
                              operands[1]);
   }
   if (auto p = dyc<Store>(inst)) {
     assert(operands.size() == 2);
-    return mkS<Store>(operands[0], operands[1]);
+    return func.makeInst<Store>(operands[0], operands[1], p->getWidth());
   }
   if (auto p = dyc<Load>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Load>(p->getDest(), operands[0]);
+    return func.makeInst<Load>(p->getDest(), operands[0], p->getWidth());
   }
   if (auto p = dyc<Malloc>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Malloc>(p->getDest(), operands[0]);
+    return func.makeInst<Malloc>(p->getDest(), operands[0]);
   }
   if (auto p = dyc<Branch>(inst)) {
     assert(operands.size() == 1);
-    return mkS<Branch>(operands[0], p->getThen(), p->getElse());
+    return func.makeInst<Branch>(operands[0], p->getThen(), p->getElse());
   }
   if (auto p = dyc<Ret>(inst)) {
     assert(operands.size() <= 1);
-    return mkS<Ret>(operands.empty() ? std::shared_ptr<Addr>(nullptr)
+    return func.makeInst<Ret>(operands.empty() ? std::shared_ptr<Addr>(nullptr)
                                      : operands[0]);
   }
   if (auto p = dyc<Call>(inst)) {
@@ -222,7 +193,7 @@ std::shared_ptr<IRInst> copyWithReplacedOperands(
     args.reserve(operands.size());
     for (auto &arg : operands)
       args.emplace_back(arg);
-    return mkS<Call>(p->getDest(), p->getFuncName(), std::move(args));
+    return func.makeInst<Call>(p->getDest(), p->getFuncName(), std::move(args));
   }
   if (auto p = dyc<Phi>(inst)) {
     assert(operands.size() == p->getOptions().size());
@@ -232,15 +203,15 @@ std::shared_ptr<IRInst> copyWithReplacedOperands(
       auto label = dyc<Label>(p->getOptions()[i].second);
       options.emplace_back(std::make_pair(val, label));
     }
-    return mkS<Phi>(p->getDest(), std::move(options));
+    return func.makeInst<Phi>(p->getDest(), std::move(options));
   }
   assert(false);
 }
 
-std::shared_ptr<IRInst>
-copyWithReplacedDest(const std::shared_ptr<ir::IRInst> &inst,
-                     const std::shared_ptr<ir::Reg> &newDest) {
-  return copyWithReplacedDestAndOperands(inst, newDest, getOperandsUsed(inst));
+IRInst *copyWithReplacedDest(FunctionModule &func, const IRInst *inst,
+                             const std::shared_ptr<ir::Reg> &newDest) {
+  return copyWithReplacedDestAndOperands(func, inst, newDest,
+                                         getOperandsUsed(inst));
 }
 
 void verifyFuncModule(const ir::FunctionModule &func) {
@@ -249,18 +220,34 @@ void verifyFuncModule(const ir::FunctionModule &func) {
     if (!bb.isCompleted())
       assert(false && "block not being terminated");
 
+  // check whether all registers come from the register table of the function
+  const auto &regTable = func.getRegTable();
+  auto isInterned = [&regTable](const std::shared_ptr<Addr> &addr) {
+    auto reg = dyc<Reg>(addr);
+    return !reg ||
+           (reg->getID() < regTable.size() && regTable.at(reg->getID()) == reg);
+  };
+  for (auto &bb : func.getBBs()) {
+    for (auto inst : bb.getInsts()) {
+      if (!isInterned(getDest(inst)))
+        assert(false && "register not in the register table");
+      for (auto &operand : getOperandsUsed(inst))
+        if (!isInterned(operand))
+          assert(false && "register not in the register table");
+    }
+  }
+
   // check whether all register are only defined once
-  std::unordered_set<std::string> defined;
+  RegSet defined;
   for (auto &bb : func.getBBs()) {
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto dest = getDest(inst);
       if (!dest)
         continue;
       auto reg = dycLocalReg(dest);
       assert(reg);
-      if (defined.find(reg->getIdentifier()) != defined.end())
+      if (!defined.emplace(reg).second)
         assert(false && "register with multiple definitions");
-      defined.emplace(reg->getIdentifier());
     }
   }
 
@@ -281,7 +268,7 @@ void verifyFuncModule(const ir::FunctionModule &func) {
     auto preds = func.getPredcessors(bb.getLabelID());
     std::sort(preds.begin(), preds.end());
 
-    for (auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       auto phi = dyc<ir::Phi>(inst);
       if (!phi)
         break;
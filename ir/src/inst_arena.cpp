@@ -0,0 +1,60 @@
+#include "inst_arena.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace mocker {
+namespace ir {
+
+InstArena::InstArena(InstArena &&other) noexcept
+    : chunks(std::move(other.chunks)), cur(other.cur),
+      chunkEnd(other.chunkEnd), insts(std::move(other.insts)) {
+  other.chunks.clear();
+  other.insts.clear();
+  other.cur = other.chunkEnd = nullptr;
+}
+
+InstArena &InstArena::operator=(InstArena &&other) noexcept {
+  if (this == &other)
+    return *this;
+  destroyAll();
+  chunks = std::move(other.chunks);
+  insts = std::move(other.insts);
+  cur = other.cur;
+  chunkEnd = other.chunkEnd;
+  other.chunks.clear();
+  other.insts.clear();
+  other.cur = other.chunkEnd = nullptr;
+  return *this;
+}
+
+InstArena::~InstArena() { destroyAll(); }
+
+void *InstArena::allocate(std::size_t size, std::size_t align) {
+  assert(size + align <= ChunkSize);
+  auto aligned = [align](char *p) {
+    auto addr = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<char *>((addr + align - 1) & ~(align - 1));
+  };
+
+  char *res = cur ? aligned(cur) : nullptr;
+  if (!res || res + size > chunkEnd) {
+    chunks.emplace_back(new char[ChunkSize]);
+    cur = chunks.back().get();
+    chunkEnd = cur + ChunkSize;
+    res = aligned(cur);
+  }
+  cur = res + size;
+  return res;
+}
+
+void InstArena::destroyAll() {
+  for (auto inst : insts)
+    inst->~IRInst();
+  insts.clear();
+  chunks.clear();
+  cur = chunkEnd = nullptr;
+}
+
+} // namespace ir
+} // namespace mocker
@@ -0,0 +1,202 @@
+#include "inst_list.h"
+
+#include <cassert>
+
+#include "module.h"
+
+namespace mocker {
+namespace ir {
+
+InstList::InstList(InstList &&other) noexcept
+    : head(other.head), tail(other.tail), sz(other.sz) {
+  if (auto func = other.getFunc()) {
+    for (auto p = head; p; p = p->next)
+      func->removeUses(p);
+  }
+  other.head = other.tail = nullptr;
+  other.sz = 0;
+  other.notifyParent(tail);
+}
+
+InstList &InstList::operator=(InstList &&other) noexcept {
+  if (this == &other)
+    return *this;
+  auto oldBack = tail;
+  clearUses();
+  for (auto p = head; p;) {
+    auto next = p->next;
+    p->prev = p->next = nullptr;
+    p = next;
+  }
+  head = other.head;
+  tail = other.tail;
+  sz = other.sz;
+  other.clearUses();
+  other.head = other.tail = nullptr;
+  other.sz = 0;
+  if (auto func = getFunc()) {
+    for (auto p = head; p; p = p->next)
+      func->addUses(p);
+  }
+  other.notifyParent(tail);
+  notifyParent(oldBack);
+  return *this;
+}
+
+void InstList::notifyParent(const IRInst *oldBack) {
+  if (parent)
+    parent->instsModified(tail != oldBack);
+}
+
+FunctionModule *InstList::getFunc() const {
+  return parent ? parent->func : nullptr;
+}
+
+void InstList::clearUses() {
+  if (auto func = getFunc()) {
+    for (auto p = head; p; p = p->next)
+      func->removeUses(p);
+  }
+}
+
+InstList::iterator InstList::insert(iterator pos, IRInst *inst) {
+  assert(inst && !inst->prev && !inst->next);
+  auto oldBack = tail;
+  auto next = pos.cur;
+  auto prev = next ? next->prev : tail;
+  inst->prev = prev;
+  inst->next = next;
+  if (prev)
+    prev->next = inst;
+  else
+    head = inst;
+  if (next)
+    next->prev = inst;
+  else
+    tail = inst;
+  ++sz;
+  if (auto func = getFunc())
+    func->addUses(inst);
+  notifyParent(oldBack);
+  return {this, inst};
+}
+
+InstList::iterator InstList::erase(iterator pos) {
+  auto inst = pos.cur;
+  assert(inst);
+  auto oldBack = tail;
+  auto next = inst->next;
+  if (inst->prev)
+    inst->prev->next = next;
+  else
+    head = next;
+  if (next)
+    next->prev = inst->prev;
+  else
+    tail = inst->prev;
+  inst->prev = inst->next = nullptr;
+  --sz;
+  if (auto func = getFunc())
+    func->removeUses(inst);
+  notifyParent(oldBack);
+  return {this, next};
+}
+
+InstList::iterator InstList::erase(iterator first, iterator last) {
+  while (first != last)
+    first = erase(first);
+  return last;
+}
+
+InstList::iterator InstList::replace(iterator pos, IRInst *inst) {
+  if (pos.cur == inst)
+    return pos;
+  // Notify only once, with the new instruction in place.
+  auto oldParent = parent;
+  parent = nullptr;
+  auto oldBack = tail;
+  auto oldInst = pos.cur;
+  auto res = insert(erase(pos), inst);
+  parent = oldParent;
+  if (auto func = getFunc()) {
+    func->removeUses(oldInst);
+    func->addUses(inst);
+  }
+  notifyParent(oldBack);
+  return res;
+}
+
+void InstList::splice(iterator pos, InstList &other) {
+  splice(pos, other, other.begin(), other.end());
+}
+
+void InstList::splice(iterator pos, InstList &other, iterator first,
+                      iterator last) {
+  if (first == last)
+    return;
+  auto oldBack = tail, oldOtherBack = other.tail;
+  auto firstInst = first.cur;
+  auto lastInst = last.cur ? last.cur->prev : other.tail;
+  std::size_t cnt = 1;
+  for (auto p = firstInst; p != lastInst; p = p->next)
+    ++cnt;
+
+  // The uses need updating only if the instructions change function.
+  auto func = getFunc(), otherFunc = other.getFunc();
+  if (func != otherFunc) {
+    for (auto p = firstInst;; p = p->next) {
+      if (otherFunc)
+        otherFunc->removeUses(p);
+      if (func)
+        func->addUses(p);
+      if (p == lastInst)
+        break;
+    }
+  }
+
+  // unlink from [other]
+  if (firstInst->prev)
+    firstInst->prev->next = last.cur;
+  else
+    other.head = last.cur;
+  if (last.cur)
+    last.cur->prev = firstInst->prev;
+  else
+    other.tail = firstInst->prev;
+  other.sz -= cnt;
+
+  // link into this list
+  auto next = pos.cur;
+  auto prev = next ? next->prev : tail;
+  firstInst->prev = prev;
+  lastInst->next = next;
+  if (prev)
+    prev->next = firstInst;
+  else
+    head = firstInst;
+  if (next)
+    next->prev = lastInst;
+  else
+    tail = lastInst;
+  sz += cnt;
+  other.notifyParent(oldOtherBack);
+  notifyParent(oldBack);
+}
+
+void InstList::clear() {
+  if (!head)
+    return;
+  auto oldBack = tail;
+  clearUses();
+  for (auto p = head; p;) {
+    auto next = p->next;
+    p->prev = p->next = nullptr;
+    p = next;
+  }
+  head = tail = nullptr;
+  sz = 0;
+  notifyParent(oldBack);
+}
+
+} // namespace ir
+} // namespace mocker
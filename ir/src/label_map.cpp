@@ -0,0 +1,77 @@
+#include "label_map.h"
+
+#include <algorithm>
+
+namespace mocker {
+namespace ir {
+
+bool LabelSet::unionWith(const LabelSet &other) {
+  if (words.size() < other.words.size())
+    words.resize(other.words.size());
+  bool changed = false;
+  for (std::size_t i = 0; i < other.words.size(); ++i) {
+    auto w = words[i] | other.words[i];
+    changed |= w != words[i];
+    words[i] = w;
+  }
+  if (changed)
+    recount();
+  return changed;
+}
+
+bool LabelSet::intersectWith(const LabelSet &other) {
+  bool changed = false;
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    auto w = i < other.words.size() ? words[i] & other.words[i] : 0;
+    changed |= w != words[i];
+    words[i] = w;
+  }
+  if (changed)
+    recount();
+  return changed;
+}
+
+bool LabelSet::subtract(const LabelSet &other) {
+  bool changed = false;
+  auto n = std::min(words.size(), other.words.size());
+  for (std::size_t i = 0; i < n; ++i) {
+    auto w = words[i] & ~other.words[i];
+    changed |= w != words[i];
+    words[i] = w;
+  }
+  if (changed)
+    recount();
+  return changed;
+}
+
+bool operator==(const LabelSet &lhs, const LabelSet &rhs) {
+  if (lhs.sz != rhs.sz)
+    return false;
+  auto n = std::min(lhs.words.size(), rhs.words.size());
+  // The sizes are equal, so the trailing words of the longer one are zero
+  // whenever the common prefixes are equal.
+  return std::equal(lhs.words.begin(), lhs.words.begin() + n,
+                    rhs.words.begin());
+}
+
+std::size_t LabelSet::next(std::size_t from) const {
+  auto w = from / WordBits;
+  if (w >= words.size())
+    return bound();
+  auto bits = words[w] & (~Word(0) << (from % WordBits));
+  while (!bits) {
+    if (++w == words.size())
+      return bound();
+    bits = words[w];
+  }
+  return w * WordBits + __builtin_ctzll(bits);
+}
+
+void LabelSet::recount() {
+  sz = 0;
+  for (auto w : words)
+    sz += __builtin_popcountll(w);
+}
+
+} // namespace ir
+} // namespace mocker
@@ -1,50 +1,109 @@
 #include "module.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "defer.h"
+#include "helper.h"
 
 namespace mocker {
 namespace ir {
 
-BasicBlock::BasicBlock(size_t labelID) : labelID(labelID) {}
+namespace {
 
-void BasicBlock::appendInst(std::shared_ptr<IRInst> inst) {
+std::uint64_t newEpoch() {
+  static std::atomic<std::uint64_t> cnt{0};
+  return ++cnt;
+}
+
+std::vector<std::size_t> computeSuccessors(const InstList &insts) {
+  if (insts.empty())
+    return {};
+  auto lastInst = insts.back();
+  if (lastInst->getInstType() == IRInst::Jump)
+    return {static_cast<Jump *>(lastInst)->getLabel()->getID()};
+  if (lastInst->getInstType() == IRInst::Branch) {
+    auto p = static_cast<Branch *>(lastInst);
+    return {p->getThen()->getID(), p->getElse()->getID()};
+  }
+  return {};
+}
+
+} // namespace
+
+BasicBlock::BasicBlock(size_t labelID, FunctionModule *func)
+    : labelID(labelID), func(func) {
+  insts.parent = this;
+}
+
+BasicBlock::BasicBlock(BasicBlock &&other) noexcept
+    : labelID(other.labelID), succs(std::move(other.succs)), func(other.func) {
+  // The edges are handed over silently.
+  other.insts.parent = nullptr;
+  insts = std::move(other.insts);
+  insts.parent = this;
+  other.insts.parent = &other;
+  other.succs.clear();
+}
+
+BasicBlock &BasicBlock::operator=(BasicBlock &&other) noexcept {
+  if (this == &other)
+    return *this;
+  labelID = other.labelID;
+  func = other.func;
+  succs = std::move(other.succs);
+  other.succs.clear();
+  insts.parent = other.insts.parent = nullptr;
+  insts = std::move(other.insts);
+  insts.parent = this;
+  other.insts.parent = &other;
+  return *this;
+}
+
+void BasicBlock::appendInst(IRInst *inst) {
   if (isCompleted())
     throw std::logic_error("Can't append insts into a completed block");
-  insts.emplace_back(std::move(inst));
+  insts.push_back(inst);
 }
 
-void BasicBlock::appendInstFront(std::shared_ptr<IRInst> inst) {
-  insts.emplace_front(std::move(inst));
-}
+void BasicBlock::appendInstFront(IRInst *inst) { insts.push_front(inst); }
 
-void BasicBlock::appendInstBeforeTerminator(std::shared_ptr<IRInst> inst) {
+void BasicBlock::appendInstBeforeTerminator(IRInst *inst) {
   assert(isCompleted());
   auto pos = --insts.end();
-  insts.emplace(pos, std::move(inst));
+  insts.insert(pos, inst);
 }
 
 bool BasicBlock::isCompleted() const {
   if (insts.empty())
     return false;
-  return (bool)std::dynamic_pointer_cast<Terminator>(insts.back());
+  auto type = insts.back()->getInstType();
+  return type == IRInst::Ret || type == IRInst::Jump || type == IRInst::Branch;
 }
 
 std::vector<std::size_t> BasicBlock::getSuccessors() const {
   assert(isCompleted());
-  const auto &lastInst = insts.back();
-  if (std::dynamic_pointer_cast<Ret>(lastInst))
-    return {};
-  if (auto p = std::dynamic_pointer_cast<Jump>(lastInst))
-    return {p->getLabel()->getID()};
-  if (auto p = std::dynamic_pointer_cast<Branch>(lastInst))
-    return {p->getThen()->getID(), p->getElse()->getID()};
-  assert(false);
+  return succs;
+}
+
+void BasicBlock::instsModified(bool backChanged) {
+  if (func)
+    func->markModified();
+  if (backChanged)
+    updateSuccessors();
+}
+
+void BasicBlock::updateSuccessors() {
+  auto newSuccs = computeSuccessors(insts);
+  if (newSuccs == succs)
+    return;
+  if (func)
+    func->updateEdges(labelID, succs, newSuccs);
+  succs = std::move(newSuccs);
 }
 
 GlobalVar::GlobalVar(std::string label, std::string data)
@@ -53,47 +112,368 @@ GlobalVar::GlobalVar(std::string label, std::string data)
 FunctionModule::FunctionModule(std::string identifier,
                                std::vector<std::string> args_, bool isExternal)
     : identifier(std::move(identifier)), args(std::move(args_)),
-      isExternal(isExternal), tempRegCounter(args.size()) {}
+      isExternal(isExternal), tempRegCounter(args.size()), epoch(newEpoch()) {
+  for (std::size_t i = 0; i < args.size(); ++i)
+    regTable.get(std::to_string(i));
+}
+
+FunctionModule::FunctionModule(const FunctionModule &other)
+    : identifier(other.identifier), args(other.args), bbsSz(other.bbsSz),
+      tempRegCounter(other.tempRegCounter), isExternal(other.isExternal),
+      regTable(other.regTable) {
+  for (auto &bb : other.bbs) {
+    bbs.emplace_back(bb.getLabelID(), this);
+    attachBB(bbs.back());
+    for (auto inst : bb.getInsts())
+      bbs.back().getMutableInsts().push_back(cloneInst(inst));
+  }
+  // The analyses of [other] refer to its instructions.
+  epoch = newEpoch();
+}
+
+FunctionModule::FunctionModule(FunctionModule &&other) noexcept
+    : identifier(std::move(other.identifier)), args(std::move(other.args)),
+      bbs(std::move(other.bbs)), bbsSz(other.bbsSz),
+      tempRegCounter(other.tempRegCounter), isExternal(other.isExternal),
+      epoch(other.epoch), regTable(std::move(other.regTable)),
+      arena(std::move(other.arena)),
+      bbMap(std::move(other.bbMap)),
+      predecessors(std::move(other.predecessors)),
+      uses(std::move(other.uses)) {
+  for (auto &bb : bbs)
+    bb.func = this;
+}
+
+FunctionModule &FunctionModule::operator=(const FunctionModule &other) {
+  if (this == &other)
+    return *this;
+  return *this = FunctionModule(other);
+}
+
+FunctionModule &FunctionModule::operator=(FunctionModule &&other) noexcept {
+  if (this == &other)
+    return *this;
+  identifier = std::move(other.identifier);
+  args = std::move(other.args);
+  bbs = std::move(other.bbs);
+  bbsSz = other.bbsSz;
+  tempRegCounter = other.tempRegCounter;
+  isExternal = other.isExternal;
+  epoch = other.epoch;
+  regTable = std::move(other.regTable);
+  arena = std::move(other.arena);
+  bbMap = std::move(other.bbMap);
+  predecessors = std::move(other.predecessors);
+  uses = std::move(other.uses);
+  for (auto &bb : bbs)
+    bb.func = this;
+  return *this;
+}
+
+IRInst *FunctionModule::cloneInst(const IRInst *inst) {
+  switch (inst->getInstType()) {
+  case IRInst::Deleted:
+    return makeInst<Deleted>(*static_cast<const Deleted *>(inst));
+  case IRInst::Comment:
+    return makeInst<Comment>(*static_cast<const Comment *>(inst));
+  case IRInst::AttachedComment:
+    return makeInst<AttachedComment>(
+        *static_cast<const AttachedComment *>(inst));
+  case IRInst::Assign:
+    return makeInst<Assign>(*static_cast<const Assign *>(inst));
+  case IRInst::ArithUnaryInst:
+    return makeInst<ArithUnaryInst>(*static_cast<const ArithUnaryInst *>(inst));
+  case IRInst::ArithBinaryInst:
+    return makeInst<ArithBinaryInst>(
+        *static_cast<const ArithBinaryInst *>(inst));
+  case IRInst::RelationInst:
+    return makeInst<RelationInst>(*static_cast<const RelationInst *>(inst));
+  case IRInst::Store:
+    return makeInst<Store>(*static_cast<const Store *>(inst));
+  case IRInst::Load:
+    return makeInst<Load>(*static_cast<const Load *>(inst));
+  case IRInst::Alloca:
+    return makeInst<Alloca>(*static_cast<const Alloca *>(inst));
+  case IRInst::Malloc:
+    return makeInst<Malloc>(*static_cast<const Malloc *>(inst));
+  case IRInst::Branch:
+    return makeInst<Branch>(*static_cast<const Branch *>(inst));
+  case IRInst::Jump:
+    return makeInst<Jump>(*static_cast<const Jump *>(inst));
+  case IRInst::Ret:
+    return makeInst<Ret>(*static_cast<const Ret *>(inst));
+  case IRInst::Call:
+    return makeInst<Call>(*static_cast<const Call *>(inst));
+  case IRInst::Phi:
+    return makeInst<Phi>(*static_cast<const Phi *>(inst));
+  }
+  assert(false);
+}
+
+IRInst *FunctionModule::cloneInst(const IRInst *inst,
+                                  const RegMap<std::shared_ptr<Addr>> &regs,
+                                  const LabelMap<std::size_t> &labels) {
+  // The clone is not linked yet, hence it can be modified in place.
+  auto res = cloneInst(inst);
+  for (std::size_t i = 0, n = res->getNumOperands(); i < n; ++i) {
+    auto &operand = res->operandAt(i);
+    auto reg = std::dynamic_pointer_cast<Reg>(operand);
+    if (!reg)
+      continue;
+    auto iter = regs.find(reg);
+    if (iter != regs.end())
+      operand = iter->second;
+  }
+  if (auto def = dynamic_cast<Definition *>(res)) {
+    auto iter = def->dest ? regs.find(def->dest) : regs.end();
+    if (iter != regs.end()) {
+      def->dest = std::dynamic_pointer_cast<Reg>(iter->second);
+      assert(def->dest);
+    }
+  }
+  for (std::size_t i = 0, n = res->getNumLabels(); i < n; ++i) {
+    auto &label = res->labelAt(i);
+    auto iter = labels.find(label->getID());
+    if (iter != labels.end())
+      label = std::make_shared<Label>(iter->second);
+  }
+  return res;
+}
+
+LabelMap<std::size_t>
+FunctionModule::cloneBBsAfter(BBLIter pos, const FunctionModule &other,
+                              const RegMap<std::shared_ptr<Addr>> &regs) {
+  assert(&other != this);
+  // Create all the blocks first, so that the labels can be remapped.
+  LabelMap<std::size_t> labels;
+  auto iter = pos;
+  for (auto &bb : other.bbs) {
+    iter = insertBBAfter(iter);
+    labels[bb.getLabelID()] = iter->getLabelID();
+  }
+  iter = pos;
+  for (auto &bb : other.bbs) {
+    ++iter;
+    for (auto inst : bb.insts)
+      iter->insts.push_back(cloneInst(inst, regs, labels));
+  }
+  return labels;
+}
+
+void FunctionModule::markModified() { epoch = newEpoch(); }
 
 BBLIter FunctionModule::pushBackBB() {
-  bbs.emplace_back(bbsSz++);
+  markModified();
+  bbs.emplace_back(bbsSz++, this);
+  attachBB(bbs.back());
   return --bbs.end();
 }
 
 BBLIter FunctionModule::insertBBAfter(BBLIter iter) {
   assert(iter != bbs.end());
   ++iter;
-  return bbs.emplace(iter, bbsSz++);
+  markModified();
+  auto res = bbs.emplace(iter, bbsSz++, this);
+  attachBB(*res);
+  return res;
 }
 
-void FunctionModule::buildContext() {
-  bbMap.clear();
+BBLIter FunctionModule::eraseBB(BBLIter iter) {
+  markModified();
+  detachBB(*iter);
+  return bbs.erase(iter);
+}
 
-  bbMap.reserve(bbs.size());
-  for (auto &bb : bbs)
-    bbMap.emplace(bb.getLabelID(), bb);
+void FunctionModule::removeBBIf(
+    const std::function<bool(const BasicBlock &)> &condition) {
+  for (auto iter = bbs.begin(); iter != bbs.end();) {
+    if (condition(*iter))
+      iter = eraseBB(iter);
+    else
+      ++iter;
+  }
+}
 
-  for (auto &bb : bbs)
-    predecessors[bb.getLabelID()] = {};
+void FunctionModule::moveBB(BBLIter pos, BBLIter iter) {
+  markModified();
+  bbs.splice(pos, bbs, iter);
+}
+
+void FunctionModule::attachBB(BasicBlock &bb) {
+  bbMap[bb.getLabelID()] = &bb;
+  predecessors[bb.getLabelID()]; // may have been created by a jump to it
+  assert(bb.succs.empty());
+  for (auto inst : bb.insts)
+    addUses(inst);
+}
+
+void FunctionModule::detachBB(BasicBlock &bb) {
+  for (auto inst : bb.insts)
+    removeUses(inst);
+  updateEdges(bb.getLabelID(), bb.succs, {});
+  bb.succs.clear();
+  bb.func = nullptr;
+  bbMap.erase(bb.getLabelID());
+  predecessors.erase(bb.getLabelID());
+}
+
+void FunctionModule::updateEdges(std::size_t from,
+                                 const std::vector<std::size_t> &oldSuccs,
+                                 const std::vector<std::size_t> &newSuccs) {
+  for (auto to : oldSuccs) {
+    auto iter = predecessors.find(to);
+    if (iter == predecessors.end()) // [to] has been removed
+      continue;
+    auto &preds = iter->second;
+    auto pos = std::find(preds.begin(), preds.end(), from);
+    assert(pos != preds.end());
+    preds.erase(pos);
+  }
+  for (auto to : newSuccs)
+    predecessors[to].emplace_back(from);
+}
+
+const std::vector<Use> &
+FunctionModule::getUses(const std::shared_ptr<Reg> &reg) const {
+  assert(asOwnReg(reg.get()) && "the register comes from another table");
+  static const std::vector<Use> Empty;
+  return reg->getID() < uses.size() ? uses[reg->getID()] : Empty;
+}
+
+void FunctionModule::setOperand(IRInst *inst, std::size_t idx,
+                                std::shared_ptr<Addr> operand) {
+  assert(idx < inst->getNumOperands());
+  auto &slot = inst->operandAt(idx);
+  if (inst->usesRecorded) {
+    removeUse(slot, {inst, idx});
+    addUse(operand, {inst, idx});
+  }
+  slot = std::move(operand);
+  markModified();
+}
+
+std::size_t
+FunctionModule::replaceAllUsesWith(const std::shared_ptr<Reg> &reg,
+                                   const std::shared_ptr<Addr> &operand) {
+  assert(asOwnReg(reg.get()) && "the register comes from another table");
+  if (reg == operand || reg->getID() >= uses.size() ||
+      uses[reg->getID()].empty())
+    return 0;
+  auto oldUses = std::move(uses[reg->getID()]);
+  uses[reg->getID()].clear();
+  for (auto &use : oldUses) {
+    use.user->operandAt(use.idx) = operand;
+    addUse(operand, use);
+  }
+  markModified();
+  return oldUses.size();
+}
+
+const Reg *FunctionModule::asOwnReg(const Addr *addr) const {
+  auto reg = dynamic_cast<const Reg *>(addr);
+  if (!reg || reg->getID() >= regTable.size() ||
+      regTable.at(reg->getID()).get() != reg)
+    return nullptr;
+  return reg;
+}
+
+void FunctionModule::addUses(IRInst *inst) {
+  assert(!inst->usesRecorded && "the instruction is in another block");
+  inst->usesRecorded = true;
+  for (std::size_t i = 0, n = inst->getNumOperands(); i < n; ++i)
+    addUse(inst->operandAt(i), {inst, i});
+}
+
+void FunctionModule::removeUses(IRInst *inst) {
+  assert(inst->usesRecorded);
+  inst->usesRecorded = false;
+  for (std::size_t i = 0, n = inst->getNumOperands(); i < n; ++i)
+    removeUse(inst->operandAt(i), {inst, i});
+}
+
+void FunctionModule::addUse(const std::shared_ptr<Addr> &operand, Use use) {
+  auto reg = asOwnReg(operand.get());
+  if (!reg)
+    return;
+  if (reg->getID() >= uses.size())
+    uses.resize(reg->getID() + 1);
+  uses[reg->getID()].emplace_back(use);
+}
+
+void FunctionModule::removeUse(const std::shared_ptr<Addr> &operand,
+                               Use use) {
+  auto reg = asOwnReg(operand.get());
+  if (!reg)
+    return;
+  auto &regUses = uses.at(reg->getID());
+  auto iter = std::find_if(regUses.begin(), regUses.end(),
+                           [&use](const Use &u) {
+                             return u.user == use.user && u.idx == use.idx;
+                           });
+  assert(iter != regUses.end());
+  *iter = regUses.back();
+  regUses.pop_back();
+}
+
+void FunctionModule::checkContext() const {
+  LabelMap<std::vector<std::size_t>> preds;
   for (auto &bb : bbs) {
-    for (auto succ : bb.getSuccessors())
-      predecessors[succ].emplace_back(bb.getLabelID());
+    assert(bb.func == this);
+    assert(bbMap.count(bb.getLabelID()) && bbMap.at(bb.getLabelID()) == &bb &&
+           "stale label-to-block map");
+    assert(bb.succs == computeSuccessors(bb.insts) && "stale successors");
+    preds[bb.getLabelID()];
+    for (auto succ : bb.succs)
+      preds[succ].emplace_back(bb.getLabelID());
+  }
+  assert(bbMap.size() == bbs.size() && "stale label-to-block map");
+  assert(preds.size() == predecessors.size() && "stale predecessors");
+  for (auto &kv : preds) {
+    auto expected = kv.second;
+    auto actual = predecessors.at(kv.first);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    assert(expected == actual && "stale predecessors");
   }
 
+  std::vector<std::vector<Use>> expectedUses(uses.size());
   for (auto &bb : bbs) {
-    if (predecessors[bb.getLabelID()].empty()) {
-      std::swap(bb, bbs.front());
-      break;
+    for (auto inst : bb.insts) {
+      assert(inst->usesRecorded);
+      for (std::size_t i = 0; i < inst->getNumOperands(); ++i) {
+        auto reg = asOwnReg(inst->getOperand(i).get());
+        if (!reg)
+          continue;
+        assert(reg->getID() < uses.size() && "stale uses");
+        expectedUses[reg->getID()].push_back({inst, i});
+      }
     }
   }
+  auto less = [](const Use &lhs, const Use &rhs) {
+    return std::less<IRInst *>()(lhs.user, rhs.user) ||
+           (lhs.user == rhs.user && lhs.idx < rhs.idx);
+  };
+  auto same = [](const Use &lhs, const Use &rhs) {
+    return lhs.user == rhs.user && lhs.idx == rhs.idx;
+  };
+  for (std::size_t id = 0; id < uses.size(); ++id) {
+    auto expected = expectedUses[id];
+    auto actual = uses[id];
+    std::sort(expected.begin(), expected.end(), less);
+    std::sort(actual.begin(), actual.end(), less);
+    assert(expected.size() == actual.size() &&
+           std::equal(expected.begin(), expected.end(), actual.begin(),
+                      same) &&
+           "stale uses");
+  }
 }
 
 const BasicBlock &FunctionModule::getBasicBlock(std::size_t labelID) const {
-  return bbMap.at(labelID);
+  return *bbMap.at(labelID);
 }
 
 BasicBlock &FunctionModule::getMutableBasicBlock(std::size_t labelID) {
-  return bbMap.at(labelID);
+  return *bbMap.at(labelID);
 }
 
 std::vector<std::size_t> FunctionModule::getPredcessors(std::size_t bb) const {
@@ -101,15 +481,81 @@ std::vector<std::size_t> FunctionModule::getPredcessors(std::size_t bb) const {
 }
 
 std::shared_ptr<Reg> FunctionModule::makeTempLocalReg(const std::string &hint) {
-  return std::make_shared<Reg>(hint + "_" + std::to_string(tempRegCounter++));
+  return makeReg(hint + "_" + std::to_string(tempRegCounter++));
 }
 
 void FunctionModule::sortBasicBlocks() {
+  markModified();
   bbs.sort([](const BasicBlock &lhs, const BasicBlock &rhs) {
     return lhs.getLabelID() < rhs.getLabelID();
   });
 }
 
+void FunctionModule::renumberBasicBlocks() {
+  std::vector<std::size_t> newLabel(bbsSz, (std::size_t)-1);
+  std::size_t cnt = 0;
+  bool isDense = true;
+  for (auto &bb : bbs) {
+    isDense &= bb.getLabelID() == cnt;
+    newLabel.at(bb.getLabelID()) = cnt++;
+  }
+  if (isDense) {
+    bbsSz = cnt;
+    return;
+  }
+  markModified();
+
+  std::vector<std::shared_ptr<Label>> labels;
+  labels.reserve(cnt);
+  for (std::size_t i = 0; i < cnt; ++i)
+    labels.emplace_back(std::make_shared<Label>(i));
+  auto relabel = [&newLabel, &labels](const std::shared_ptr<Label> &label) {
+    return labels.at(newLabel.at(label->getID()));
+  };
+
+  // The successors are updated by the blocks themselves, while the rest of
+  // the context is remapped afterward.
+  LabelMap<BasicBlock *> newBBMap;
+  LabelMap<std::vector<std::size_t>> newPreds;
+  for (auto &bb : bbs) {
+    auto label = newLabel[bb.getLabelID()];
+    newBBMap[label] = &bb;
+    auto &preds = newPreds[label];
+    for (auto pred : predecessors.at(bb.getLabelID()))
+      preds.emplace_back(newLabel.at(pred));
+  }
+
+  for (auto &bb : bbs) {
+    bb.labelID = newLabel[bb.getLabelID()];
+    bb.func = nullptr;
+    auto &insts = bb.getMutableInsts();
+    for (auto iter = insts.begin(); iter != insts.end(); ++iter) {
+      IRInst *newInst = nullptr;
+      if (auto p = dyc<Jump>(*iter)) {
+        newInst = makeInst<Jump>(relabel(p->getLabel()));
+      } else if (auto p = dyc<Branch>(*iter)) {
+        newInst = makeInst<Branch>(p->getCondition(), relabel(p->getThen()),
+                                   relabel(p->getElse()));
+      } else if (auto p = dyc<Phi>(*iter)) {
+        auto options = p->getOptions();
+        for (auto &option : options)
+          option.second = relabel(option.second);
+        newInst = makeInst<Phi>(p->getDest(), std::move(options));
+      }
+      if (newInst) {
+        // [bb] is detached temporarily, hence the uses are updated here.
+        removeUses(*iter);
+        iter = insts.replace(iter, newInst);
+        addUses(newInst);
+      }
+    }
+    bb.func = this;
+  }
+  bbsSz = cnt;
+  bbMap = std::move(newBBMap);
+  predecessors = std::move(newPreds);
+}
+
 FunctionModule &Module::addFunc(std::string ident, FunctionModule func) {
   auto p = funcs.emplace(std::move(ident), std::move(func));
   assert(p.second);
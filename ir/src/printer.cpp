@@ -21,7 +21,14 @@ std::string fmtAddr(const std::shared_ptr<Addr> &addr) {
   assert(false);
 }
 
-std::string fmtInst(const std::shared_ptr<IRInst> &inst) {
+namespace {
+
+// The default width of 8 bytes is omitted.
+std::string fmtWidth(std::size_t width) { return width == 1 ? "byte " : ""; }
+
+} // namespace
+
+std::string fmtInst(const IRInst *inst) {
   using namespace std::string_literals;
 
   if (dyc<Deleted>(inst)) {
@@ -43,10 +50,12 @@ std::string fmtInst(const std::shared_ptr<IRInst> &inst) {
     return fmtAddr(p->getDest()) + " = malloc " + fmtAddr(p->getSize());
   }
   if (auto p = dyc<Store>(inst)) {
-    return "store " + fmtAddr(p->getAddr()) + " " + fmtAddr(p->getVal());
+    return "store " + fmtWidth(p->getWidth()) + fmtAddr(p->getAddr()) + " " +
+           fmtAddr(p->getVal());
   }
   if (auto p = dyc<Load>(inst)) {
-    return fmtAddr(p->getDest()) + " = load " + fmtAddr(p->getAddr());
+    return fmtAddr(p->getDest()) + " = load " + fmtWidth(p->getWidth()) +
+           fmtAddr(p->getAddr());
   }
   if (auto p = dyc<Branch>(inst)) {
     return "br " + fmtAddr(p->getCondition()) + " " + fmtAddr(p->getThen()) +
@@ -123,7 +132,7 @@ void printFunc(const FunctionModule &func, std::ostream &out) {
   out << " {\n";
   for (const auto &bb : func.getBBs()) {
     out << "<" << bb.getLabelID() << ">:\n";
-    for (const auto &inst : bb.getInsts()) {
+    for (auto inst : bb.getInsts()) {
       if (auto p = dyc<AttachedComment>(inst)) {
         attachedComment = p->getContent();
         continue;
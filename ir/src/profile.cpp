@@ -0,0 +1,117 @@
+#include "profile.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace mocker {
+namespace ir {
+
+const FuncProfile *Profile::findFunc(const FunctionModule &func) const {
+  auto iter = funcs.find(func.getIdentifier());
+  if (iter == funcs.end() ||
+      iter->second.checksum != computeCfgChecksum(func))
+    return nullptr;
+  return &iter->second;
+}
+
+std::uint64_t Profile::countCalls(const std::string &callee) const {
+  std::uint64_t res = 0;
+  for (auto &kv : funcs) {
+    for (auto &site : kv.second.callSites) {
+      if (site.callee == callee)
+        res += site.count;
+    }
+  }
+  return res;
+}
+
+std::uint64_t hashBlock(std::size_t label,
+                        const std::vector<std::size_t> &succs) {
+  // FNV-1a
+  std::uint64_t res = 14695981039346656037ull;
+  auto mix = [&res](std::uint64_t val) {
+    for (int i = 0; i < 8; ++i) {
+      res ^= (val >> (i * 8)) & 0xff;
+      res *= 1099511628211ull;
+    }
+  };
+  mix(label);
+  for (auto succ : succs)
+    mix(succ);
+  return res;
+}
+
+std::uint64_t computeCfgChecksum(const FunctionModule &func) {
+  std::uint64_t res = 0;
+  for (auto &bb : func.getBBs())
+    res += hashBlock(bb.getLabelID(), bb.getSuccessors());
+  return res;
+}
+
+void printProfile(const Profile &profile, std::ostream &out) {
+  for (auto &kv : profile.getFuncs()) {
+    auto &func = kv.second;
+    out << "function " << kv.first << ' ' << func.checksum << ' '
+        << func.calls << ' ' << func.insts << '\n';
+    for (auto &block : func.blocks)
+      out << "block " << block.first << ' ' << block.second << '\n';
+    for (auto &edge : func.edges)
+      out << "edge " << edge.first.first << ' ' << edge.first.second << ' '
+          << edge.second << '\n';
+    for (auto &site : func.callSites)
+      out << "call " << site.bb << ' ' << site.idx << ' ' << site.callee << ' '
+          << site.count << '\n';
+    out << "end\n";
+  }
+}
+
+Profile readProfile(std::istream &in) {
+  Profile res;
+  FuncProfile *cur = nullptr;
+  std::string line;
+  auto error = [](const std::string &line) {
+    return std::runtime_error("malformed profile: " + line);
+  };
+  while (std::getline(in, line)) {
+    if (line.empty())
+      continue;
+    std::istringstream ss(line);
+    std::string kind;
+    ss >> kind;
+    if (kind == "function") {
+      std::string ident;
+      ss >> ident;
+      cur = &res.getFunc(ident);
+      ss >> cur->checksum >> cur->calls >> cur->insts;
+    } else if (kind == "end") {
+      cur = nullptr;
+      continue;
+    } else if (!cur) {
+      throw error(line);
+    } else if (kind == "block") {
+      std::size_t label;
+      std::uint64_t count;
+      ss >> label >> count;
+      cur->blocks[label] = count;
+    } else if (kind == "edge") {
+      std::size_t from, to;
+      std::uint64_t count;
+      ss >> from >> to >> count;
+      cur->edges[{from, to}] = count;
+    } else if (kind == "call") {
+      CallSiteProfile site;
+      ss >> site.bb >> site.idx >> site.callee >> site.count;
+      cur->callSites.emplace_back(std::move(site));
+    } else {
+      throw error(line);
+    }
+    if (ss.fail())
+      throw error(line);
+  }
+  if (cur)
+    throw error("missing end");
+  return res;
+}
+
+} // namespace ir
+} // namespace mocker
@@ -0,0 +1,21 @@
+#include "reg_table.h"
+
+namespace mocker {
+namespace ir {
+
+const std::shared_ptr<Reg> &RegTable::get(const std::string &identifier) {
+  auto res = ids.emplace(identifier, regs.size());
+  if (res.second)
+    regs.emplace_back(new Reg(regs.size(), identifier));
+  return regs[res.first->second];
+}
+
+std::shared_ptr<Reg> RegTable::find(const std::string &identifier) const {
+  auto iter = ids.find(identifier);
+  if (iter == ids.end())
+    return nullptr;
+  return regs[iter->second];
+}
+
+} // namespace ir
+} // namespace mocker
@@ -0,0 +1,538 @@
+#include "serialize.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "helper.h"
+
+namespace mocker {
+namespace ir {
+namespace {
+
+using namespace binary;
+
+constexpr std::size_t Alignment = 8;
+
+std::size_t alignUp(std::size_t n) {
+  return (n + Alignment - 1) / Alignment * Alignment;
+}
+
+class Serializer {
+public:
+  explicit Serializer(const Module &module) {
+    for (auto &var : module.getGlobalVars())
+      vars.push_back(
+          {internString(var.getLabel()), internString(var.getData())});
+    for (auto &kv : module.getFuncs())
+      addFunc(kv.second);
+  }
+
+  void write(std::ostream &out) const {
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.numSections = NumSections;
+
+    std::size_t offset = alignUp(sizeof(Header));
+    auto layout = [&offset, &header](SectionKind kind, std::size_t size,
+                                     std::size_t recordSize) {
+      header.sections[kind] = {offset, size};
+      offset = alignUp(offset + size * recordSize);
+    };
+    layout(Strings, strOffsets.size(), sizeof(std::uint32_t));
+    layout(Chars, chars.size(), 1);
+    layout(Vars, vars.size(), sizeof(VarRecord));
+    layout(Funcs, funcs.size(), sizeof(FuncRecord));
+    layout(Args, args.size(), sizeof(std::uint32_t));
+    layout(Regs, regs.size(), sizeof(std::uint32_t));
+    layout(Blocks, blocks.size(), sizeof(BlockRecord));
+    layout(Insts, insts.size(), sizeof(InstRecord));
+    layout(Operands, operands.size(), sizeof(OperandRecord));
+
+    std::size_t written = 0;
+    auto writeBytes = [&out, &written](const void *bytes, std::size_t n) {
+      out.write(static_cast<const char *>(bytes), n);
+      static const char Padding[Alignment] = {};
+      out.write(Padding, alignUp(n) - n);
+      written += alignUp(n);
+    };
+    auto writeSection = [&writeBytes](const auto &records) {
+      writeBytes(records.data(), records.size() * sizeof(records[0]));
+    };
+    writeBytes(&header, sizeof(header));
+    writeSection(strOffsets);
+    writeBytes(chars.data(), chars.size());
+    writeSection(vars);
+    writeSection(funcs);
+    writeSection(args);
+    writeSection(regs);
+    writeSection(blocks);
+    writeSection(insts);
+    writeSection(operands);
+    assert(written == offset);
+  }
+
+private:
+  std::uint32_t internString(const std::string &str) {
+    auto res = stringIDs.emplace(str, (std::uint32_t)stringIDs.size());
+    if (res.second) {
+      chars += str;
+      strOffsets.emplace_back((std::uint32_t)chars.size());
+    }
+    return res.first->second;
+  }
+
+  void addFunc(const FunctionModule &func) {
+    FuncRecord res;
+    res.identifier = internString(func.getIdentifier());
+    res.flags = func.isExternalFunc() ? FuncRecord::External : 0;
+    res.tempRegCounter = func.getTempRegCounter();
+
+    res.args.first = (std::uint32_t)args.size();
+    for (auto &arg : func.getArgs())
+      args.emplace_back(internString(arg));
+    res.args.size = (std::uint32_t)(args.size() - res.args.first);
+
+    curRegs = &func.getRegTable();
+    res.regs.first = (std::uint32_t)regs.size();
+    for (std::size_t id = 0; id < curRegs->size(); ++id)
+      regs.emplace_back(internString(curRegs->at(id)->getIdentifier()));
+    res.regs.size = (std::uint32_t)curRegs->size();
+
+    // Relabel the blocks densely.
+    newLabels.clear();
+    for (auto &bb : func.getBBs())
+      newLabels.emplace(bb.getLabelID(), (std::uint32_t)newLabels.size());
+
+    res.blocks.first = (std::uint32_t)blocks.size();
+    for (auto &bb : func.getBBs()) {
+      BlockRecord block;
+      block.label = newLabels.at(bb.getLabelID());
+      block.insts.first = (std::uint32_t)insts.size();
+      for (auto inst : bb.getInsts())
+        addInst(inst);
+      block.insts.size = (std::uint32_t)(insts.size() - block.insts.first);
+      blocks.emplace_back(block);
+    }
+    res.blocks.size = (std::uint32_t)(blocks.size() - res.blocks.first);
+
+    funcs.emplace_back(res);
+  }
+
+  void addInst(const IRInst *inst) {
+    InstRecord res;
+    res.type = (std::uint16_t)inst->getInstType();
+    res.op = 0;
+    res.str = 0;
+    res.operands.first = (std::uint32_t)operands.size();
+
+    if (auto p = dynamic_cast<const Definition *>(inst))
+      addOperand(p->getDest());
+
+    if (auto p = dyc<Comment>(inst)) {
+      res.str = internString(p->getContent());
+    } else if (auto p = dyc<AttachedComment>(inst)) {
+      res.str = internString(p->getContent());
+    } else if (auto p = dyc<Assign>(inst)) {
+      addOperand(p->getOperand());
+    } else if (auto p = dyc<ArithUnaryInst>(inst)) {
+      res.op = (std::uint16_t)p->getOp();
+      addOperand(p->getOperand());
+    } else if (auto p = dyc<ArithBinaryInst>(inst)) {
+      res.op = (std::uint16_t)p->getOp();
+      addOperand(p->getLhs());
+      addOperand(p->getRhs());
+    } else if (auto p = dyc<RelationInst>(inst)) {
+      res.op = (std::uint16_t)p->getOp();
+      addOperand(p->getLhs());
+      addOperand(p->getRhs());
+    } else if (auto p = dyc<Store>(inst)) {
+      res.op = (std::uint16_t)p->getWidth();
+      addOperand(p->getAddr());
+      addOperand(p->getVal());
+    } else if (auto p = dyc<Load>(inst)) {
+      res.op = (std::uint16_t)p->getWidth();
+      addOperand(p->getAddr());
+    } else if (auto p = dyc<Malloc>(inst)) {
+      addOperand(p->getSize());
+    } else if (auto p = dyc<Branch>(inst)) {
+      addOperand(p->getCondition());
+      addOperand(p->getThen());
+      addOperand(p->getElse());
+    } else if (auto p = dyc<Jump>(inst)) {
+      addOperand(p->getLabel());
+    } else if (auto p = dyc<Ret>(inst)) {
+      if (p->getVal())
+        addOperand(p->getVal());
+    } else if (auto p = dyc<Call>(inst)) {
+      res.str = internString(p->getFuncName());
+      for (auto &arg : p->getArgs())
+        addOperand(arg);
+    } else if (auto p = dyc<Phi>(inst)) {
+      for (auto &option : p->getOptions()) {
+        addOperand(option.first);
+        addOperand(option.second);
+      }
+    }
+
+    res.operands.size = (std::uint32_t)(operands.size() - res.operands.first);
+    insts.emplace_back(res);
+  }
+
+  void addOperand(const std::shared_ptr<Addr> &addr) {
+    OperandRecord res;
+    res.kind = OperandRecord::Absent;
+    res.id = 0;
+    res.val = 0;
+    if (auto p = dyc<IntLiteral>(addr)) {
+      res.kind = OperandRecord::IntLiteral;
+      res.val = p->getVal();
+    } else if (auto p = dyc<Reg>(addr)) {
+      assert(curRegs->at(p->getID()) == p &&
+             "the register comes from another table");
+      res.kind = OperandRecord::Register;
+      res.id = (std::uint32_t)p->getID();
+    } else if (auto p = dyc<Label>(addr)) {
+      res.kind = OperandRecord::Label;
+      res.id = newLabels.at(p->getID());
+    } else {
+      assert(!addr);
+    }
+    operands.emplace_back(res);
+  }
+
+  std::unordered_map<std::string, std::uint32_t> stringIDs;
+  std::vector<std::uint32_t> strOffsets{0};
+  std::string chars;
+  std::vector<VarRecord> vars;
+  std::vector<FuncRecord> funcs;
+  std::vector<std::uint32_t> args;
+  std::vector<std::uint32_t> regs;
+  std::vector<BlockRecord> blocks;
+  std::vector<InstRecord> insts;
+  std::vector<OperandRecord> operands;
+
+  // of the function being serialized
+  const RegTable *curRegs = nullptr;
+  LabelMap<std::uint32_t> newLabels;
+};
+
+// Whether the operands of [inst] are of the kinds and the number its type
+// requires, and whether its [op] is in range.
+bool isWellFormed(const InstRecord &inst,
+                  const Slice<OperandRecord> &operands) {
+  auto kindOf = [&operands](std::size_t idx) { return operands[idx].kind; };
+  auto isReg = [&kindOf](std::size_t idx) {
+    return kindOf(idx) == OperandRecord::Register;
+  };
+  auto isLabel = [&kindOf](std::size_t idx) {
+    return kindOf(idx) == OperandRecord::Label;
+  };
+  auto isValue = [&kindOf](std::size_t idx) {
+    return kindOf(idx) == OperandRecord::Register ||
+           kindOf(idx) == OperandRecord::IntLiteral;
+  };
+  auto size = operands.size();
+  auto isWidth = inst.op == 1 || inst.op == 8;
+
+  switch (inst.type) {
+  case IRInst::Deleted:
+  case IRInst::Comment:
+  case IRInst::AttachedComment:
+    return size == 0;
+  case IRInst::Assign:
+    return size == 2 && isReg(0) && isValue(1);
+  case IRInst::ArithUnaryInst:
+    return size == 2 && isReg(0) && isValue(1) &&
+           inst.op <= ArithUnaryInst::BitNot;
+  case IRInst::ArithBinaryInst:
+    return size == 3 && isReg(0) && isValue(1) && isValue(2) &&
+           inst.op <= ArithBinaryInst::Mod;
+  case IRInst::RelationInst:
+    return size == 3 && isReg(0) && isValue(1) && isValue(2) &&
+           inst.op <= RelationInst::Ge;
+  case IRInst::Store:
+    return size == 2 && isValue(0) && isValue(1) && isWidth;
+  case IRInst::Load:
+    return size == 2 && isReg(0) && isValue(1) && isWidth;
+  case IRInst::Alloca:
+    return size == 1 && isReg(0);
+  case IRInst::Malloc:
+    return size == 2 && isReg(0) && isValue(1);
+  case IRInst::Branch:
+    return size == 3 && isValue(0) && isLabel(1) && isLabel(2);
+  case IRInst::Jump:
+    return size == 1 && isLabel(0);
+  case IRInst::Ret:
+    return size == 0 || (size == 1 && isValue(0));
+  case IRInst::Call:
+    if (size == 0 || (!isReg(0) && kindOf(0) != OperandRecord::Absent))
+      return false;
+    for (std::size_t i = 1; i < size; ++i) {
+      if (!isValue(i))
+        return false;
+    }
+    return true;
+  case IRInst::Phi:
+    if (size % 2 == 0 || !isReg(0))
+      return false;
+    for (std::size_t i = 1; i < size; i += 2) {
+      if (!isValue(i) || !isLabel(i + 1))
+        return false;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+std::shared_ptr<Addr> makeAddr(const OperandRecord &operand,
+                               const std::vector<std::shared_ptr<Reg>> &regs) {
+  switch (operand.kind) {
+  case OperandRecord::Absent:
+    return nullptr;
+  case OperandRecord::Register:
+    return regs.at(operand.id);
+  case OperandRecord::IntLiteral:
+    return std::make_shared<ir::IntLiteral>(operand.val);
+  case OperandRecord::Label:
+    return std::make_shared<ir::Label>(operand.id);
+  default:
+    break;
+  }
+  // Rejected by validate()
+  throw std::runtime_error("Corrupted serialized module");
+}
+
+IRInst *makeInst(FunctionModule &func, const SerializedModule &serialized,
+                 const InstRecord &inst,
+                 const std::vector<std::shared_ptr<Reg>> &regs) {
+  auto operands = serialized.getOperands(inst);
+  auto addr = [&operands, &regs](std::size_t idx) {
+    return makeAddr(operands[idx], regs);
+  };
+  auto reg = [&addr](std::size_t idx) {
+    return std::static_pointer_cast<Reg>(addr(idx));
+  };
+  auto label = [&addr](std::size_t idx) {
+    return std::static_pointer_cast<ir::Label>(addr(idx));
+  };
+
+  switch (inst.type) {
+  case IRInst::Deleted:
+    return func.makeInst<Deleted>();
+  case IRInst::Comment:
+    return func.makeInst<Comment>(serialized.getStdString(inst.str));
+  case IRInst::AttachedComment:
+    return func.makeInst<AttachedComment>(serialized.getStdString(inst.str));
+  case IRInst::Assign:
+    return func.makeInst<Assign>(reg(0), addr(1));
+  case IRInst::ArithUnaryInst:
+    return func.makeInst<ArithUnaryInst>(
+        reg(0), (ArithUnaryInst::OpType)inst.op, addr(1));
+  case IRInst::ArithBinaryInst:
+    return func.makeInst<ArithBinaryInst>(
+        reg(0), (ArithBinaryInst::OpType)inst.op, addr(1), addr(2));
+  case IRInst::RelationInst:
+    return func.makeInst<RelationInst>(reg(0), (RelationInst::OpType)inst.op,
+                                       addr(1), addr(2));
+  case IRInst::Store:
+    return func.makeInst<Store>(addr(0), addr(1), inst.op);
+  case IRInst::Load:
+    return func.makeInst<Load>(reg(0), addr(1), inst.op);
+  case IRInst::Alloca:
+    return func.makeInst<Alloca>(reg(0));
+  case IRInst::Malloc:
+    return func.makeInst<Malloc>(reg(0), addr(1));
+  case IRInst::Branch:
+    return func.makeInst<Branch>(addr(0), label(1), label(2));
+  case IRInst::Jump:
+    return func.makeInst<Jump>(label(0));
+  case IRInst::Ret:
+    return func.makeInst<Ret>(operands.empty() ? nullptr : addr(0));
+  case IRInst::Call: {
+    std::vector<std::shared_ptr<Addr>> args;
+    args.reserve(operands.size() - 1);
+    for (std::size_t i = 1; i < operands.size(); ++i)
+      args.emplace_back(addr(i));
+    return func.makeInst<Call>(reg(0), serialized.getStdString(inst.str),
+                               std::move(args));
+  }
+  case IRInst::Phi: {
+    std::vector<Phi::Option> options;
+    options.reserve(operands.size() / 2);
+    for (std::size_t i = 1; i + 1 < operands.size(); i += 2)
+      options.emplace_back(addr(i), label(i + 1));
+    return func.makeInst<Phi>(reg(0), std::move(options));
+  }
+  default:
+    break;
+  }
+  // Rejected by validate()
+  throw std::runtime_error("Corrupted serialized module");
+}
+
+} // namespace
+
+void serializeModule(const Module &module, std::ostream &out) {
+  Serializer(module).write(out);
+}
+
+bool isSerializedModule(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(Magic)];
+  if (!in.read(magic, sizeof(magic)))
+    return false;
+  return std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+SerializedModule::SerializedModule(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    throw std::runtime_error("Can't open " + path);
+  struct stat st;
+  if (::fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error(path + " is not a serialized module");
+  }
+  sz = (std::size_t)st.st_size;
+  auto addr = ::mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error("Can't map " + path);
+  data = static_cast<const char *>(addr);
+
+  try {
+    validate();
+  } catch (...) {
+    ::munmap(const_cast<char *>(data), sz);
+    throw;
+  }
+}
+
+SerializedModule::~SerializedModule() {
+  ::munmap(const_cast<char *>(data), sz);
+}
+
+std::pair<const char *, std::size_t>
+SerializedModule::getString(std::uint32_t id) const {
+  auto offsets = getSection<std::uint32_t>(Strings);
+  auto chars = getSection<char>(Chars);
+  return {chars.begin() + offsets[id], offsets[id + 1] - offsets[id]};
+}
+
+void SerializedModule::validate() const {
+  auto &header = getHeader();
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+    throw std::runtime_error("Not a serialized module");
+  if (header.version != Version || header.numSections != NumSections)
+    throw std::runtime_error("Unsupported version of serialized modules");
+
+  static const std::size_t RecordSizes[NumSections] = {
+      sizeof(std::uint32_t), 1, sizeof(VarRecord),
+      sizeof(FuncRecord), sizeof(std::uint32_t), sizeof(std::uint32_t),
+      sizeof(BlockRecord), sizeof(InstRecord), sizeof(OperandRecord)};
+  for (std::size_t kind = 0; kind < NumSections; ++kind) {
+    auto &section = header.sections[kind];
+    if (section.offset % Alignment != 0 || section.offset > sz ||
+        section.size > (sz - section.offset) / RecordSizes[kind])
+      throw std::runtime_error("Corrupted serialized module");
+  }
+
+  auto check = [](bool cond) {
+    if (!cond)
+      throw std::runtime_error("Corrupted serialized module");
+  };
+  auto checkRange = [&check](const Range &range, std::size_t bound) {
+    check((std::size_t)range.first + range.size <= bound);
+  };
+
+  auto offsets = getSection<std::uint32_t>(Strings);
+  check(!offsets.empty() && offsets[0] == 0);
+  for (std::size_t i = 1; i < offsets.size(); ++i)
+    check(offsets[i - 1] <= offsets[i]);
+  check(offsets[offsets.size() - 1] <= getSection<char>(Chars).size());
+  auto numStrs = numStrings();
+
+  for (auto &var : getVars())
+    check(var.label < numStrs && var.data < numStrs);
+  for (auto &func : getFuncs()) {
+    check(func.identifier < numStrs);
+    checkRange(func.args, getSection<std::uint32_t>(Args).size());
+    checkRange(func.regs, getSection<std::uint32_t>(Regs).size());
+    checkRange(func.blocks, getSection<BlockRecord>(Blocks).size());
+    for (auto str : getArgs(func))
+      check(str < numStrs);
+    for (auto str : getRegs(func))
+      check(str < numStrs);
+    std::uint32_t label = 0;
+    for (auto &block : getBlocks(func)) {
+      check(block.label == label++);
+      checkRange(block.insts, getSection<InstRecord>(Insts).size());
+      for (auto &inst : getInsts(block)) {
+        check(inst.str < numStrs);
+        checkRange(inst.operands, getSection<OperandRecord>(Operands).size());
+        for (auto &operand : getOperands(inst)) {
+          if (operand.kind == OperandRecord::Register)
+            check(operand.id < func.regs.size);
+          else if (operand.kind == OperandRecord::Label)
+            check(operand.id < func.blocks.size);
+          else
+            check(operand.kind == OperandRecord::Absent ||
+                  operand.kind == OperandRecord::IntLiteral);
+        }
+        check(isWellFormed(inst, getOperands(inst)));
+      }
+    }
+  }
+}
+
+Module deserializeModule(const SerializedModule &serialized) {
+  Module res;
+  for (auto &var : serialized.getVars())
+    res.addGlobalVar(serialized.getStdString(var.label),
+                     serialized.getStdString(var.data));
+
+  for (auto &rec : serialized.getFuncs()) {
+    auto ident = serialized.getStdString(rec.identifier);
+    std::vector<std::string> args;
+    for (auto str : serialized.getArgs(rec))
+      args.emplace_back(serialized.getStdString(str));
+    auto &func = res.addFunc(
+        ident, FunctionModule(ident, std::move(args),
+                              (rec.flags & FuncRecord::External) != 0));
+    func.setTempRegCounter(rec.tempRegCounter);
+
+    std::vector<std::shared_ptr<Reg>> regs;
+    for (auto str : serialized.getRegs(rec)) {
+      regs.emplace_back(func.makeReg(serialized.getStdString(str)));
+      assert(regs.back()->getID() == regs.size() - 1);
+    }
+
+    // Create all the blocks before any instruction refers to them.
+    auto blocks = serialized.getBlocks(rec);
+    for (auto &block : blocks) {
+      auto bb = func.pushBackBB();
+      assert(bb->getLabelID() == block.label);
+      (void)bb;
+    }
+    auto bbIter = func.getFirstBB();
+    for (auto &block : blocks) {
+      for (auto &inst : serialized.getInsts(block))
+        bbIter->appendInst(makeInst(func, serialized, inst, regs));
+      ++bbIter;
+    }
+  }
+  return res;
+}
+
+} // namespace ir
+} // namespace mocker
@@ -0,0 +1,68 @@
+#include "stats.h"
+
+#include <cassert>
+
+namespace mocker {
+namespace ir {
+
+const char *getInstTypeName(IRInst::InstType type) {
+  static const char *Names[NumInstTypes] = {
+      "Deleted", "Comment", "AttachedComment", "Assign",
+      "ArithUnaryInst", "ArithBinaryInst", "RelationInst", "Store",
+      "Load", "Alloca", "Malloc", "Branch",
+      "Jump", "Ret", "Call", "Phi"};
+  assert((std::size_t)type < NumInstTypes);
+  return Names[type];
+}
+
+std::size_t Histogram::countInsts() const {
+  std::size_t res = 0;
+  for (auto cnt : insts)
+    res += cnt;
+  return res;
+}
+
+Histogram &Histogram::operator+=(const Histogram &rhs) {
+  bbs += rhs.bbs;
+  for (std::size_t i = 0; i < NumInstTypes; ++i)
+    insts[i] += rhs.insts[i];
+  return *this;
+}
+
+Histogram buildHistogram(const FunctionModule &func) {
+  Histogram res;
+  for (auto &bb : func.getBBs()) {
+    ++res.bbs;
+    for (auto inst : bb.getInsts())
+      ++res.insts[inst->getInstType()];
+  }
+  return res;
+}
+
+Histogram buildHistogram(const Module &module) {
+  Histogram res;
+  for (auto &kv : module.getFuncs())
+    res += buildHistogram(kv.second);
+  return res;
+}
+
+void printHistogramJson(const Histogram &histogram, std::ostream &out) {
+  out << "{\"blocks\": " << histogram.bbs
+      << ", \"insts\": " << histogram.countInsts()
+      << ", \"phis\": " << histogram.countPhis()
+      << ", \"memOps\": " << histogram.countMemOps() << ", \"types\": {";
+  bool first = true;
+  for (std::size_t i = 0; i < NumInstTypes; ++i) {
+    if (histogram.insts[i] == 0)
+      continue;
+    if (!first)
+      out << ", ";
+    first = false;
+    out << '"' << getInstTypeName((IRInst::InstType)i)
+        << "\": " << histogram.insts[i];
+  }
+  out << "}}";
+}
+
+} // namespace ir
+} // namespace mocker
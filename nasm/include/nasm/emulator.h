@@ -0,0 +1,146 @@
+// Executes the subset of x86-64 emitted by the backend, so that the backend
+// can be measured without assembling. The module must be register-allocated.
+//
+// The emulated program lives in the address space of the emulator: the
+// sections and the heap are host buffers, and the stack is a host buffer of a
+// fixed size. The builtins of builtin/builtin.c are implemented natively and
+// reached through the System V calling convention. The flags are only set by
+// cmp, which is the only instruction whose flags the backend uses. A division
+// follows cdq and a 32-bit idiv, as the printer emits them.
+
+#ifndef MOCKER_NASM_EMULATOR_H
+#define MOCKER_NASM_EMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "module.h"
+
+namespace mocker {
+namespace nasm {
+
+struct EmulatorStats {
+  std::uint64_t insts = 0;
+  // Including the implicit ones of push, pop, call, ret and leave
+  std::uint64_t loads = 0, stores = 0;
+  // The accesses of the slots below rbp, i.e. the spilled registers
+  std::uint64_t spillLoads = 0, spillStores = 0;
+  std::uint64_t calls = 0, builtinCalls = 0;
+};
+
+class Emulator {
+public:
+  // Throw std::runtime_error if the module uses something not supported, such
+  // as a virtual register or an undefined label.
+  explicit Emulator(const Module &module);
+
+  // The builtins read from [in] and write to [out], which are std::cin and
+  // std::cout by default.
+  void redirect(std::istream &in, std::ostream &out) {
+    this->in = &in;
+    this->out = &out;
+  }
+
+  // Call main and return rax. Throw std::runtime_error on a stack overflow or
+  // a division error.
+  std::int64_t run();
+
+  const EmulatorStats &getStats() const { return stats; }
+
+private:
+  enum class Op {
+    Mov,
+    LoadByte,
+    StoreByte,
+    Lea,
+    Neg,
+    Not,
+    Inc,
+    Dec,
+    BitOr,
+    BitAnd,
+    Xor,
+    Add,
+    Sub,
+    Mul,
+    Sal,
+    Sar,
+    Cmp,
+    Set,
+    Jmp,
+    CJump,
+    Call,
+    CallBuiltin,
+    Ret,
+    Push,
+    Pop,
+    Leave,
+    Cqo,
+    IDiv
+  };
+
+  struct Operand {
+    enum Kind { None, Imm, Reg, Mem };
+    Kind kind = None;
+    // An immediate, or the displacement of a memory operand
+    std::int64_t val = 0;
+    int base = -1, index = -1, scale = 1;
+    bool spill = false;
+  };
+
+  using Builtin = std::int64_t (*)(Emulator &emu, const std::int64_t *args);
+
+  // [cond] is the condition of a Set or a CJump, and [target] is the index
+  // of the instruction jumped to or called.
+  struct Decoded {
+    Op op;
+    int cond = 0;
+    Operand dest, src;
+    std::size_t target = 0;
+    Builtin builtin = nullptr;
+  };
+
+  struct Builtins;
+
+  void layOut(const Section &section);
+
+  void decodeText(const Section &section);
+
+  Operand decodeOperand(const std::shared_ptr<Addr> &addr) const;
+
+  std::int64_t address(const Operand &operand) const;
+
+  std::int64_t read(const Operand &operand);
+
+  void write(const Operand &operand, std::int64_t val);
+
+  void push(std::int64_t val);
+
+  std::int64_t pop();
+
+  char *allocate(std::size_t size);
+
+  static constexpr std::size_t StackSize = 8 * 1024 * 1024;
+  static constexpr std::int64_t ReturnFromMain = -1;
+
+  std::vector<Decoded> insts;
+  std::size_t entry = 0;
+  std::unordered_map<std::string, std::int64_t> dataLabels;
+  std::vector<std::unique_ptr<char[]>> sections, heap;
+  std::unique_ptr<char[]> stack;
+  std::int64_t regs[16] = {};
+  std::int64_t flagLhs = 0, flagRhs = 0;
+  EmulatorStats stats;
+  std::istream *in = &std::cin;
+  std::ostream *out = &std::cout;
+};
+
+} // namespace nasm
+} // namespace mocker
+
+#endif // MOCKER_NASM_EMULATOR_H
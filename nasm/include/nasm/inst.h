@@ -45,17 +45,23 @@ struct InstPtrEqual {
 
 class Empty : public Inst {};
 
+// A move of [width] bytes, which is either 1 or 8. A single byte can only be
+// moved between a register and the memory. It is zero-extended when loaded.
 class Mov : public Inst {
 public:
-  Mov(std::shared_ptr<Addr> dest, std::shared_ptr<Addr> operand)
-      : dest(std::move(dest)), operand(std::move(operand)) {}
+  Mov(std::shared_ptr<Addr> dest, std::shared_ptr<Addr> operand,
+      std::size_t width = 8)
+      : dest(std::move(dest)), operand(std::move(operand)), width(width) {}
 
   const std::shared_ptr<Addr> getDest() const { return dest; }
 
   const std::shared_ptr<Addr> getOperand() const { return operand; }
 
+  std::size_t getWidth() const { return width; }
+
 private:
   std::shared_ptr<Addr> dest, operand;
+  std::size_t width;
 };
 
 class Lea : public Inst {
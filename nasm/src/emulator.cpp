@@ -0,0 +1,528 @@
+#include "emulator.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace mocker {
+namespace nasm {
+namespace {
+
+// R0  R1  R2  R3  R4  R5  R6  R7  R8  R9  R10  R11  R12  R13  R14  R15
+// RAX RCX RDX RBX RSP RBP RSI RDI
+enum { RAX = 0, RDX = 2, RSP = 4, RBP = 5, RSI = 6, RDI = 7 };
+
+int getRegIndex(const std::shared_ptr<Register> &reg) {
+  static const std::unordered_map<std::string, int> Indices{
+      {"rax", 0},  {"rcx", 1},  {"rdx", 2},  {"rbx", 3},
+      {"rsp", 4},  {"rbp", 5},  {"rsi", 6},  {"rdi", 7},
+      {"r8", 8},   {"r9", 9},   {"r10", 10}, {"r11", 11},
+      {"r12", 12}, {"r13", 13}, {"r14", 14}, {"r15", 15}};
+  auto iter = Indices.find(reg->getIdentifier());
+  if (iter == Indices.end())
+    throw std::runtime_error("not a physical register: " +
+                             reg->getIdentifier());
+  return iter->second;
+}
+
+std::int64_t load64(std::int64_t addr) {
+  std::int64_t res;
+  std::memcpy(&res, (const void *)addr, 8);
+  return res;
+}
+
+} // namespace
+
+// The builtins of builtin/builtin.c, with their arguments in rdi, rsi and rdx
+struct Emulator::Builtins {
+  static std::int64_t length(std::int64_t str) { return load64(str - 8); }
+
+  static std::int64_t makeString(Emulator &emu, const std::string &str) {
+    auto res = emu.allocate(8 + str.size());
+    auto len = (std::int64_t)str.size();
+    std::memcpy(res, &len, 8);
+    std::memcpy(res + 8, str.data(), str.size());
+    return (std::int64_t)(res + 8);
+  }
+
+  static std::int64_t alloc(Emulator &emu, const std::int64_t *args) {
+    return (std::int64_t)emu.allocate((std::size_t)args[0]);
+  }
+
+  static std::int64_t stringAdd(Emulator &emu, const std::int64_t *args) {
+    auto lhs = (const char *)args[0], rhs = (const char *)args[1];
+    return makeString(emu, std::string(lhs, length(args[0])) +
+                               std::string(rhs, length(args[1])));
+  }
+
+  // Unlike the interpreter, [right] is inclusive here.
+  static std::int64_t stringSubstring(Emulator &emu,
+                                      const std::int64_t *args) {
+    auto len = args[2] - args[1] + 1;
+    return makeString(emu, std::string((const char *)args[0] + args[1], len));
+  }
+
+  static std::int64_t stringOrd(Emulator &, const std::int64_t *args) {
+    return (std::int64_t) * ((const char *)args[0] + args[1]);
+  }
+
+  static std::int64_t stringParseInt(Emulator &, const std::int64_t *args) {
+    std::string str((const char *)args[0], length(args[0]));
+    return std::strtol(str.c_str(), nullptr, 10);
+  }
+
+  static int compare(const std::int64_t *args) {
+    std::string lhs((const char *)args[0], length(args[0]));
+    std::string rhs((const char *)args[1], length(args[1]));
+    return lhs.compare(rhs);
+  }
+
+  static std::int64_t stringEqual(Emulator &, const std::int64_t *args) {
+    return compare(args) == 0;
+  }
+
+  static std::int64_t stringInequal(Emulator &, const std::int64_t *args) {
+    return compare(args) != 0;
+  }
+
+  static std::int64_t stringLess(Emulator &, const std::int64_t *args) {
+    return compare(args) < 0;
+  }
+
+  static std::int64_t stringLessEqual(Emulator &, const std::int64_t *args) {
+    return compare(args) <= 0;
+  }
+
+  static std::int64_t stringCtor(Emulator &, const std::int64_t *args) {
+    std::memset((void *)args[0], 0, 8);
+    return 0;
+  }
+
+  // Skip to the first digit, remembering a minus sign on the way. Unlike the
+  // native one, this stops at the end of the input.
+  static std::int64_t getInt(Emulator &emu, const std::int64_t *) {
+    auto &in = *emu.in;
+    auto c = in.get();
+    bool neg = false;
+    while (c != EOF && (c < '0' || c > '9')) {
+      if (c == '-')
+        neg = true;
+      c = in.get();
+    }
+    std::int64_t num = 0;
+    while (c != EOF && c >= '0' && c <= '9') {
+      num = num * 10 + c - '0';
+      c = in.get();
+    }
+    return neg ? -num : num;
+  }
+
+  static std::int64_t print(Emulator &emu, const std::int64_t *args) {
+    emu.out->write((const char *)args[0], length(args[0]));
+    return 0;
+  }
+
+  static std::int64_t println(Emulator &emu, const std::int64_t *args) {
+    print(emu, args);
+    *emu.out << '\n';
+    return 0;
+  }
+
+  static std::int64_t printInt(Emulator &emu, const std::int64_t *args) {
+    *emu.out << args[0];
+    return 0;
+  }
+
+  static std::int64_t printlnInt(Emulator &emu, const std::int64_t *args) {
+    *emu.out << args[0] << '\n';
+    return 0;
+  }
+
+  static std::int64_t getString(Emulator &emu, const std::int64_t *) {
+    std::string str;
+    *emu.in >> str;
+    return makeString(emu, str.substr(0, 256));
+  }
+
+  static std::int64_t toString(Emulator &emu, const std::int64_t *args) {
+    return makeString(emu, std::to_string(args[0]));
+  }
+
+  static Builtin find(const std::string &name) {
+    static const std::unordered_map<std::string, Builtin> Table{
+        {"malloc", &alloc},
+        {"__alloc", &alloc},
+        {"__string__add", &stringAdd},
+        {"__string__substring", &stringSubstring},
+        {"__string__ord", &stringOrd},
+        {"__string__parseInt", &stringParseInt},
+        {"__string__equal", &stringEqual},
+        {"__string__inequal", &stringInequal},
+        {"__string__less", &stringLess},
+        {"__string__less_equal", &stringLessEqual},
+        {"__string___ctor_", &stringCtor},
+        {"getInt", &getInt},
+        {"print", &print},
+        {"println", &println},
+        {"_printInt", &printInt},
+        {"_printlnInt", &printlnInt},
+        {"getString", &getString},
+        {"toString", &toString}};
+    auto iter = Table.find(name);
+    return iter == Table.end() ? nullptr : iter->second;
+  }
+};
+
+Emulator::Emulator(const Module &module) : stack(new char[StackSize]) {
+  for (auto &kv : module.getSections()) {
+    if (kv.first != ".text")
+      layOut(kv.second);
+  }
+  decodeText(module.getSection(".text"));
+}
+
+void Emulator::layOut(const Section &section) {
+  std::size_t size = 0;
+  for (auto &line : section.getLines()) {
+    if (auto p = dyc<Db>(line.inst))
+      size += p->getData().size();
+    else if (auto p = dyc<Resb>(line.inst))
+      size += p->getSize();
+  }
+  sections.emplace_back(new char[size + 8]());
+  auto cur = sections.back().get();
+  for (auto &line : section.getLines()) {
+    if (!line.label.empty())
+      dataLabels[line.label] = (std::int64_t)cur;
+    if (auto p = dyc<Db>(line.inst)) {
+      std::memcpy(cur, p->getData().data(), p->getData().size());
+      cur += p->getData().size();
+    } else if (auto p = dyc<Resb>(line.inst)) {
+      cur += p->getSize();
+    }
+  }
+}
+
+// A local label, which starts with a dot, belongs to the last non-local label.
+void Emulator::decodeText(const Section &section) {
+  std::unordered_map<std::string, std::size_t> labels;
+  std::vector<std::pair<std::shared_ptr<Inst>, std::string>> text;
+  std::string func;
+  for (auto &line : section.getLines()) {
+    if (!line.label.empty()) {
+      if (line.label[0] != '.')
+        func = line.label;
+      auto label = line.label[0] == '.' ? func + line.label : line.label;
+      labels[label] = text.size();
+    }
+    if (line.inst && !dyc<Empty>(line.inst))
+      text.emplace_back(line.inst, func);
+  }
+  auto getTarget = [&labels](const std::string &label) {
+    auto iter = labels.find(label);
+    if (iter == labels.end())
+      throw std::runtime_error("undefined label: " + label);
+    return iter->second;
+  };
+  entry = getTarget("main");
+
+  for (auto &pair : text) {
+    auto &inst = pair.first;
+    Decoded res;
+    if (auto p = dyc<Mov>(inst)) {
+      res.dest = decodeOperand(p->getDest());
+      res.src = decodeOperand(p->getOperand());
+      res.op = p->getWidth() == 8
+                   ? Op::Mov
+                   : res.src.kind == Operand::Mem ? Op::LoadByte
+                                                  : Op::StoreByte;
+    } else if (auto p = dyc<Lea>(inst)) {
+      res.op = Op::Lea;
+      res.dest = decodeOperand(p->getDest());
+      res.src = decodeOperand(p->getAddr());
+    } else if (auto p = dyc<UnaryInst>(inst)) {
+      static const Op Ops[] = {Op::Neg, Op::Not, Op::Inc, Op::Dec};
+      res.op = Ops[p->getOp()];
+      res.dest = decodeOperand(p->getReg());
+    } else if (auto p = dyc<BinaryInst>(inst)) {
+      static const Op Ops[] = {Op::BitOr, Op::BitAnd, Op::Xor, Op::Add,
+                               Op::Sub,   Op::Mul,    Op::Sal, Op::Sar};
+      res.op = Ops[p->getType()];
+      res.dest = decodeOperand(p->getLhs());
+      res.src = decodeOperand(p->getRhs());
+    } else if (auto p = dyc<Cmp>(inst)) {
+      res.op = Op::Cmp;
+      res.dest = decodeOperand(p->getLhs());
+      res.src = decodeOperand(p->getRhs());
+    } else if (auto p = dyc<Set>(inst)) {
+      res.op = Op::Set;
+      res.cond = p->getOp();
+      res.dest = decodeOperand(p->getReg());
+    } else if (auto p = dyc<CJump>(inst)) {
+      res.op = Op::CJump;
+      res.cond = p->getOp();
+      res.target = getTarget(pair.second + p->getLabel()->getName());
+    } else if (auto p = dyc<Jmp>(inst)) {
+      res.op = Op::Jmp;
+      res.target = getTarget(pair.second + p->getLabel()->getName());
+    } else if (auto p = dyc<Call>(inst)) {
+      auto iter = labels.find(p->getFuncName());
+      if (iter != labels.end()) {
+        res.op = Op::Call;
+        res.target = iter->second;
+      } else if ((res.builtin = Builtins::find(p->getFuncName()))) {
+        res.op = Op::CallBuiltin;
+      } else {
+        throw std::runtime_error("undefined function: " + p->getFuncName());
+      }
+    } else if (dyc<Ret>(inst)) {
+      res.op = Op::Ret;
+    } else if (auto p = dyc<Push>(inst)) {
+      res.op = Op::Push;
+      res.src = decodeOperand(p->getReg());
+    } else if (auto p = dyc<Pop>(inst)) {
+      res.op = Op::Pop;
+      res.dest = decodeOperand(p->getReg());
+    } else if (dyc<Leave>(inst)) {
+      res.op = Op::Leave;
+    } else if (dyc<Cqo>(inst)) {
+      res.op = Op::Cqo;
+    } else if (auto p = dyc<IDiv>(inst)) {
+      res.op = Op::IDiv;
+      res.src = decodeOperand(p->getRhs());
+    } else {
+      throw std::runtime_error("unsupported instruction");
+    }
+    insts.emplace_back(res);
+  }
+}
+
+Emulator::Operand
+Emulator::decodeOperand(const std::shared_ptr<Addr> &addr) const {
+  Operand res;
+  if (auto p = dyc<NumericConstant>(addr)) {
+    res.kind = Operand::Imm;
+    res.val = p->getVal();
+  } else if (auto p = dyc<Register>(addr)) {
+    res.kind = Operand::Reg;
+    res.base = getRegIndex(p);
+  } else if (auto p = dyc<MemoryAddr>(addr)) {
+    res.kind = Operand::Mem;
+    res.base = p->getReg1() ? getRegIndex(p->getReg1()) : -1;
+    res.index = p->getReg2() ? getRegIndex(p->getReg2()) : -1;
+    res.scale = p->getScale();
+    res.val = p->getNumber();
+    res.spill = res.base == RBP && res.index == -1 && res.val < 0;
+  } else if (auto p = dyc<LabelAddr>(addr)) {
+    res.kind = Operand::Mem;
+    res.val = dataLabels.at(p->getLabelName());
+  } else if (auto p = dyc<Label>(addr)) {
+    res.kind = Operand::Imm;
+    res.val = dataLabels.at(p->getName());
+  } else {
+    throw std::runtime_error("unsupported operand");
+  }
+  return res;
+}
+
+std::int64_t Emulator::address(const Operand &operand) const {
+  assert(operand.kind == Operand::Mem);
+  auto res = operand.val;
+  if (operand.base != -1)
+    res += regs[operand.base];
+  if (operand.index != -1)
+    res += regs[operand.index] * operand.scale;
+  return res;
+}
+
+std::int64_t Emulator::read(const Operand &operand) {
+  switch (operand.kind) {
+  case Operand::Imm:
+    return operand.val;
+  case Operand::Reg:
+    return regs[operand.base];
+  case Operand::Mem:
+    ++stats.loads;
+    stats.spillLoads += operand.spill;
+    return load64(address(operand));
+  default:
+    assert(false);
+    return 0;
+  }
+}
+
+void Emulator::write(const Operand &operand, std::int64_t val) {
+  if (operand.kind == Operand::Reg) {
+    regs[operand.base] = val;
+    return;
+  }
+  assert(operand.kind == Operand::Mem);
+  ++stats.stores;
+  stats.spillStores += operand.spill;
+  std::memcpy((void *)address(operand), &val, 8);
+}
+
+void Emulator::push(std::int64_t val) {
+  // Leave some room for the frame below, which is not checked.
+  if (regs[RSP] - (std::int64_t)stack.get() < 64 * 1024)
+    throw std::runtime_error("stack overflow");
+  regs[RSP] -= 8;
+  ++stats.stores;
+  std::memcpy((void *)regs[RSP], &val, 8);
+}
+
+std::int64_t Emulator::pop() {
+  ++stats.loads;
+  auto res = load64(regs[RSP]);
+  regs[RSP] += 8;
+  return res;
+}
+
+char *Emulator::allocate(std::size_t size) {
+  heap.emplace_back(new char[size == 0 ? 1 : size]());
+  return heap.back().get();
+}
+
+std::int64_t Emulator::run() {
+  regs[RSP] = ((std::int64_t)stack.get() + StackSize) & ~(std::int64_t)15;
+  push(ReturnFromMain);
+  std::size_t pc = entry;
+  auto condition = [this](int cond) {
+    // The conditions of Set and CJump are in the same order.
+    switch (cond) {
+    case Set::Eq:
+      return flagLhs == flagRhs;
+    case Set::Ne:
+      return flagLhs != flagRhs;
+    case Set::Lt:
+      return flagLhs < flagRhs;
+    case Set::Le:
+      return flagLhs <= flagRhs;
+    case Set::Gt:
+      return flagLhs > flagRhs;
+    case Set::Ge:
+      return flagLhs >= flagRhs;
+    default:
+      assert(false);
+      return false;
+    }
+  };
+
+  while (true) {
+    auto &inst = insts[pc++];
+    ++stats.insts;
+    switch (inst.op) {
+    case Op::Mov:
+      write(inst.dest, read(inst.src));
+      break;
+    case Op::LoadByte:
+      ++stats.loads;
+      stats.spillLoads += inst.src.spill;
+      write(inst.dest, *(const std::uint8_t *)address(inst.src));
+      break;
+    case Op::StoreByte:
+      ++stats.stores;
+      stats.spillStores += inst.dest.spill;
+      *(std::uint8_t *)address(inst.dest) = (std::uint8_t)read(inst.src);
+      break;
+    case Op::Lea:
+      write(inst.dest, address(inst.src));
+      break;
+    case Op::Neg:
+      write(inst.dest, -read(inst.dest));
+      break;
+    case Op::Not:
+      write(inst.dest, ~read(inst.dest));
+      break;
+    case Op::Inc:
+      write(inst.dest, read(inst.dest) + 1);
+      break;
+    case Op::Dec:
+      write(inst.dest, read(inst.dest) - 1);
+      break;
+#define MOCKER_EMULATOR_BINARY(NAME, EXPR)                                     \
+  case Op::NAME: {                                                             \
+    auto lhs = read(inst.dest), rhs = read(inst.src);                          \
+    write(inst.dest, (EXPR));                                                  \
+    break;                                                                     \
+  }
+      MOCKER_EMULATOR_BINARY(BitOr, lhs | rhs)
+      MOCKER_EMULATOR_BINARY(BitAnd, lhs & rhs)
+      MOCKER_EMULATOR_BINARY(Xor, lhs ^ rhs)
+      MOCKER_EMULATOR_BINARY(Add, (std::int64_t)((std::uint64_t)lhs + rhs))
+      MOCKER_EMULATOR_BINARY(Sub, (std::int64_t)((std::uint64_t)lhs - rhs))
+      MOCKER_EMULATOR_BINARY(Mul, (std::int64_t)((std::uint64_t)lhs * rhs))
+      MOCKER_EMULATOR_BINARY(Sal, (std::int64_t)((std::uint64_t)lhs
+                                                 << (rhs & 63)))
+      MOCKER_EMULATOR_BINARY(Sar, lhs >> (rhs & 63))
+#undef MOCKER_EMULATOR_BINARY
+    case Op::Cmp:
+      flagLhs = read(inst.dest);
+      flagRhs = read(inst.src);
+      break;
+    case Op::Set:
+      regs[RAX] = (regs[RAX] & ~(std::int64_t)0xff) | condition(inst.cond);
+      break;
+    case Op::Jmp:
+      pc = inst.target;
+      break;
+    case Op::CJump:
+      if (condition(inst.cond))
+        pc = inst.target;
+      break;
+    case Op::Call:
+      ++stats.calls;
+      push((std::int64_t)pc);
+      pc = inst.target;
+      break;
+    case Op::CallBuiltin: {
+      ++stats.calls;
+      ++stats.builtinCalls;
+      std::int64_t args[] = {regs[RDI], regs[RSI], regs[RDX]};
+      regs[RAX] = inst.builtin(*this, args);
+      break;
+    }
+    case Op::Ret: {
+      auto addr = pop();
+      if (addr == ReturnFromMain)
+        return regs[RAX];
+      pc = (std::size_t)addr;
+      break;
+    }
+    case Op::Push:
+      push(read(inst.src));
+      break;
+    case Op::Pop:
+      write(inst.dest, pop());
+      break;
+    case Op::Leave:
+      regs[RSP] = regs[RBP];
+      regs[RBP] = pop();
+      break;
+    case Op::Cqo: // cdq
+      regs[RDX] = (std::int32_t)regs[RAX] < 0 ? 0xffffffff : 0;
+      break;
+    case Op::IDiv: { // idiv r32, which zero-extends the results
+      auto dividend = (std::int64_t)(((std::uint64_t)regs[RDX] << 32) |
+                                     (std::uint32_t)regs[RAX]);
+      auto divisor = (std::int64_t)(std::int32_t)read(inst.src);
+      if (divisor == 0)
+        throw std::runtime_error("division by zero");
+      if (divisor == -1 && dividend == INT64_MIN)
+        throw std::runtime_error("division overflow");
+      auto quotient = dividend / divisor;
+      if (quotient != (std::int32_t)quotient)
+        throw std::runtime_error("division overflow");
+      regs[RAX] = (std::uint32_t)quotient;
+      regs[RDX] = (std::uint32_t)(dividend % divisor);
+      break;
+    }
+    default:
+      assert(false);
+    }
+  }
+}
+
+} // namespace nasm
+} // namespace mocker
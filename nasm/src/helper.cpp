@@ -186,7 +186,8 @@ std::shared_ptr<Inst> replaceRegs(const std::shared_ptr<Inst> &inst,
     return inst;
   if (auto p = dyc<Mov>(inst)) {
     return std::make_shared<Mov>(replaceRegs(p->getDest(), mp),
-                                 replaceRegs(p->getOperand(), mp));
+                                 replaceRegs(p->getOperand(), mp),
+                                 p->getWidth());
   }
   if (auto p = dyc<Lea>(inst)) {
     return std::make_shared<Lea>(dyc<Register>(replaceRegs(p->getDest(), mp)),
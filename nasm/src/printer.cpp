@@ -53,6 +53,25 @@ std::string fmtAddr(const std::shared_ptr<Addr> &addr) {
   assert(false);
 }
 
+namespace {
+
+// The lowest byte of a constant or a physical register. A virtual register is
+// printed as it is.
+std::string fmtLowByte(const std::shared_ptr<Addr> &addr) {
+  static const RegMap<std::string> name{
+      {rax(), "al"},   {rcx(), "cl"},   {rdx(), "dl"},   {rbx(), "bl"},
+      {rsp(), "spl"},  {rbp(), "bpl"},  {rsi(), "sil"},  {rdi(), "dil"},
+      {r8(), "r8b"},   {r9(), "r9b"},   {r10(), "r10b"}, {r11(), "r11b"},
+      {r12(), "r12b"}, {r13(), "r13b"}, {r14(), "r14b"}, {r15(), "r15b"},
+  };
+  if (auto p = dyc<NumericConstant>(addr))
+    return std::to_string((std::uint8_t)p->getVal());
+  auto iter = name.find(dyc<Register>(addr));
+  return iter == name.end() ? fmtAddr(addr) : iter->second;
+}
+
+} // namespace
+
 std::string fmtInst(const std::shared_ptr<Inst> &inst) {
   using namespace std::string_literals;
 
@@ -68,6 +87,14 @@ std::string fmtInst(const std::shared_ptr<Inst> &inst) {
     return "resb " + std::to_string(p->getSize());
   }
   if (auto p = dyc<Mov>(inst)) {
+    if (p->getWidth() == 1) {
+      if (dyc<EffectiveAddr>(p->getOperand()))
+        return "movzx " + fmtAddr(p->getDest()) + ", byte " +
+               fmtAddr(p->getOperand());
+      assert(dyc<EffectiveAddr>(p->getDest()));
+      return "mov byte " + fmtAddr(p->getDest()) + ", " +
+             fmtLowByte(p->getOperand());
+    }
     std::string res = "mov ";
     if (dyc<EffectiveAddr>(p->getDest()))
       res += "qword ";
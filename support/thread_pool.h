@@ -0,0 +1,168 @@
+#ifndef MOCKER_THREAD_POOL_H
+#define MOCKER_THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mocker {
+
+// A fixed set of threads running the tasks of one parallelFor at a time. Each
+// thread owns a deque of tasks, takes from its back and, once it is empty,
+// steals from the front of the others.
+class ThreadPool {
+public:
+  // [numThreads] includes the thread calling parallelFor.
+  explicit ThreadPool(std::size_t numThreads) {
+    numThreads = numThreads == 0 ? 1 : numThreads;
+    for (std::size_t i = 0; i < numThreads; ++i)
+      queues.emplace_back(new Queue);
+    for (std::size_t i = 1; i < numThreads; ++i)
+      workers.emplace_back([this, i] { workerLoop(i); });
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  std::size_t size() const { return queues.size(); }
+
+  // Run task(i) for each i in [0, n) and return once all of them have
+  // finished. The first exception thrown by a task is rethrown here.
+  void parallelFor(std::size_t n,
+                   const std::function<void(std::size_t)> &task) {
+    if (n == 0)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      remaining = n;
+      error = nullptr;
+    }
+    // Contiguous ranges, so that a thread works on neighbours unless it steals.
+    for (std::size_t i = 0; i < size(); ++i) {
+      auto &queue = *queues[i];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      for (auto k = n * i / size(); k < n * (i + 1) / size(); ++k)
+        queue.tasks.emplace_back(&task, k);
+    }
+    // Only now, or a worker waking up in between could find no task and go
+    // back to sleep for the whole generation.
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++generation;
+    }
+    wakeUp.notify_all();
+
+    while (runOne(0))
+      ;
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return remaining == 0; });
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+private:
+  using Body = std::function<void(std::size_t)>;
+  using Task = std::pair<const Body *, std::size_t>;
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool take(std::size_t self, Task &task) {
+    for (std::size_t k = 0; k < size(); ++k) {
+      auto &queue = *queues[(self + k) % size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty())
+        continue;
+      if (k == 0) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+      } else {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool runOne(std::size_t self) {
+    Task task;
+    if (!take(self, task))
+      return false;
+    std::exception_ptr thrown;
+    try {
+      (*task.first)(task.second);
+    } catch (...) {
+      thrown = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (thrown && !error)
+      error = thrown;
+    if (--remaining == 0)
+      finished.notify_all();
+    return true;
+  }
+
+  void workerLoop(std::size_t self) {
+    std::size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeUp.wait(lock,
+                    [this, seen] { return stopping || generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+      }
+      while (runOne(self))
+        ;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wakeUp, finished;
+  std::size_t generation = 0, remaining = 0;
+  std::exception_ptr error;
+  bool stopping = false;
+};
+
+// Parse the value of a -j<n> option into [numThreads]. A missing value means
+// one thread per core. Return false if [value] is not a positive number.
+inline bool parseNumThreads(const std::string &value, std::size_t &numThreads) {
+  if (value.empty()) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+    return true;
+  }
+  if (value.size() > 9 ||
+      !std::all_of(value.begin(), value.end(),
+                   [](char ch) { return ch >= '0' && ch <= '9'; }))
+    return false;
+  numThreads = std::stoul(value);
+  return numThreads > 0;
+}
+
+} // namespace mocker
+
+#endif // MOCKER_THREAD_POOL_H